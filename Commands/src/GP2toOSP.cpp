@@ -6,13 +6,14 @@
  *<p>Options are:
  *	- -D TODATE or --todate=TODATE : To date (dd/mm/aaaa). Default value TODATE = 31/12/2020
  *	- -d FROMDATE or --fromdate=FROMDATE : From date (dd/mm/aaaa). Default value FROMDATE = 01/01/2014
- *	- -i INFILE or --infile=INFILE : GP2 input file. Default value INFILE = SLCLog.GP2
+ *	- -i INFILE or --infile=INFILE : GP2 input file (plain or gzip compressed). Default value INFILE = SLCLog.GP2
  *	- -h or --help : Show usage data and stops. Default value HELP=FALSE
  *	- -l LOGLEVEL or --llevel=LOGLEVEL : Maximum level to log (SEVERE, WARNING, INFO, CONFIG, FINE, FINER, FINEST). Default value LOGLEVEL = INFO
- *	- -o OUTFILE or --outfile=OUTFILE : OSP binary output file. Default value OUTFILE = DATA.OSP
+ *	- -o OUTFILE or --outfile=OUTFILE : OSP binary output file ("-" for stdout). Default value OUTFILE = DATA.OSP
  *	- -T TOTIME or --totime=TOTIME : To time (hh:mm:sec). Default value TOTIME = 23:59:59
  *	- -t FROMTIME or --fromtime=FROMTIME : From time (hh:mm:sec). Default value FROMTIME = 00:00:00
  *	- -w WMSG or --wmsg=WMSG : Wanted messages MIDs (a comma separated list, ALL, RINEX,  or RINEX,list. Default value WMSG = RINEX
+ *	- -x or --container : Write the OSP file in the container format, with line time tags and block checksums. Default value CONTAINER=FALSE
  *<p>
  *Copyright 2015 Francisco Cancillo
  *<p>
@@ -30,10 +31,14 @@
 
 #include <string.h>
 #include <time.h>
+#include <zlib.h>
 
 //from CommonClasses
 #include "ArgParser.h"
 #include "Logger.h"
+#include "OSPContainer.h"
+#include "Utilities.h"
+#include "GPSCalendar.h"
 
 using namespace std;
 
@@ -43,13 +48,14 @@ const string CMDLINE = "GP2toOSP.exe {options}";
 ///The parser object to store options and operators passed in the comman line
 ArgParser parser;
 //Metavariables for options
-int INFILE, OUTFILE, HELP, LOGLEVEL, FROMDATE, TODATE, FROMTIME, TOTIME, WMSG;
+int INFILE, OUTFILE, HELP, LOGLEVEL, FROMDATE, TODATE, FROMTIME, TOTIME, WMSG, CONTAINER;
 //Metavariables for operators
 //n/a
 //Constrants used in this program
 #define MSGSIZE 2050		//2048 (max payload size) + 2 (payload len)
 #define WMSGSIZE 100		//the wanted message list maximum size
 #define GP2SIZE 34 + MSGSIZE*3 + 12 + 1 + 1	//time tag chars + masg chars + (checksum + tail) + lf + null
+#define GP2BUFSIZE 131072	//the size of the buffer used to read (and decompress) the GP2 input file
 #define START1 160	//0xA0	//OSP messages from/to receiver are preceded by the synchro
 #define START2 162	//0xA2	//sequence of two bytes with values START1, START2
 #define END1 176	//0XB0	//OSP messages from/to receiver are followed by the end
@@ -61,7 +67,7 @@ int OSPmsgSize = 0;				//current message size
 //the list of OSP messages usefull to obtain RINEX data
 unsigned char WANTEDMsg[WMSGSIZE] = {2,6,7,56,8,11,12,15,28,50,64,75,0};
 //prototipes of functions defined in this module
-int extractMsgs(Logger*, FILE *, time_t, time_t, FILE *);
+int extractMsgs(Logger*, gzFile, time_t, time_t, OSPWriter*);
 bool wantedMsg(unsigned char);
 time_t dt2time (string);
 bool checkInterval(string, time_t, time_t);
@@ -91,6 +97,8 @@ void addWANTED(string);
  *<p>
  * The binary OSP output files contain messages where head, check and tail have been removed, that is, the data for each
  * message consists of the two bytes of the payload length and the payload bytes.
+ * Optionally, the output file can be written in the container format (see OSPWriter), where the time tag of each line
+ * is kept as the message host time, and data are grouped in blocks with checksums.
  *<p>
  * Input data are processed according to the following criteria:
  * - Lines with incorrect message format are skipped. To be correct, a message shall start with A0A2, end with B0B3, its length shall match
@@ -115,13 +123,14 @@ int main(int argc, char* argv[]) {
 	Logger log("LogFile.txt");		//the error logger object
 	log.setPrgName(argv[0]);
 	/// 2- Setups the valid options in the command line. They will be used by the argument/option parser
+	CONTAINER = parser.addOption("-x", "--container", "CONTAINER", "Write the OSP file in the container format, with line time tags and block checksums", false);
 	WMSG = parser.addOption("-w", "--wmsg", "WMSG", "Wanted mesages MIDs (a comma separated list, ALL, RINEX,  or RINEX,list", "RINEX");
 	FROMTIME = parser.addOption("-t", "--fromtime", "FROMTIME", "From time (hh:mm:sec)", "00:00:00");
 	TOTIME = parser.addOption("-T", "--totime", "TOTIME", "To time (hh:mm:sec)", "23:59:59");
-	OUTFILE = parser.addOption("-o", "--outfile", "OUTFILE", "OSP binary output file", "DATA.OSP");
+	OUTFILE = parser.addOption("-o", "--outfile", "OUTFILE", "OSP binary output file (- for stdout)", "DATA.OSP");
 	LOGLEVEL = parser.addOption("-l", "--llevel", "LOGLEVEL", "Maximum level to log (SEVERE, WARNING, INFO, CONFIG, FINE, FINER, FINEST)", "INFO");
 	HELP = parser.addOption("-h", "--help", "HELP", "Show usage data and stops", false);
-	INFILE = parser.addOption("-i", "--infile", "INFILE", "GP2 input file", "SLCLog.GP2");
+	INFILE = parser.addOption("-i", "--infile", "INFILE", "GP2 input file (plain or gzip compressed)", "SLCLog.GP2");
 	FROMDATE = parser.addOption("-d", "--fromdate", "FROMDATE", "From date (dd/mm/aaaa)", "01/01/2014");
 	TODATE = parser.addOption("-D", "--todate", "TODATE", "To date (dd/mm/aaaa)", "31/12/2020");
 	/// 3- Parses arguments in the command line extracting options and operators
@@ -166,23 +175,26 @@ int main(int argc, char* argv[]) {
 		log.severe("Incorrect From or To date or time option");
 		return 1;
 	}
-	FILE *inFile;
-	/// 7- Opens the SP2 input file
-	if ((inFile = fopen(parser.getStrOpt(INFILE).c_str(), "r")) == NULL) {
+	gzFile inFile;
+	/// 7- Opens the SP2 input file. If it is gzip compressed, it will be decompressed while read
+	if ((inFile = gzopen(parser.getStrOpt(INFILE).c_str(), "rb")) == NULL) {
 		log.severe("Cannot open input file" + parser.getStrOpt(INFILE));
 		return 2;
 	}
+	gzbuffer(inFile, GP2BUFSIZE);
 	/// 8- Creates the OSP binary output file
 	FILE *outFile;
-	if ((outFile = fopen(parser.getStrOpt(OUTFILE).c_str(), "wb")) == NULL) {
+	if ((outFile = openBinaryFile(parser.getStrOpt(OUTFILE), true)) == NULL) {
 		log.severe("Cannot create output file" + parser.getStrOpt(OUTFILE));
 		return 3;
 	}
 	/// 9- Extracts/verifies/filters line by line messages from the SP2 file and translate/write them into OSP format
-	int n = extractMsgs(&log, inFile, startTime, endTime, outFile);
+	OSPWriter writer(outFile, parser.getBoolOpt(CONTAINER));
+	int n = extractMsgs(&log, inFile, startTime, endTime, &writer);
+	if (!writer.flush()) log.severe("Cannot writte to binary output file");
 	log.info("End of data extraction. Messages extracted: " + to_string((long long) n));
-	fclose(inFile);
-	fclose(outFile);
+	gzclose(inFile);
+	closeBinaryFile(outFile);
 	return 0;
 }
 //@cond DUMMY
@@ -192,13 +204,13 @@ int main(int argc, char* argv[]) {
  * Only messages having a "wanted" MID are extracted.
  *
  * @param plog a pointer to the error logger
- * @param inFile the gp2 input file with GPS receiver messages
+ * @param inFile the gp2 input file with GPS receiver messages (plain or gzip compressed)
  * @param fromT defines the start of the time interval for messages to be extracted
  * @param toT defines the end of the time interval
- * @param outFile the output OSP file to place binary messages
+ * @param writer the writer of binary messages to the output OSP file
  * @return the number of OSP messages extracted
  */
-int extractMsgs(Logger* plog, FILE *inFile, time_t fromT, time_t toT, FILE *outFile) {
+int extractMsgs(Logger* plog, gzFile inFile, time_t fromT, time_t toT, OSPWriter* writer) {
 	int nbytesRead;
 	char *header, *tail;
 	unsigned int ui, payloadLen, computedCheck, messageCheck;
@@ -206,7 +218,7 @@ int extractMsgs(Logger* plog, FILE *inFile, time_t fromT, time_t toT, FILE *outF
 	int nMessages = 0;
 
 	//read input file line by line: each line shall be an OSP message
-	while (fgets(GP2line, GP2SIZE, inFile) != NULL) {
+	while (gzgets(inFile, GP2line, GP2SIZE) != NULL) {
 		timeTag = string(GP2line, 23);
 		//check if line time tag is in the wanted time interval
 		if (!checkInterval(GP2line, fromT, toT)) {
@@ -255,8 +267,9 @@ int extractMsgs(Logger* plog, FILE *inFile, time_t fromT, time_t toT, FILE *outF
 		//check if message MID is in the list of wanted ones
 		if (wantedMsg(OSPmsg[2])) {
 			//printf("wt|");
-			//wanted, write it to the OSP output file
-			if (fwrite(OSPmsg, 1, payloadLen+2, outFile) == payloadLen+2) nMessages++;
+			//wanted, write it to the OSP output file, with the time tag (in milliseconds) as host time
+			long long hostTime = (long long) dt2time(timeTag) * 1000 + atoi(GP2line + 20);
+			if (writer->write(OSPmsg + 2, payloadLen, hostTime)) nMessages++;
 			else {
 				plog->severe("Cannot writte to binary output file");
 				return -nMessages - 4;
@@ -284,25 +297,16 @@ bool wantedMsg(unsigned char mid) {
 
 /**dt2time
  * converts date and time from the input line time tag string to a time_t value.
+ * The date and time are taken as UTC, as host times written by RXtoOSP, without using the time zone or
+ * daylight saving time of the computer (see GPSCalendar::unixSeconds).
  *
  *@param dateAndTime a string having format dd/mm/yyyy hh:mm:ss
  *@return the given time as a time_t value, or -1 if date or time cannot be converted
  **/
 time_t dt2time (string dateAndTime) {
 	int a, b, c, d, e, f;
-	struct tm *timeinfo;
-	time_t rawtime;
-	time(&rawtime);
-	timeinfo = localtime(&rawtime);
-	if (sscanf(dateAndTime.c_str(), "%d/%d/%d %d:%d:%d", &a, &b, &c, &d, &e, &f) == 6) {
-		timeinfo->tm_mday = a;
-		timeinfo->tm_mon = b - 1;
-		timeinfo->tm_year = c - 1900;
-		timeinfo->tm_hour = d;
-		timeinfo->tm_min = e;
-		timeinfo->tm_sec = f;
-		return mktime(timeinfo);
-	}
+	if (sscanf(dateAndTime.c_str(), "%d/%d/%d %d:%d:%d", &a, &b, &c, &d, &e, &f) == 6 && b >= 1 && b <= 12 && c >= 1970)
+		return (time_t) GPSCalendar::unixSeconds(c, b, a, d, e, f);
 	return -1;	//wrong date or time
 }
 /**checkInterval
@@ -0,0 +1,155 @@
+/** @file OSPCheck.cpp
+ * Contains the command line program to check an OSP binary data file for damaged data, and to repair it.
+ *<p>
+ *Usage:
+ *<p>OSPCheck.exe {options} [OSPfileName]
+ *<p>Options are:
+ *	- -h or --help : Show usage data. Default value HELP=FALSE
+ *	- -l LOGLEVEL or --llevel=LOGLEVEL : Maximum level to log (SEVERE, WARNING, INFO, CONFIG, FINE, FINER, FINEST). Default value LOGLEVEL = INFO
+ *	- -r REPAIRED or --repaired=REPAIRED : Repaired OSP output file (none if empty). Default value REPAIRED =
+ *	- -t THREADS or --threads=THREADS : Number of threads to scan the file (0 for as many as hardware threads). Default value THREADS = 0
+ *Default values for operators are: DATA.OSP
+ *<p>
+ *Copyright 2015 Francisco Cancillo
+ *<p>
+ *This file is part of the RXtoRINEX tool.
+ *<p>
+ *RXtoRINEX is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *RXtoRINEX is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ *warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *See the GNU General Public License for more details.
+ *A copy of the GNU General Public License can be found at <http://www.gnu.org/licenses/>.
+ *
+ *V1.0	First release
+ */
+
+//from CommonClasses
+#include "ArgParser.h"
+#include "Logger.h"
+#include "OSPSource.h"
+#include "OSPValidator.h"
+#include "Utilities.h"
+
+using namespace std;
+
+///The command line format
+const string CMDLINE = "OSPCheck.exe {options} [OSPfileName]";
+///The parser object to store options and operators passed in the command line
+ArgParser parser;
+//@cond DUMMY
+//Metavariables for options
+int HELP, LOGLEVEL, REPAIRED, THREADS;	//the metavariables for the command line options
+//Metavariables for operators
+int OSPF;		//metavariables for the command line operands
+//@endcond
+
+/**main
+ * gets the command line arguments, set parameters accordingly and checks the given OSP file for damaged data.
+ * A damaged area is a sequence of bytes not belonging to any plausible message: messages with a payload length
+ * out of range or exceeding the file end, MID zero, or a length not matching the one expected for the MID
+ * (for MIDs 2, 7, 8, 15, 19 and 28). After a damaged area, checking is resynchronized on the next plausible message.
+ *<p>
+ * The damage report is printed to the standard output, with a line for each damaged area containing its offset in the file,
+ * its length in bytes, and the kind of damage found.
+ * If a repaired file name is given, a copy of the OSP file without the damaged areas is written to it.
+ *<p>
+ * The file is scanned in chunks using several threads, to check large files at disk speed.
+ *
+ *@param argc the number of arguments passed from the command line
+ *@param argv the array of arguments passed from the command line
+ *@return  the exit status according to the following values and meaning::
+ *		- (0) no errors have been detected and the file has no damaged data
+ *		- (1) an error has been detected in arguments
+ *		- (2) error when opening the input file
+ *		- (3) error when creating or writing the repaired file
+ *		- (4) the file has damaged data
+ */
+int main(int argc, char* argv[]) {
+	/**The main process sequence follows:*/
+	/// 1- Defines and sets the error logger object
+	Logger log("LogFile.txt");
+	log.setPrgName(argv[0]);
+	/// 2- Setups the valid options in the command line. They will be used by the argument/option parser
+	THREADS = parser.addOption("-t", "--threads", "THREADS", "Number of threads to scan the file (0 for as many as hardware threads)", "0");
+	REPAIRED = parser.addOption("-r", "--repaired", "REPAIRED", "Repaired OSP output file (none if empty)", "");
+	LOGLEVEL = parser.addOption("-l", "--llevel", "LOGLEVEL", "Maximum level to log (SEVERE, WARNING, INFO, CONFIG, FINE, FINER, FINEST)", "INFO");
+	HELP = parser.addOption("-h", "--help", "HELP", "Show usage data", false);
+	/// 3- Setups the default values for operators in the command line
+	OSPF = parser.addOperator("DATA.OSP");
+	/// 4- Parses arguments in the command line extracting options and operators
+	try {
+		parser.parseArgs(argc, argv);
+	}  catch (string error) {
+		parser.usage("Argument error: " + error, CMDLINE);
+		log.severe(error);
+		return 1;
+	}
+	log.info(parser.showOptValues());
+	log.info(parser.showOpeValues());
+	if (parser.getBoolOpt(HELP)) {	//help info has been requested
+		parser.usage("Checks a OSP binary data file for damaged data, and writes a repaired copy", CMDLINE);
+		return 0;
+	}
+	/// 5- Sets logging level stated in option
+	string s = parser.getStrOpt (LOGLEVEL);
+	if (s.compare("SEVERE") == 0) log.setLevel(SEVERE);
+	else if (s.compare("WARNING") == 0) log.setLevel(WARNING);
+	else if (s.compare("INFO") == 0) log.setLevel(INFO);
+	else if (s.compare("CONFIG") == 0) log.setLevel(CONFIG);
+	else if (s.compare("FINE") == 0) log.setLevel(FINE);
+	else if (s.compare("FINER") == 0) log.setLevel(FINER);
+	else if (s.compare("FINEST") == 0) log.setLevel(FINEST);
+	int nThreads;
+	try {
+		nThreads = stoi(parser.getStrOpt(THREADS));
+	} catch (...) {
+		nThreads = -1;
+	}
+	if (nThreads < 0) {
+		log.severe("Incorrect number of threads " + parser.getStrOpt(THREADS));
+		return 1;
+	}
+	/// 6- Opens the OSP binary file mapping it into memory
+	OSPMappedSource source;
+	string fileName = parser.getOperator (OSPF);
+	if (!source.open(fileName)) {
+		log.severe("Cannot open file " + fileName);
+		return 2;
+	}
+	if (source.isGzipped()) {
+		log.severe("Compressed files cannot be checked: " + fileName);
+		return 2;
+	}
+	if (source.isContainer()) {
+		log.severe("Container files have their own block checksums and cannot be checked: " + fileName);
+		return 2;
+	}
+	/// 7- Scans the file for damaged areas and prints them
+	OSPValidator validator;
+	validator.scan(source.fileData(), source.fileSize(), (unsigned int) nThreads);
+	const vector<OSPDamage>& damages = validator.getDamages();
+	for (unsigned int i=0; i<damages.size(); i++)
+		printf("Offset:%lld;Ln:%lld;%s\n", damages[i].offset, damages[i].length, OSPValidator::damageName(damages[i].type).c_str());
+	log.info("Messages found: " + to_string((long long) validator.messages()));
+	if (!damages.empty())
+		log.warning("Damaged areas found: " + to_string((long long) damages.size()) +
+					". Bytes damaged: " + to_string(validator.damagedBytes()));
+	/// 8- Writes the repaired file, if requested
+	string repairedName = parser.getStrOpt(REPAIRED);
+	if (!repairedName.empty()) {
+		FILE* outFile;
+		if ((outFile = openBinaryFile(repairedName, true)) == NULL) {
+			log.severe("Cannot create file " + repairedName);
+			return 3;
+		}
+		bool written = validator.writeRepaired(outFile);
+		closeBinaryFile(outFile);
+		if (!written) {
+			log.severe("Cannot write file " + repairedName);
+			return 3;
+		}
+		log.info("Repaired file written: " + repairedName);
+	}
+	return damages.empty()? 0: 4;
+}
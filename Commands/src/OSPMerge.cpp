@@ -0,0 +1,133 @@
+/** @file OSPMerge.cpp
+ * Contains the command line program to merge chronologically several OSP data files into a single one.
+ *<p>
+ *Usage:
+ *<p>OSPMerge.exe {options} [OSPfileNames]
+ *<p>Options are:
+ *	- -h or --help : Show usage data. Default value HELP=FALSE
+ *	- -l LOGLEVEL or --llevel=LOGLEVEL : Maximum level to log (SEVERE, WARNING, INFO, CONFIG, FINE, FINER, FINEST). Default value LOGLEVEL = INFO
+ *	- -o MERGED or --output=MERGED : Merged OSP output file ("-" for the standard output). Default value MERGED = MERGED.OSP
+ *Default values for operators are: DATA.OSP
+ *<p>OSPfileNames is a comma separated list of the OSP files to merge (f.e. the ones generated by RXtoOSP in several sessions).
+ *<p>
+ *Copyright 2015 Francisco Cancillo
+ *<p>
+ *This file is part of the RXtoRINEX tool.
+ *<p>
+ *RXtoRINEX is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *RXtoRINEX is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ *warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *See the GNU General Public License for more details.
+ *A copy of the GNU General Public License can be found at <http://www.gnu.org/licenses/>.
+ *
+ *V1.0	First release
+ */
+
+//from CommonClasses
+#include "ArgParser.h"
+#include "Logger.h"
+#include "OSPMessage.h"
+#include "OSPMergeSource.h"
+#include "Utilities.h"
+
+using namespace std;
+
+///The command line format
+const string CMDLINE = "OSPMerge.exe {options} [OSPfileNames]";
+///The parser object to store options and operators passed in the command line
+ArgParser parser;
+//@cond DUMMY
+//Metavariables for options
+int HELP, LOGLEVEL, MERGED;	//the metavariables for the command line options
+//Metavariables for operators
+int OSPF;		//metavariables for the command line operands
+//@endcond
+
+/**main
+ * gets the command line arguments, set parameters accordingly and merges the given OSP files into a single one.
+ * Messages are merged epoch by epoch in GPS time order, using the time in the MID7 message ending each epoch.
+ * Epochs having a time not later than the last one written (duplicated in overlapping files) are dropped,
+ * as well as the messages after the last MID7 in each file.
+ * Files are read sequentially, keeping in memory only the next epoch of each one.
+ *
+ *@param argc the number of arguments passed from the command line
+ *@param argv the array of arguments passed from the command line
+ *@return  the exit status according to the following values and meaning::
+ *		- (0) no errors have been detected
+ *		- (1) an error has been detected in arguments
+ *		- (2) error when opening an input file
+ *		- (3) error when creating or writing the output file
+ */
+int main(int argc, char* argv[]) {
+	/**The main process sequence follows:*/
+	/// 1- Defines and sets the error logger object
+	Logger log("LogFile.txt");
+	log.setPrgName(argv[0]);
+	/// 2- Setups the valid options in the command line. They will be used by the argument/option parser
+	MERGED = parser.addOption("-o", "--output", "MERGED", "Merged OSP output file (\"-\" for the standard output)", "MERGED.OSP");
+	LOGLEVEL = parser.addOption("-l", "--llevel", "LOGLEVEL", "Maximum level to log (SEVERE, WARNING, INFO, CONFIG, FINE, FINER, FINEST)", "INFO");
+	HELP = parser.addOption("-h", "--help", "HELP", "Show usage data", false);
+	/// 3- Setups the default values for operators in the command line
+	OSPF = parser.addOperator("DATA.OSP");
+	/// 4- Parses arguments in the command line extracting options and operators
+	try {
+		parser.parseArgs(argc, argv);
+	}  catch (string error) {
+		parser.usage("Argument error: " + error, CMDLINE);
+		log.severe(error);
+		return 1;
+	}
+	log.info(parser.showOptValues());
+	log.info(parser.showOpeValues());
+	if (parser.getBoolOpt(HELP)) {	//help info has been requested
+		parser.usage("Merges chronologically the OSP binary data files given as a comma separated list", CMDLINE);
+		return 0;
+	}
+	/// 5- Sets logging level stated in option
+	string s = parser.getStrOpt (LOGLEVEL);
+	if (s.compare("SEVERE") == 0) log.setLevel(SEVERE);
+	else if (s.compare("WARNING") == 0) log.setLevel(WARNING);
+	else if (s.compare("INFO") == 0) log.setLevel(INFO);
+	else if (s.compare("CONFIG") == 0) log.setLevel(CONFIG);
+	else if (s.compare("FINE") == 0) log.setLevel(FINE);
+	else if (s.compare("FINER") == 0) log.setLevel(FINER);
+	else if (s.compare("FINEST") == 0) log.setLevel(FINEST);
+	/// 6- Opens the OSP files to merge
+	OSPMergeSource source;
+	vector<string> fileNames = getTokens(parser.getOperator(OSPF), ',');
+	for (unsigned int i=0; i<fileNames.size(); i++) {
+		if (!source.addFile(fileNames[i])) {
+			log.severe("Cannot open file " + fileNames[i]);
+			return 2;
+		}
+	}
+	/// 7- Creates the output file
+	string outName = parser.getStrOpt(MERGED);
+	FILE* outFile;
+	if ((outFile = openBinaryFile(outName, true)) == NULL) {
+		log.severe("Cannot create file " + outName);
+		return 3;
+	}
+	/// 8- Writes the merged messages
+	OSPMessage message;
+	unsigned int nMessages = 0;
+	bool written = true;
+	while (written && source.fill(message)) {
+		unsigned int length = message.payloadLen();
+		unsigned char lengthBytes[2] = {(unsigned char) (length >> 8), (unsigned char) (length & 0xFF)};
+		written = fwrite(lengthBytes, 1, 2, outFile) == 2 && fwrite(message.payloadData(), 1, length, outFile) == length;
+		nMessages++;
+	}
+	closeBinaryFile(outFile);
+	if (!written) {
+		log.severe("Cannot write file " + outName);
+		return 3;
+	}
+	log.info("Messages written: " + to_string((long long) nMessages));
+	if (source.getDroppedEpochs() > 0)
+		log.warning("Duplicated or out of order epochs dropped: " + to_string((long long) source.getDroppedEpochs()));
+	if (source.getDroppedMessages() > 0)
+		log.warning("Messages dropped after the last epoch in files: " + to_string((long long) source.getDroppedMessages()));
+	return 0;
+}
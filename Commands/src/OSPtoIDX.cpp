@@ -0,0 +1,116 @@
+/** @file OSPtoIDX.cpp
+ * Contains the command line program to build the index file of an OSP binary data file.
+ *<p>
+ *Usage:
+ *<p>OSPtoIDX.exe {options} [OSPfileName]
+ *<p>Options are:
+ *	- -h or --help : Show usage data. Default value HELP=FALSE
+ *	- -l LOGLEVEL or --llevel=LOGLEVEL : Maximum level to log (SEVERE, WARNING, INFO, CONFIG, FINE, FINER, FINEST). Default value LOGLEVEL = INFO
+ *Default values for operators are: DATA.OSP
+ *<p>
+ *Copyright 2015 Francisco Cancillo
+ *<p>
+ *This file is part of the RXtoRINEX tool.
+ *<p>
+ *RXtoRINEX is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *RXtoRINEX is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ *warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *See the GNU General Public License for more details.
+ *A copy of the GNU General Public License can be found at <http://www.gnu.org/licenses/>.
+ *
+ *V1.0	First release
+ */
+
+//from CommonClasses
+#include "ArgParser.h"
+#include "Logger.h"
+#include "OSPSource.h"
+#include "OSPIndex.h"
+
+using namespace std;
+
+///The command line format
+const string CMDLINE = "OSPtoIDX.exe {options} [OSPfileName]";
+///The parser object to store options and operators passed in the command line
+ArgParser parser;
+//@cond DUMMY
+//Metavariables for options
+int HELP, LOGLEVEL;	//the metavariables for the command line options
+//Metavariables for operators
+int OSPF;		//metavariables for the command line operands
+//@endcond
+
+/**main
+ * gets the command line arguments, set parameters accordingly and builds the index file of the given OSP file.
+ * The index file name is the OSP file name followed by the .ospidx extension.
+ * For each message in the OSP file, the index contains its offset in the file, MID, payload length,
+ * and the GPS week and TOW of the epoch it belongs to (taken from the MID7 message closing the epoch).
+ *<p>
+ * OSPtoRINEX and OSPtoRTK use the index, when it exists, to acquire header data without reading the whole OSP file.
+ *
+ *@param argc the number of arguments passed from the command line
+ *@param argv the array of arguments passed from the command line
+ *@return  the exit status according to the following values and meaning::
+ *		- (0) no errors have been detected
+ *		- (1) an error has been detected in arguments
+ *		- (2) error when opening the input file
+ *		- (3) error when creating the index file, or no messages exist
+ */
+int main(int argc, char* argv[]) {
+	/**The main process sequence follows:*/
+	/// 1- Defines and sets the error logger object
+	Logger log("LogFile.txt");
+	log.setPrgName(argv[0]);
+	/// 2- Setups the valid options in the command line. They will be used by the argument/option parser
+	LOGLEVEL = parser.addOption("-l", "--llevel", "LOGLEVEL", "Maximum level to log (SEVERE, WARNING, INFO, CONFIG, FINE, FINER, FINEST)", "INFO");
+	HELP = parser.addOption("-h", "--help", "HELP", "Show usage data", false);
+	/// 3- Setups the default values for operators in the command line
+	OSPF = parser.addOperator("DATA.OSP");
+	/// 4- Parses arguments in the command line extracting options and operators
+	try {
+		parser.parseArgs(argc, argv);
+	}  catch (string error) {
+		parser.usage("Argument error: " + error, CMDLINE);
+		log.severe(error);
+		return 1;
+	}
+	log.info(parser.showOptValues());
+	log.info(parser.showOpeValues());
+	if (parser.getBoolOpt(HELP)) {	//help info has been requested
+		parser.usage("Builds the index file of a OSP binary data file", CMDLINE);
+		return 0;
+	}
+	/// 5- Sets logging level stated in option
+	string s = parser.getStrOpt (LOGLEVEL);
+	if (s.compare("SEVERE") == 0) log.setLevel(SEVERE);
+	else if (s.compare("WARNING") == 0) log.setLevel(WARNING);
+	else if (s.compare("INFO") == 0) log.setLevel(INFO);
+	else if (s.compare("CONFIG") == 0) log.setLevel(CONFIG);
+	else if (s.compare("FINE") == 0) log.setLevel(FINE);
+	else if (s.compare("FINER") == 0) log.setLevel(FINER);
+	else if (s.compare("FINEST") == 0) log.setLevel(FINEST);
+	/// 6- Opens the OSP binary file mapping it into memory
+	OSPMappedSource source;
+	string fileName = parser.getOperator (OSPF);
+	if (!source.open(fileName)) {
+		log.severe("Cannot open file " + fileName);
+		return 2;
+	}
+	/// 7- Builds the index reading all messages in the OSP file
+	OSPIndex index;
+	if (!index.build(source, source.fileSize())) {
+		log.severe("No messages to index in " + fileName);
+		return 3;
+	}
+	if (source.tell() < source.fileSize())
+		log.warning("Wrong message length found at offset " + to_string(source.tell()) + ". Messages after it not indexed");
+	/// 8- Writes the index file
+	string idxFileName = fileName + OSPIDXEXT;
+	if (!index.save(idxFileName)) {
+		log.severe("Cannot create file " + idxFileName);
+		return 3;
+	}
+	log.info("End of index generation. Messages indexed: " + to_string((long long) index.size()));
+	return 0;
+}
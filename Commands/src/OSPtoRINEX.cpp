@@ -6,7 +6,10 @@
  *	- -a or --aend : Don't append end-of-file comment lines to Rinex file. Default value AEND=TRUE
  *	- -b or --bias : Don't apply receiver clock bias to measurements and time. Default value BIAS=TRUE
  *	- -c GPS or --gpsc=GPS : GPS code measurements to include (comma separated). Default value GPS = C1C,L1C,D1C,S1C
+ *	- -D TO or --to=TO : GPS time (WEEK:TOW) of the last epoch to convert (none if empty). Default value TO =
+ *	- -d FROM or --from=FROM : GPS time (WEEK:TOW) of the first epoch to convert (none if empty). Default value FROM =
  *	- -e or --ephemeris : Don't use MID15 (rx ephemeris) to generate GPS nav file. Default value EPHEM=TRUE
+ *	- -f FPASS or --fpass=FPASS : Single pass: maximum valid epochs to record for header data (0 reads the OSP file twice). Default value FPASS = 0
  *	- -g or --GPS50bps : Use MID8 (50bps data) to generate GPS nav file. Default value G50BPS=FALSE
  *	- -h or --help : Show usage data and stops. Default value HELP=FALSE
  *	- -i MINSV or --minsv=MINSV : Minimun satellites in a fix to acquire observations. Default value MINSV = 4
@@ -17,13 +20,19 @@
  *	- -n or --nRINEX : Generate RINEX GPS navigation file. Default value NAVI=FALSE
  *	- -o OBSERVER or --observer=OBSERVER : Observer name. Default value OBSERVER = OBSERVER
  *	- -p RUNBY or --runby=RUNBY : Who runs the RINEX file generator. Default value RUNBY = RUNBY
+ *	- -q PREFETCH or --prefetch=PREFETCH : Read the OSP file prefetching blocks by a thread: block size in KB and number of blocks (f.e. 1024,4; none if empty). Default value PREFETCH =
  *	- -r RINEX or --rinex=RINEX : RINEX file name prefix. Default value RINEX = PNT1
  *	- -s SBAS or --sbas=SBAS : SBAS measurements to include. Default value SBAS = C1C,L1C,D1C,S1C
  *	- -t MID or --last=MID : MID (Message ID) of last OSP message in an epoch. Default value MID = 7
  *	- -u MRKNUM or --mrknum=MRKNUM : Marker number. Default value MRKNUM = MRKNUM
  *	- -v VER or --ver=VER : RINEX version to generate (V210, V300). Default value VER = V210
+ *	- -w WORKERS or --workers=WORKERS : Threads acquiring epochs in parallel (1 acquires them sequentially). Default value WORKERS = 1
+ *	- -x OUTBUF or --outbuf=OUTBUF : Size in KB of the buffer used to write output files. Default value OUTBUF = 64
  *	- -y AGENCY or --agency=AGENCY : Agency name. Default value AGENCY = AGENCY
+ *	- -z SYNC or --sync=SYNC : MB written to output files between syncs to disk (0 for no syncs). Default value SYNC = 0
  *Default values for operators are: DATA.OSP 
+ *<p>The OSPfilename "-" stands for the standard input. As it cannot be rewound, the single pass mode is used.
+ *<p>The OSPfilename can be a comma separated list of OSP files (f.e. from several capture sessions) to be merged in GPS time order.
  *<p>
  *Copyright 2015 Francisco Cancillo
  *<p>
@@ -45,6 +54,13 @@
 #include "Utilities.h"
 #include "GNSSDataAcq.h"
 #include "RinexData.h"
+#include "OSPSource.h"
+#include "OSPGzipSource.h"
+#include "OSPMergeSource.h"
+#include "OSPIndex.h"
+#include "OutputSink.h"
+
+#include <thread>
 
 using namespace std;
 
@@ -52,20 +68,47 @@ using namespace std;
 const string CMDLINE = "OSPtoRINEX.exe {options} [OSPfilename]";
 ///The receiver name
 const string RECEIVER = "SiRFIV";
+///The maximum valid epochs to record for header data when the OSP file cannot be rewound and no FPASS option is given
+const int STREAMFPASS = 120;
+///The GPS week used as time window end when no TO option is given
+const int LASTWEEK = 99999;
 //@cond DUMMY
 ///The parser object to store options and operators passed in the comman line
 ArgParser parser;
 //Metavariables for options
-int AGENCY, AEND, ANTN, ANTT, BIAS, EPHEM, G50BPS, GPS, HELP, LOGLEVEL, NAVI, MID, MINSV, MRKNAM, MRKNUM, OBSERVER, RINEX, RUNBY, SBAS, VER;
+int AGENCY, AEND, ANTN, ANTT, BIAS, EPHEM, FPASS, FROM, G50BPS, GPS, HELP, LOGLEVEL, NAVI, MID, MINSV, MRKNAM, MRKNUM, OBSERVER, OUTBUF, PREFETCH, RINEX, RUNBY, SBAS, SYNC, TO, VER, WORKERS;
 //Metavariables for operators
 int OSPF;
+//Data of a chunk of epochs acquired in parallel
+struct EpochChunk {
+	long long begin;	//position in the OSP file of the chunk first message
+	long long end;		//position of the message after the chunk last one
+	RinexData rinex;	//the RinexData object used to acquire and print chunk epochs
+	FILE* obsFile;		//the temporary file where observation epochs are printed
+	FILE* logFile;		//the temporary file where logging messages are recorded
+	int epochs;			//the number of epochs acquired
+	unsigned int errors;	//the number of messages with decoding errors
+	EpochChunk(const RinexData& r) : rinex(r) {}
+};
 //@endcond 
 //functions in this file
-int generateRINEX(FILE*, Logger*);
+int generateRINEX(OSPSource*, OSPIndex*, Logger*);
+bool setTimeWindow(GNSSDataAcq&, Logger*);
+int acqEpochsParallel(GNSSDataAcq&, RinexData&, OSPMappedSource*, unsigned int, OutputSink*, Logger*);
+void acqEpochChunk(EpochChunk*, const unsigned char*, int, Logger*);
+void appendFile(OutputSink*, FILE*);
 
 /**main
  * gets the command line arguments, set parameters accordingly and triggers the data acquisition to generate RINEX files.
  * Input data are contained  in a OSP binary file containing receiver messages (see SiRF IV ICD for details).
+ * If an index file of the OSP file exists (see OSPtoIDX), it is used to acquire RINEX header data.
+ * In single pass mode (FPASS option greater than 0), the OSP file is read only once: the messages read to acquire
+ * header data are kept to generate the observation records. At most FPASS valid epochs are kept.
+ * If the first observation time or the interval are not acquired, they are set from the first epochs converted.
+ * When a time window is given (FROM and TO options), only epochs in it are converted. The OSP file is positioned
+ * at the first epoch in the window using its index or bisecting it, and conversion stops after the last one.
+ * When several WORKERS are requested and the OSP file can be mapped into memory, epochs are acquired in parallel
+ * from chunks of the file (see acqEpochsParallel). The files generated are the same ones generated sequentially.
  * The output is a RINEX observation data file, and optionally a RINEX navigation data file.
  * A detailed definition of the RINEX format can be found in the document "RINEX: The Receiver Independent Exchange
  * Format Version 2.10" from Werner Gurtner; Astronomical Institute; University of Berne. An updated document exists
@@ -85,12 +128,16 @@ int main(int argc, char* argv[]) {
 	Logger log("LogFile.txt");
 	log.setPrgName(argv[0]);
 	/// 2- Setups the valid options in the command line. They will be used by the argument/option parser
+	SYNC = parser.addOption("-z", "--sync", "SYNC", "MB written to output files between syncs to disk (0 for no syncs)", "0");
 	AGENCY = parser.addOption("-y", "--agency", "AGENCY", "Agency name", "AGENCY");
+	OUTBUF = parser.addOption("-x", "--outbuf", "OUTBUF", "Size in KB of the buffer used to write output files", "64");
+	WORKERS = parser.addOption("-w", "--workers", "WORKERS", "Threads acquiring epochs in parallel (1 acquires them sequentially)", "1");
 	VER = parser.addOption("-v", "--ver", "VER", "RINEX version to generate (V210, V300)", "V210");
 	MRKNUM = parser.addOption("-u", "--mrknum", "MRKNUM", "Marker number", "MRKNUM");
 	MID = parser.addOption("-t", "--last", "MID", "MID (Message ID) of last OSP message in an epoch", "7");
 	SBAS = parser.addOption("-s", "--sbas", "SBAS", "SBAS measurements to include", "C1C,L1C,D1C,S1C");
 	RINEX = parser.addOption("-r", "--rinex", "RINEX", "RINEX file name prefix", "PNT1");
+	PREFETCH = parser.addOption("-q", "--prefetch", "PREFETCH", "Read the OSP file prefetching blocks by a thread: block size in KB and number of blocks (f.e. 1024,4; none if empty)", "");
 	RUNBY = parser.addOption("-p", "--runby", "RUNBY", "Who runs the RINEX file generation", "RUNBY");
 	OBSERVER = parser.addOption("-o", "--observer", "OBSERVER", "Observer name", "OBSERVER");
 	NAVI = parser.addOption("-n", "--nRINEX", "NAVI", "Generate RINEX GPS navigation file", false);
@@ -101,7 +148,10 @@ int main(int argc, char* argv[]) {
 	MINSV = parser.addOption("-i", "--minsv", "MINSV", "Minimun satellites in a fix to acquire observations", "4");
 	HELP = parser.addOption("-h", "--help", "HELP", "Show usage data and stops", false);
 	G50BPS = parser.addOption("-g", "--GPS50bps", "G50BPS", "Use MID8 (50bps data) to generate GPS nav file", false);
+	FPASS = parser.addOption("-f", "--fpass", "FPASS", "Single pass: maximum valid epochs to record for header data (0 reads the OSP file twice)", "0");
 	EPHEM = parser.addOption("-e", "--ephemeris", "EPHEM", "Don't use MID15 (rx ephemeris) to generate GPS nav file", true);
+	FROM = parser.addOption("-d", "--from", "FROM", "GPS time (WEEK:TOW) of the first epoch to convert (none if empty)", "");
+	TO = parser.addOption("-D", "--to", "TO", "GPS time (WEEK:TOW) of the last epoch to convert (none if empty)", "");
 	GPS = parser.addOption("-c", "--gpsc", "GPS", "GPS code measurements to include (comma separated)", "C1C,L1C,D1C,S1C");
 	BIAS = parser.addOption("-b", "--bias", "BIAS", "Don't apply receiver clock bias to measurements and time", true);
 	AEND = parser.addOption("-a", "--aend", "AEND", "Don't append end-of-file comment lines to Rinex file", true);
@@ -131,30 +181,91 @@ int main(int argc, char* argv[]) {
 	else if (s.compare("FINE") == 0) log.setLevel(FINE);
 	else if (s.compare("FINER") == 0) log.setLevel(FINER);
 	else if (s.compare("FINEST") == 0) log.setLevel(FINEST);
-	/// 6- Opens the OSP binary file
-	FILE* inFile;
+	int week;
+	double tow;
+	if ((!parser.getStrOpt(FROM).empty() && !getWeekTow(parser.getStrOpt(FROM), week, tow)) ||
+		(!parser.getStrOpt(TO).empty() && !getWeekTow(parser.getStrOpt(TO), week, tow))) {
+		log.severe("Incorrect time window (WEEK:TOW expected) from " + parser.getStrOpt(FROM) + " to " + parser.getStrOpt(TO));
+		return 1;
+	}
+	unsigned int prefetchSize = 0, prefetchBlocks = 0;
+	if (!parser.getStrOpt(PREFETCH).empty() && !getBlocks(parser.getStrOpt(PREFETCH), prefetchSize, prefetchBlocks)) {
+		log.severe("Incorrect prefetch blocks (SIZEKB,BLOCKS expected): " + parser.getStrOpt(PREFETCH));
+		return 1;
+	}
+	int nWorkers;
+	if (!getInteger(parser.getStrOpt(WORKERS), nWorkers) || nWorkers < 1) {
+		log.severe("Incorrect number of workers " + parser.getStrOpt(WORKERS));
+		return 1;
+	}
+	int outBufKB, syncMB;
+	if (!getInteger(parser.getStrOpt(OUTBUF), outBufKB) || outBufKB <= 0 || outBufKB > 1048576 ||
+		!getInteger(parser.getStrOpt(SYNC), syncMB) || syncMB < 0) {
+		log.severe("Incorrect output buffer size " + parser.getStrOpt(OUTBUF) + " or sync interval " + parser.getStrOpt(SYNC));
+		return 1;
+	}
+	/// 6- Opens the OSP binary file mapping it into memory, or as a FILE if it cannot be mapped (f.e. "-" for stdin, or a pipe)
+	///    or it is gzip compressed (decompressed while read) or in the container format. A comma separated list of files are merged chronologically.
+	///    When prefetch is requested, it is opened as a FILE read by blocks in advance
+	FILE* inFile = NULL;
+	OSPMappedSource mappedSource;
+	OSPMergeSource mergeSource;
+	OSPSource* source = &mappedSource;
 	string fileName = parser.getOperator (OSPF);
-	if ((inFile = fopen(fileName.c_str(), "rb")) == NULL) {
-		log.severe("Cannot open file " + fileName);
-		return 2;
+	vector<string> fileNames = getTokens(fileName, ',');
+	if (fileNames.size() > 1) {
+		for (unsigned int i=0; i<fileNames.size(); i++) {
+			if (!mergeSource.addFile(fileNames[i])) {
+				log.severe("Cannot open file " + fileNames[i]);
+				return 2;
+			}
+		}
+		source = &mergeSource;
+		if (prefetchBlocks > 0) log.warning("Prefetch not used merging files");
+	} else if (fileName.compare("-") == 0 || prefetchBlocks > 0 || !mappedSource.open(fileName) || mappedSource.isGzipped() || mappedSource.isContainer()) {
+		mappedSource.close();
+		if ((inFile = openBinaryFile(fileName, false)) == NULL) {
+			log.severe("Cannot open file " + fileName);
+			return 2;
+		}
+		source = newOSPStreamSource(inFile, prefetchSize, prefetchBlocks);
+	}
+	//use the index file, if it exists and matches the OSP file
+	OSPIndex index;
+	OSPIndex* pindex = NULL;
+	if (source == &mappedSource && index.load(fileName + OSPIDXEXT, mappedSource.fileSize())) {
+		pindex = &index;
+		log.info("Using index file " + fileName + OSPIDXEXT);
 	}
 	/// 7- Calls generateRINEX to generate RINEX files extracting data from messages in the binary OSP file
-	int n = generateRINEX(inFile, &log);
-	fclose(inFile);
+	int n = generateRINEX(source, pindex, &log);
+	if (source == &mappedSource && parser.getStrOpt(TO).empty() && mappedSource.tell() < mappedSource.fileSize())
+		log.warning("Wrong message length found at offset " + to_string(mappedSource.tell()) +
+					". Data after it not processed (see OSPCheck to repair the file)");
+	if (inFile != NULL) {
+		logOSPStreamSource(source, fileName, prefetchBlocks > 0, &log);
+		delete source;
+		closeBinaryFile(inFile);
+	}
+	if (mergeSource.getDroppedEpochs() > 0)
+		log.warning("Duplicated or out of order epochs dropped merging files: " + to_string((long long) mergeSource.getDroppedEpochs()));
 	log.info("End of RINEX generation. Epochs read: " + to_string((long long) n));
 	return n>0? 0:3;
 }
 /**generateRINEX iterates over the input OSP file processing GNSS receiver messages to extract RINEX data and print them.
  *
- *@param inFile is the FILE containing the binary OSP messages
+ *@param source is the OSPSource providing the binary OSP messages
+ *@param pindex is the index of the OSP messages, or NULL if not available
  *@param plog point to the Logger
  *@return the number of epochs read in the inFile
  */
-int generateRINEX(FILE* inFile, Logger* plog) {
+int generateRINEX(OSPSource* source, OSPIndex* pindex, Logger* plog) {
 	/**The generateRINEX process sequence follows:*/
 	int epochCount;		//to count the number of epochs processed
 	string outFileName;	//the output file name for RINEX files
 	FILE* outFile;		//the open file where RINEX data will be printed
+	unsigned int outBufSize = (unsigned int) stoi(parser.getStrOpt(OUTBUF)) * 1024;
+	unsigned long long syncBytes = (unsigned long long) stoi(parser.getStrOpt(SYNC)) * 1048576;
 	/// 1- Setups the RinexData object elements with data given in command line options  
 	//a vector to contain the GNSS system data used by this receiver
 	vector <GNSSsystem> systems; 
@@ -175,31 +286,69 @@ int generateRINEX(FILE* inFile, Logger* plog) {
 		parser.getBoolOpt(BIAS),
 		systems);
 	/// 2- Setups the GNSSDataAcq object used to extract message data from the OSP file
-	GNSSDataAcq gnssAcq(RECEIVER, stoi(parser.getStrOpt(MINSV)), inFile, plog);
+	GNSSDataAcq gnssAcq(RECEIVER, stoi(parser.getStrOpt(MINSV)), source, plog);
+	gnssAcq.setIndex(pindex);
+	int fpass = stoi(parser.getStrOpt(FPASS));
+	if (fpass <= 0 && !source->canSeek()) {
+		fpass = STREAMFPASS;
+		plog->info("Input cannot be rewound. Single pass mode set recording up to " + to_string((long long) fpass) + " epochs");
+	}
+	gnssAcq.setSinglePass(fpass);
+	gnssAcq.selectMessages(true, parser.getBoolOpt(EPHEM), parser.getBoolOpt(G50BPS));
+	bool timeWindow = setTimeWindow(gnssAcq, plog);
 	/// 3- Starts data acquisition extracting RINEX header data located in the binary file
 	if(!gnssAcq.acqHeaderData(rinex)) {
 		plog->warning("All, or some header data not acquired");
 	};
-	/// 4- Generates RINEX observation filename in standard format and creates it
 	outFileName = rinex.getObsFileName(parser.getStrOpt (RINEX));
+	/// 4- When the first observation time or the interval have not been acquired (f.e. the epochs recorded in single pass
+	///    mode are not enough), the first epochs are acquired and printed to memory to set them from these epochs
+	epochCount = 0;
+	bool useEphem = parser.getBoolOpt(EPHEM);
+	bool useG50bps = parser.getBoolOpt(G50BPS);
+	int nWorkers = stoi(parser.getStrOpt(WORKERS));
+	OSPMappedSource* mappedSource = dynamic_cast<OSPMappedSource*>(source);
+	bool parallel = nWorkers > 1 && fpass <= 0 && mappedSource != NULL && !timeWindow;
+	bool moreEpochs = true;		//epochs could remain in the source
+	MemorySink firstEpochs;		//the epochs printed before the header
+	gnssAcq.rewind();
+	if (!parallel && !rinex.hasObsTimes()) {
+		plog->warning("First observation time or interval not acquired. They are set from the first epochs");
+		while (!rinex.hasObsTimes() && (moreEpochs = gnssAcq.acqEpochData(rinex, useEphem, useG50bps))) {
+			if (epochCount == 0) {
+				rinex.setFistObsTime();
+				outFileName = rinex.getObsFileName(parser.getStrOpt (RINEX));
+			} else rinex.setIntervalTime();
+			rinex.printObsEpoch(&firstEpochs);
+			epochCount++;
+		}
+	}
+	/// 5- Creates the RINEX observation file, named in standard format from the first epoch time
 	if ((outFile = fopen(outFileName.c_str(), "w")) == NULL) {
 		plog->severe("Cannot create file " + outFileName);
 		return 0;
 	}
-	/// 5- Prints RINEX observation file header
-	rinex.printObsHeader(outFile);
-	/// 6- Iterates over the binary OSP file extracting epoch by epoch data and printing them
-	epochCount = 0;
-	bool useEphem = parser.getBoolOpt(EPHEM);
-	bool useG50bps = parser.getBoolOpt(G50BPS);
-	rewind(inFile);
-	while (gnssAcq.acqEpochData(rinex, useEphem, useG50bps)) {
-		rinex.printObsEpoch(outFile);
-		epochCount++;
+	/// 6- Prints RINEX observation file header, and the epochs printed before it. Data are written to the file through
+	///    a block buffered sink
+	FileSink obsSink(outFile, outBufSize, syncBytes);
+	rinex.printObsHeader(&obsSink);
+	if (firstEpochs.getSize() > 0) obsSink.write(firstEpochs.getData(), (unsigned int) firstEpochs.getSize());
+	/// 7- Iterates over the binary OSP file extracting epoch by epoch data and printing them.
+	///    When several workers are requested and the file is mapped, epochs are acquired in parallel (if no time window is given)
+	if (parallel) {
+		epochCount = acqEpochsParallel(gnssAcq, rinex, mappedSource, (unsigned int) nWorkers, &obsSink, plog);
+	} else {
+		while (moreEpochs && gnssAcq.acqEpochData(rinex, useEphem, useG50bps)) {
+			rinex.printObsEpoch(&obsSink);
+			epochCount++;
+		}
+		if (gnssAcq.getDecodeErrors() > 0)
+			plog->warning("Messages with decoding errors: " + to_string((long long) gnssAcq.getDecodeErrors()));
 	}
-	rinex.printObsEOF(outFile);
+	rinex.printObsEOF(&obsSink);
+	if (!obsSink.flush()) plog->severe("Write error in file " + outFileName);
 	fclose(outFile);
-	/// 7- Generates the Rinex navigation file, if requested
+	/// 8- Generates the Rinex navigation file, if requested
 	if (parser.getBoolOpt (NAVI)) {
 		//get RINEX GPS navigation in standard format and open it
 		outFileName = rinex.getGPSnavFileName(parser.getStrOpt (RINEX));
@@ -207,9 +356,154 @@ int generateRINEX(FILE* inFile, Logger* plog) {
 			plog->severe("Cannot create file " + outFileName);
 			return 0;
 		}
-		rinex.printGPSnavHeader(outFile);	//print GPS navigation file header
-		rinex.printGPSnavEpoch(outFile);	//print GPS navigation file epoch data
+		FileSink navSink(outFile, outBufSize, syncBytes);
+		rinex.printGPSnavHeader(&navSink);	//print GPS navigation file header
+		rinex.printGPSnavEpoch(&navSink);	//print GPS navigation file epoch data
+		if (!navSink.flush()) plog->severe("Write error in file " + outFileName);
 		fclose(outFile);
 	}
 	return epochCount;
-}
\ No newline at end of file
+}
+
+/**setTimeWindow sets the time window of epochs to acquire given in the FROM and TO options, if any.
+ * When only one of them is given, the window extends from the beginning or to the end of data.
+ *
+ *@param gnssAcq the GNSSDataAcq object used to acquire data
+ *@param plog point to the Logger
+ *@return true if a time window has been set, false if no one is given in options
+ */
+bool setTimeWindow(GNSSDataAcq& gnssAcq, Logger* plog) {
+	string from = parser.getStrOpt(FROM);
+	string to = parser.getStrOpt(TO);
+	if (from.empty() && to.empty()) return false;
+	int fromWeek = 0;
+	int toWeek = LASTWEEK;
+	double fromTow = 0.0;
+	double toTow = 0.0;
+	if (!from.empty()) getWeekTow(from, fromWeek, fromTow);
+	if (!to.empty()) getWeekTow(to, toWeek, toTow);
+	if (gnssAcq.setTimeWindow(fromWeek, fromTow, toWeek, toTow)) plog->fine("Input positioned at the time window start");
+	else plog->info("Input cannot be positioned: epochs before the time window will be read and skipped");
+	return true;
+}
+
+/**acqEpochsParallel acquires epoch data from the mapped OSP file using several threads, and prints them.
+ * The file is split into chunks starting at epoch boundaries (see GNSSDataAcq::findEpochChunks).
+ * Each chunk is processed by a worker thread, with its own GNSSDataAcq and RinexData objects, that prints the
+ * chunk observation epochs to a temporary file. Navigation data (and the epoch time state) are acquired in another
+ * thread reading all MID7, MID8 and MID15 messages in the file, as they depend on messages in previous chunks.
+ * When all threads finish, chunk epochs are appended to the output file in order, and the RinexData object passed
+ * is updated with navigation data and the state needed to complete the RINEX files.
+ * Logging messages from threads are appended to the log in the same order.
+ *
+ *@param gnssAcq the GNSSDataAcq object used to acquire header data, with the source rewound
+ *@param rinex the RinexData object with header data acquired
+ *@param mappedSource the source with the mapped OSP file
+ *@param nWorkers the number of worker threads
+ *@param out the OutputSink of the RINEX observation file where epochs are printed
+ *@param plog point to the Logger
+ *@return the number of epochs acquired
+ */
+int acqEpochsParallel(GNSSDataAcq& gnssAcq, RinexData& rinex, OSPMappedSource* mappedSource, unsigned int nWorkers, OutputSink* out, Logger* plog) {
+	const unsigned char* data = mappedSource->fileData();
+	long long size = mappedSource->fileSize();
+	int minSV = stoi(parser.getStrOpt(MINSV));
+	/// 1- Splits the file into chunks and setups their data
+	vector<long long> starts = gnssAcq.findEpochChunks(nWorkers, size);
+	vector<EpochChunk> chunks;
+	for (unsigned int i=0; i<starts.size(); i++) {
+		chunks.push_back(EpochChunk(rinex));
+		chunks[i].begin = starts[i];
+		chunks[i].end = i+1 < starts.size()? starts[i+1]: size;
+		chunks[i].obsFile = tmpfile();
+		chunks[i].logFile = tmpfile();
+		chunks[i].epochs = 0;
+		chunks[i].errors = 0;
+		if (chunks[i].obsFile == NULL || chunks[i].logFile == NULL) {
+			plog->warning("Cannot create temporary files. Epochs acquired sequentially");
+			for (unsigned int j=0; j<=i; j++) {
+				if (chunks[j].obsFile != NULL) fclose(chunks[j].obsFile);
+				if (chunks[j].logFile != NULL) fclose(chunks[j].logFile);
+			}
+			int epochCount = 0;
+			gnssAcq.rewind();
+			while (gnssAcq.acqEpochData(rinex, parser.getBoolOpt(EPHEM), parser.getBoolOpt(G50BPS))) {
+				rinex.printObsEpoch(out);
+				epochCount++;
+			}
+			return epochCount;
+		}
+	}
+	plog->info("Epochs acquired in parallel from " + to_string((long long) chunks.size()) + " chunks");
+	/// 2- Starts worker threads acquiring chunk epochs, and acquires navigation data in the current one
+	vector<thread> workers;
+	for (unsigned int i=0; i<chunks.size(); i++)
+		workers.push_back(thread(acqEpochChunk, &chunks[i], data, minSV, plog));
+	FILE* navLogFile = tmpfile();
+	Logger navLog(*plog, navLogFile != NULL? navLogFile: stderr);
+	OSPMemorySource navSource(data, size);
+	GNSSDataAcq navAcq(RECEIVER, minSV, &navSource, &navLog);
+	navAcq.selectMessages(true, parser.getBoolOpt(EPHEM), parser.getBoolOpt(G50BPS));
+	RinexData navRinex(rinex);
+	navAcq.acqNavData(navRinex, parser.getBoolOpt(EPHEM), parser.getBoolOpt(G50BPS));
+	for (unsigned int i=0; i<workers.size(); i++) workers[i].join();
+	/// 3- Appends chunk epochs and logs in order
+	int epochCount = 0;
+	unsigned int errors = navAcq.getDecodeErrors();
+	for (unsigned int i=0; i<chunks.size(); i++) {
+		appendFile(out, chunks[i].obsFile);
+		plog->append(chunks[i].logFile);
+		fclose(chunks[i].obsFile);
+		fclose(chunks[i].logFile);
+		epochCount += chunks[i].epochs;
+		errors += chunks[i].errors;
+	}
+	if (navLogFile != NULL) {
+		plog->append(navLogFile);
+		fclose(navLogFile);
+	}
+	if (errors > 0) plog->warning("Messages with decoding errors: " + to_string((long long) errors));
+	/// 4- Sets the final state: navigation data and epoch time from the navigation pass, and time tag from the last epochs
+	double epochTimeTag = rinex.getEpochTimeTag();
+	for (unsigned int i=0; i<chunks.size(); i++)
+		if (chunks[i].epochs > 0) epochTimeTag = chunks[i].rinex.getEpochTimeTag();
+	rinex = navRinex;
+	rinex.setEpochTimeTag(epochTimeTag);
+	return epochCount;
+}
+
+/**acqEpochChunk is the body of the worker threads used by acqEpochsParallel.
+ * It acquires all epochs in the chunk, without navigation data, and prints them to the chunk temporary file.
+ * Logging messages are recorded in the chunk temporary log file.
+ *
+ *@param chunk the data of the chunk to process
+ *@param data the pointer to the first byte of the mapped OSP file
+ *@param minSV the minimum of satellites required for a fix
+ *@param plog point to the Logger whose program name and level are used
+ */
+void acqEpochChunk(EpochChunk* chunk, const unsigned char* data, int minSV, Logger* plog) {
+	Logger log(*plog, chunk->logFile);
+	FileSink obsSink(chunk->obsFile);
+	OSPMemorySource source(data + chunk->begin, chunk->end - chunk->begin);
+	GNSSDataAcq gnssAcq(RECEIVER, minSV, &source, &log);
+	gnssAcq.selectMessages(true, false, false);
+	while (gnssAcq.acqEpochData(chunk->rinex, false, false)) {
+		chunk->rinex.printObsEpoch(&obsSink);
+		chunk->epochs++;
+	}
+	chunk->errors = gnssAcq.getDecodeErrors();
+	obsSink.flush();
+}
+
+/**appendFile appends to an OutputSink the whole content of a file.
+ *
+ *@param out the OutputSink where content is appended
+ *@param in the file whose content is appended
+ */
+void appendFile(OutputSink* out, FILE* in) {
+	char buffer[65536];
+	size_t n;
+	fflush(in);
+	rewind(in);
+	while ((n = fread(buffer, 1, sizeof buffer, in)) > 0) out->write(buffer, (unsigned int) n);
+}
@@ -4,10 +4,16 @@
  *<p>Usage:
  *<p>OSPtoRTK {options} [OSPfileName]
  *<p>Options are:
+ *	- -D TO or --to=TO : GPS time (WEEK:TOW) of the last solution to extract (none if empty). Default value TO =
+ *	- -d FROM or --from=FROM : GPS time (WEEK:TOW) of the first solution to extract (none if empty). Default value FROM =
  *	- -h or --help : Show usage data. Default value HELP=FALSE
  *	- -l LOGLEVEL or --llevel=LOGLEVEL : Maximum level to log (SEVERE, WARNING, INFO, CONFIG, FINE, FINER, FINEST). Default value LOGLEVEL = INFO
  *	- -m MINSV or --minsv=MINSV : Minimum satellites in a fix to acquire solution data. Default value MINSV = 4
+ *	- -q PREFETCH or --prefetch=PREFETCH : Read the OSP file prefetching blocks by a thread: block size in KB and number of blocks (f.e. 1024,4; none if empty). Default value PREFETCH =
+ *	- -x OUTBUF or --outbuf=OUTBUF : Size in KB of the buffer used to write the RTK file. Default value OUTBUF = 64
+ *	- -z SYNC or --sync=SYNC : MB written to the RTK file between syncs to disk (0 for no syncs). Default value SYNC = 0
  * Default values for operators are: DATA.OSP 
+ *<p>The OSPfileName "-" stands for the standard input. In this case the RTK file name is DATA.OSP.pos
  *<p>
  *Copyright 2015 Francisco Cancillo
  *<p>
@@ -29,25 +35,37 @@
 #include "RTKobservation.h"
 #include "GNSSDataAcq.h"
 #include "OSPMessage.h"
+#include "OSPSource.h"
+#include "OSPGzipSource.h"
+#include "OSPIndex.h"
+#include "Utilities.h"
+#include "OutputSink.h"
 
 using namespace std;
 
 ///The command line format
 const string CMDLINE = "OSPtoRTK {options} [OSPfileName]";
+///The GPS week used as time window end when no TO option is given
+const int LASTWEEK = 99999;
 //@cond DUMMY
 ///The parser object to store options and operators passed in the comman line
 ArgParser parser;
 //Metavariables for options
-int HELP, LOGLEVEL, MINSV;
+int FROM, HELP, LOGLEVEL, MINSV, OUTBUF, PREFETCH, SYNC, TO;
 //Metavariables for operators
 int OSPF;
 //@endcond 
 //functions in this module
-int generateRTKobs(FILE*, FILE*, string, Logger*);
+int generateRTKobs(OSPSource*, OSPIndex*, OutputSink*, string, Logger*);
+bool setTimeWindow(GNSSDataAcq&, Logger*);
 
 /**main
  * gets the command line arguments, set parameters accordingly and triggers the data acquisition to generate the RTK file.
  * Input data are contained  in a OSP binary file containing receiver messages (see SiRF IV ICD for details).
+ * If an index file of the OSP file exists (see OSPtoIDX), it is used to acquire RTK header data.
+ * Otherwise the OSP file is read only once, and the RTK header is rewritten at the end with the data acquired.
+ * When a time window is given (FROM and TO options), only solutions in it are extracted. The OSP file is positioned
+ * at the first epoch in the window using its index or bisecting it, and extraction stops after the last one.
  * The output is a RTK file with data formatted as per RTKLIB (http://www.rtklib.com/) for this kind of files.
  *
  * @param argc	the number of arguments passed from the command line
@@ -64,9 +82,14 @@ int main(int argc, char** argv) {
 	Logger log("LogFile.txt");		//the error logger object
 	log.setPrgName(argv[0]);
 	/// 2- Setups the valid options in the command line. They will be used by the argument/option parser
+	SYNC = parser.addOption("-z", "--sync", "SYNC", "MB written to the RTK file between syncs to disk (0 for no syncs)", "0");
+	OUTBUF = parser.addOption("-x", "--outbuf", "OUTBUF", "Size in KB of the buffer used to write the RTK file", "64");
+	PREFETCH = parser.addOption("-q", "--prefetch", "PREFETCH", "Read the OSP file prefetching blocks by a thread: block size in KB and number of blocks (f.e. 1024,4; none if empty)", "");
 	MINSV = parser.addOption("-m", "--minsv", "MINSV", "Minimun satellites in a fix to acquire observations", "4");
 	LOGLEVEL = parser.addOption("-l", "--llevel", "LOGLEVEL", "Maximum level to log (SEVERE, WARNING, INFO, CONFIG, FINE, FINER, FINEST)", "INFO");
 	HELP = parser.addOption("-h", "--help", "HELP", "Show usage data", false);
+	FROM = parser.addOption("-d", "--from", "FROM", "GPS time (WEEK:TOW) of the first solution to extract (none if empty)", "");
+	TO = parser.addOption("-D", "--to", "TO", "GPS time (WEEK:TOW) of the last solution to extract (none if empty)", "");
 	/// 3- Setups the default values for operators in the command line
 	OSPF = parser.addOperator("DATA.OSP");
 	/// 4- Parses arguments in the command line extracting options and operators
@@ -92,59 +115,141 @@ int main(int argc, char** argv) {
 	else if (s.compare("FINE") == 0) log.setLevel(FINE);
 	else if (s.compare("FINER") == 0) log.setLevel(FINER);
 	else if (s.compare("FINEST") == 0) log.setLevel(FINEST);
-	/// 6- Opens the OSP binary file
-	FILE* inFile;
+	int week;
+	double tow;
+	if ((!parser.getStrOpt(FROM).empty() && !getWeekTow(parser.getStrOpt(FROM), week, tow)) ||
+		(!parser.getStrOpt(TO).empty() && !getWeekTow(parser.getStrOpt(TO), week, tow))) {
+		log.severe("Incorrect time window (WEEK:TOW expected) from " + parser.getStrOpt(FROM) + " to " + parser.getStrOpt(TO));
+		return 1;
+	}
+	unsigned int prefetchSize = 0, prefetchBlocks = 0;
+	if (!parser.getStrOpt(PREFETCH).empty() && !getBlocks(parser.getStrOpt(PREFETCH), prefetchSize, prefetchBlocks)) {
+		log.severe("Incorrect prefetch blocks (SIZEKB,BLOCKS expected): " + parser.getStrOpt(PREFETCH));
+		return 1;
+	}
+	int outBufKB, syncMB;
+	if (!getInteger(parser.getStrOpt(OUTBUF), outBufKB) || outBufKB <= 0 || outBufKB > 1048576 ||
+		!getInteger(parser.getStrOpt(SYNC), syncMB) || syncMB < 0) {
+		log.severe("Incorrect output buffer size " + parser.getStrOpt(OUTBUF) + " or sync interval " + parser.getStrOpt(SYNC));
+		return 1;
+	}
+	/// 6- Opens the OSP binary file mapping it into memory, or as a FILE if it cannot be mapped (f.e. "-" for stdin, or a pipe)
+	///    or it is gzip compressed (decompressed while read) or in the container format.
+	///    When prefetch is requested, it is opened as a FILE read by blocks in advance
+	FILE* inFile = NULL;
+	OSPMappedSource mappedSource;
+	OSPSource* source = &mappedSource;
 	string fileName = parser.getOperator (OSPF);
-	if ((inFile = fopen(fileName.c_str(), "rb")) == NULL) {
-		log.severe("Cannot open file " + fileName);
-		return 2;
+	if (fileName.compare("-") == 0 || prefetchBlocks > 0 || !mappedSource.open(fileName) || mappedSource.isGzipped() || mappedSource.isContainer()) {
+		mappedSource.close();
+		if ((inFile = openBinaryFile(fileName, false)) == NULL) {
+			log.severe("Cannot open file " + fileName);
+			return 2;
+		}
+		source = newOSPStreamSource(inFile, prefetchSize, prefetchBlocks);
+	}
+	//use the index file, if it exists and matches the OSP file
+	OSPIndex index;
+	OSPIndex* pindex = NULL;
+	if (inFile == NULL && index.load(fileName + OSPIDXEXT, mappedSource.fileSize())) {
+		pindex = &index;
+		log.info("Using index file " + fileName + OSPIDXEXT);
 	}
-	/// 7- Creates the output RTK file
-	string rtkFileName = fileName + ".pos";
+	/// 7- Creates the output RTK file, written through a block buffered sink
+	string rtkFileName = (fileName.compare("-") == 0? string("DATA.OSP"): fileName) + ".pos";
 	FILE* rtkFile;
 	if ((rtkFile = fopen(rtkFileName.c_str(), "w")) == NULL) {
 		log.severe("Cannot create file " + rtkFileName);
 		return 3;
 	}
+	FileSink rtkSink(rtkFile, (unsigned int) outBufKB * 1024, (unsigned long long) syncMB * 1048576);
 	/// 8- Generates RTK file calling generateRTKobs to extract data from messages in the binary OSP file and print them
-	int n = generateRTKobs(inFile, rtkFile, fileName, &log);
-    fclose(inFile);
+	int n = generateRTKobs(source, pindex, &rtkSink, fileName, &log);
+	if (inFile == NULL && parser.getStrOpt(TO).empty() && mappedSource.tell() < mappedSource.fileSize())
+		log.warning("Wrong message length found at offset " + to_string(mappedSource.tell()) +
+					". Data after it not processed (see OSPCheck to repair the file)");
+	if (inFile != NULL) {
+		logOSPStreamSource(source, fileName, prefetchBlocks > 0, &log);
+		delete source;
+		closeBinaryFile(inFile);
+	}
+	if (!rtkSink.flush()) log.severe("Write error in file " + rtkFileName);
     fclose(rtkFile);
 	log.info("End of data extraction. Epochs read: " + to_string((long long) n));
 	return n>0? 0:3;
 }
 /**generateRTKobs iterates over the input OSP file processing GNSS receiver messages to extract RTK positioning data,
  * and prints them.
- * Data are extracted first for the RTK file header and them epoch by epoch for each solution (one per line).
+ * When an index is available, data are extracted first for the RTK file header and them epoch by epoch for each solution
+ * (one per line).
+ * Otherwise, data are extracted in a single pass: the header is printed first with default values, solutions are
+ * extracted and printed epoch by epoch, and header data are updated with data acquired from the first and last solutions
+ * and the masks, and rewritten in place.
  *
- * @param inFile the  pointer to the input OSP binary FILE
- * @param rtkFile the  pointer to the output RTK FILE
+ * @param source the  pointer to the OSPSource providing messages from the input OSP binary file
+ * @param pindex the pointer to the index of the input OSP binary file, or NULL if not available
+ * @param rtkSink the  pointer to the OutputSink of the output RTK file
  * @param inFileName the  name of the input OSP binary FILE
  * @param plog the pointer to the logger
  * @return the number of epochs read
  *
  */
-int generateRTKobs(FILE* inFile, FILE* rtkFile, string inFileName, Logger* plog) {
+int generateRTKobs(OSPSource* source, OSPIndex* pindex, OutputSink* rtkSink, string inFileName, Logger* plog) {
 	/**The generateRTKobs process sequence follows:*/
 	int nEpochs = 0;		//to count the number of epochs processed
 	/// 1- Setups the GNSSDataAcq object used to extract data from the binary file
-	GNSSDataAcq gnssAcq("SiRFiv_BU-353S4", stoi(parser.getStrOpt(MINSV)), inFile, plog);
+	GNSSDataAcq gnssAcq("SiRFiv_BU-353S4", stoi(parser.getStrOpt(MINSV)), source, plog);
+	gnssAcq.setIndex(pindex);
+	gnssAcq.selectMessages(false, false, false);
+	setTimeWindow(gnssAcq, plog);
 	/// 2- Setups the RTKobservation object where extracted RTK data from the binary file will be placed 
 	RTKobservation rtko(plog);
 	//setup RTK header data
 	rtko.setId("OSPlogger V1.0", inFileName);
-	/// 3- Acquire RTK header data located in the binary input file
-	if(!gnssAcq.acqHeaderData(rtko)) {
+	/// 3- Acquire RTK header data using the index, if available. Otherwise they will be acquired while reading epochs
+	bool singlePass = pindex == NULL;
+	if(!singlePass && !gnssAcq.acqHeaderData(rtko)) {
 		plog->warning("All, or some header data not acquired");
 	};
 	/// 4- Prints RTK file header
-	rtko.printHeader(rtkFile);
-	rewind(inFile);
-	/// 6- Iterates over the binary OSP file extracting epoch by epoch solution data and printing them
+	rtko.printHeader(rtkSink);
+	if (!singlePass) gnssAcq.rewind();
+	/// 5- Iterates over the binary OSP file extracting epoch by epoch solution data and printing them
 	while (gnssAcq.acqEpochData(rtko)) {
-		rtko.printSolution(rtkFile);
+		if (singlePass && nEpochs == 0) rtko.setStartTime();
+		rtko.printSolution(rtkSink);
 		nEpochs++;
 	}
+	if (gnssAcq.getDecodeErrors() > 0)
+		plog->warning("Messages with decoding errors: " + to_string((long long) gnssAcq.getDecodeErrors()));
+	/// 6- In single pass, sets the end time from the last solution and rewrites the header
+	if (singlePass) {
+		if (nEpochs > 0) rtko.setEndTime();
+		if (!gnssAcq.epochHeaderData()) plog->warning("All, or some header data not acquired");
+		if (!rtko.rewriteHeader(rtkSink)) plog->severe("Cannot update header data in the RTK file");
+	}
 	return nEpochs;
 }
 
+
+/**setTimeWindow sets the time window of solutions to extract given in the FROM and TO options, if any.
+ * When only one of them is given, the window extends from the beginning or to the end of data.
+ *
+ * @param gnssAcq the GNSSDataAcq object used to acquire data
+ * @param plog the pointer to the logger
+ * @return true if a time window has been set, false if no one is given in options
+ */
+bool setTimeWindow(GNSSDataAcq& gnssAcq, Logger* plog) {
+	string from = parser.getStrOpt(FROM);
+	string to = parser.getStrOpt(TO);
+	if (from.empty() && to.empty()) return false;
+	int fromWeek = 0;
+	int toWeek = LASTWEEK;
+	double fromTow = 0.0;
+	double toTow = 0.0;
+	if (!from.empty()) getWeekTow(from, fromWeek, fromTow);
+	if (!to.empty()) getWeekTow(to, toWeek, toTow);
+	if (gnssAcq.setTimeWindow(fromWeek, fromTow, toWeek, toTow)) plog->fine("Input positioned at the time window start");
+	else plog->info("Input cannot be positioned: epochs before the time window will be read and skipped");
+	return true;
+}
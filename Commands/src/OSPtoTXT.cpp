@@ -7,6 +7,7 @@
  *	- -h or --help : Show usage data. Default value HELP=FALSE
  *	- -l LOGLEVEL or --llevel=LOGLEVEL : Maximum level to log (SEVERE, WARNING, INFO, CONFIG, FINE, FINER, FINEST). Default value LOGLEVEL = INFO
  *Default values for operators are: DATA.OSP 
+ *<p>The OSPfileName "-" stands for the standard input.
  *<p>
  *Copyright 2015 Francisco Cancillo
  *<p>
@@ -26,6 +27,10 @@
 #include "ArgParser.h"
 #include "Logger.h"
 #include "OSPMessage.h"
+#include "OSPSource.h"
+#include "OSPGzipSource.h"
+#include "OSPContainer.h"
+#include "OSPLayouts.h"
 #include "Utilities.h"
 
 using namespace std;
@@ -41,13 +46,14 @@ int HELP, LOGLEVEL;	//the metavariables for the command line options
 int OSPF;		//metavariables for the command line operands
 //@endcond 
 //functions in this file
-int extractMsgs(FILE* , Logger*);
+int extractMsgs(OSPSource* , Logger*);
 
 /**main
  * gets the command line arguments, set parameters accordingly and performs the data acquisition for printing them.
  * Input data are contained  in a OSP binary file containing length and payload of receiver messages
  * (see SiRF IV ICD for details).
  * The output contains printed descriptive relevant data from each OSP message:
+ *  - Host capture time (milliseconds from 1970-01-01), when the file is in the container format
  *  - Message identification (MID, in decimal) and payload length for all messages
  *  - Payload parameter values for relevant messages used to generate RINEX or RTK files
  *  - Payload bytes in hexadecimal, for MID 255
@@ -92,16 +98,30 @@ int main(int argc, char* argv[]) {
 	else if (s.compare("FINE") == 0) log.setLevel(FINE);
 	else if (s.compare("FINER") == 0) log.setLevel(FINER);
 	else if (s.compare("FINEST") == 0) log.setLevel(FINEST);
-	/// 6- Opens the OSP binary file
-	FILE* inFile;
+	/// 6- Opens the OSP binary file mapping it into memory, or as a FILE if it cannot be mapped (f.e. "-" for stdin, or a pipe)
+	///    or it is gzip compressed (decompressed while read) or in the container format
+	FILE* inFile = NULL;
+	OSPMappedSource mappedSource;
+	OSPSource* source = &mappedSource;
 	string fileName = parser.getOperator (OSPF);
-	if ((inFile = fopen(fileName.c_str(), "rb")) == NULL) {
-		log.severe("Cannot open file " + fileName);
-		return 2;
+	if (fileName.compare("-") == 0 || !mappedSource.open(fileName) || mappedSource.isGzipped() || mappedSource.isContainer()) {
+		mappedSource.close();
+		if ((inFile = openBinaryFile(fileName, false)) == NULL) {
+			log.severe("Cannot open file " + fileName);
+			return 2;
+		}
+		source = newOSPStreamSource(inFile);
 	}
 	/// 7- Call extractMsgs to extract messages from the binary OSP file and print contents
-	int n = extractMsgs(inFile, &log);
-	fclose(inFile);
+	int n = extractMsgs(source, &log);
+	if (inFile == NULL && mappedSource.tell() < mappedSource.fileSize())
+		log.warning("Wrong message length found at offset " + to_string(mappedSource.tell()) +
+					". Data after it not processed (see OSPCheck to repair the file)");
+	if (inFile != NULL) {
+		logOSPStreamSource(source, fileName, false, &log);
+		delete source;
+		closeBinaryFile(inFile);
+	}
 	log.info("End of data extraction. Messages read: " + to_string((long long) n));
 	return 0;
 }
@@ -109,34 +129,44 @@ int main(int argc, char* argv[]) {
  * extracts OSP messages contained in a OSP binary file and prints relevant data to stdout.
  * The OSP binary file contain OSP messages (see SiRF IV ICD for details) 
  *
- * @param inFile the pointer to the OSP binary FILE to read
+ * @param source the pointer to the OSPSource providing messages from the OSP binary file
  * @param plog the pointer to the Logger object
  * @return the number of messages read
  */
-int extractMsgs(FILE* inFile, Logger* plog) {
+int extractMsgs(OSPSource* source, Logger* plog) {
 	OSPMessage message;
+	MID2Layout mid2;
+	MID7Layout mid7;
+	MID8Layout mid8;
+	MID15Layout mid15;
+	MID28Layout mid28;
 	int mid;
 	int nMessages = 0;
+	int nErrors = 0;	//messages with decoding errors (wrong length, or data requested beyond its payload)
+	OSPContainerSource* v2Source = dynamic_cast<OSPContainerSource*>(source);
 	///For each input message, the following data are printed:
-	while (message.fill(inFile)) {
+	while (source->fill(message)) {
 		nMessages++;
 		mid = message.get();
+		/// - for messages from container files, the host time when they were captured
+		if (v2Source != NULL) printf("HT:%lld;", v2Source->hostTime());
 		/// - for all messages, MID and payload length
 		printf("MID:%3d;Ln:%3d;", mid, message.payloadLen());
 		switch (mid) {
 		case 2:		/// - MID 2, solution data: X, Y, Z, vX, vY, vZ, week, TOW and satellites used
-			printf("X:%8d;",message.getInt());
-			printf("Y:%8d;",message.getInt());
-			printf("Z:%8d;",message.getInt());
-			printf("vX:%4hd;",message.getShort());
-			printf("vY:%4hd;",message.getShort());
-			printf("vZ:%4hd;",message.getShort());
-			message.get(); //skip Mode 1
-			message.get(); //skip HDOP2
-			message.get(); //skip Mode 2
-			printf("wk:%4hu;",message.getUShort());
-			printf("TOW:%6u",message.getUInt());
-			printf("SVs:%2d",message.get());
+			if (mid2.decode(message) != OSPOK) {
+				printf("Wrong length");
+				break;
+			}
+			printf("X:%8d;", mid2.x);
+			printf("Y:%8d;", mid2.y);
+			printf("Z:%8d;", mid2.z);
+			printf("vX:%4hd;", mid2.vX);
+			printf("vY:%4hd;", mid2.vY);
+			printf("vZ:%4hd;", mid2.vZ);
+			printf("wk:%4hu;", mid2.week);
+			printf("TOW:%6u", mid2.tow);
+			printf("SVs:%2d", mid2.svs);
 			break;
 		case 6:		/// - MID 6: SiRF and customer versions
 			unsigned int lsirf, lcust;
@@ -148,23 +178,29 @@ int extractMsgs(FILE* inFile, Logger* plog) {
 			while (lcust-- > 0) printf("%c", message.get());
 			break;
 		case 7:		/// - MID 7, Clock Status Data: week, TOW, satellites used, drift, bias, and EsT
-			printf("ewk:%3hu;", message.getUShort());
-			printf("TOW:%6u;", message.getUInt());
-			printf("SVs:%2d;", message.get());
-			printf("drft:%8u;", message.getUInt());
-			printf("bias:%8u;", message.getUInt());
-			printf("EsT:%8u", message.getUInt());
+			if (mid7.decode(message) != OSPOK) {
+				printf("Wrong length");
+				break;
+			}
+			printf("ewk:%3hu;", mid7.week);
+			printf("TOW:%6u;", mid7.tow);
+			printf("SVs:%2d;", mid7.svs);
+			printf("drft:%8u;", mid7.drift);
+			printf("bias:%8u;", mid7.bias);
+			printf("EsT:%8u", mid7.estGPSTime);
 			break;
 		case 8:		/// - MID 8, 50 BPS Data: 10 words subframe in hexadecimal
-			printf("ch:%2d;", message.get());
-			printf("SV:%2d;", message.get());
-			unsigned int word[10];
-			for(int i=0; i<10; i++) word[i] = message.getUInt();
+			if (mid8.decode(message) != OSPOK) {
+				printf("Wrong length");
+				break;
+			}
+			printf("ch:%2d;", mid8.channel);
+			printf("SV:%2d;", mid8.svID);
 			printf("TOW:%6u;sfr:%2u;pg:%2u;\n\t",
-					(word[1]>>13) & 0x1FFFF,
-					(word[1]>>8) & 0x07,
-					(word[2]>>24) & 0x3F );
-			for(int i=0; i<10; i++) printf("%08X;", word[i]);
+					(mid8.words[1]>>13) & 0x1FFFF,
+					(mid8.words[1]>>8) & 0x07,
+					(mid8.words[2]>>24) & 0x3F );
+			for(int i=0; i<10; i++) printf("%08X;", mid8.words[i]);
 			break;
 		case 11:	/// - MID 11, Command Acknowledgment
 			printf("ack:%3d", message.get());
@@ -173,25 +209,33 @@ int extractMsgs(FILE* inFile, Logger* plog) {
 			printf("nack:%3d", message.get());
 			break;
 		case 15:	/// - MID 15, Ephemeris Data with compact subframes 1, 2 & 3, in response to poll
-			printf("SV:%2d\n", message.get());
+			if (mid15.decode(message) != OSPOK) {
+				printf("Wrong length");
+				break;
+			}
+			printf("SV:%2d\n", mid15.svID);
 			for(int i=0; i<3; i++) {
 				printf("\t");
-				for (int j=0; j<15; j++) printf(" %04hX", message.getUShort());
+				for (int j=0; j<15; j++) printf(" %04hX", mid15.data[i*15+j]);
 			}
 			break;
 		case 28:	/// - MID 28, Navigation Library Measurement Data
-			printf("Ch:%2d;", message.get());
-			printf("Ttg:%8u;", message.getUInt());
-			printf("SV:%2d;", message.get());
-			printf("Tsw:%14.3f;", message.getDouble());
-			printf("Psr:%14.3f;", message.getDouble());
-			printf("Cfr:%14.3f;", message.getFloat());
-			printf("Cph:%14.3f;", message.getDouble());
-			printf("Trk:%3hu;", message.getUShort());
-			printf("Syn:%02X\n", message.get());
+			if (mid28.decode(message) != OSPOK) {
+				printf("Wrong length");
+				break;
+			}
+			printf("Ch:%2d;", mid28.channel);
+			printf("Ttg:%8u;", mid28.timeTag);
+			printf("SV:%2d;", mid28.svID);
+			printf("Tsw:%14.3f;", mid28.gpsSWTime);
+			printf("Psr:%14.3f;", mid28.pseudorange);
+			printf("Cfr:%14.3f;", mid28.carrierFrequency);
+			printf("Cph:%14.3f;", mid28.carrierPhase);
+			printf("Trk:%3hu;", mid28.timeInTrack);
+			printf("Syn:%02X\n", mid28.syncFlags);
 			printf("\tCN0:");
-			for (int i=0; i<10; i++) printf("%3d;", message.get());
-			printf("\n\tDri:%5hu", message.getUShort());
+			for (int i=0; i<10; i++) printf("%3d;", mid28.cn0[i]);
+			printf("\n\tDri:%5hu", mid28.deltaRangeInterval);
 			break;
 		case 50:	/// - MID 50, SBAS Parameters
 			printf("SBASsv:%3d;", message.get());
@@ -221,7 +265,9 @@ int extractMsgs(FILE* inFile, Logger* plog) {
 			break;
 		}
 		printf("\n");
+		if (message.getStatus() != OSPOK) nErrors++;
 	}
+	if (nErrors > 0) plog->warning("Messages with decoding errors: " + to_string((long long) nErrors));
 	return nMessages;
 }
 
@@ -7,13 +7,14 @@
  *	- -b BAUD or --baud=BAUD : Set serial port baud rate. Default value BAUD = 57600
  *	- -d DURATION or --duration=DURATION : Duration of acquisition period, in minutes. Default value DURATION = 5
  *	- -e or --ephemeris : Capture GPS ephemeris data (MID15). Default value EPHEM=TRUE
- *	- -f BFILE or --binfile=BFILE : OSP binary output file. Default value BFILE = 20150126_205513.OSP
+ *	- -f BFILE or --binfile=BFILE : OSP binary output file ("-" for stdout). Default value BFILE = 20150126_205513.OSP
  *	- -g or --GPS50bps : Capture GPS 50bps nav message (MID8). Default value G50BPS=FALSE
  *	- -h or --help : Show usage data. Default value HELP=FALSE
  *	- -i OBSINT or --interval=OBSINT : Observation interval (in seconds) for epoch data. Default value OBSINT = 5
  *	- -l LOGLEVEL or --llevel=LOGLEVEL : Maximum level to log (SEVERE, WARNING, INFO, CONFIG, FINE, FINER, FINEST). Default value LOGLEVEL = INFO
  *	- -p COMPORT or --port=COMPORT : Serial port name where receiver is connected. Default value COMPORT = COM35
  *	- -s MID or --stop=MID : Stop epoch data acquisition when this MID (Message ID) arrives. Default value MID = 7
+ *	- -x or --container : Write the OSP file in the container format, with capture times and block checksums. Default value CONTAINER=FALSE
  *
  *Copyright 2015 Francisco Cancillo
  *<p>
@@ -32,11 +33,13 @@
 //from CommonClasses
 #include "ArgParser.h"
 #include "Logger.h"
+#include "OSPContainer.h"
 #include "Utilities.h"
 //from SerialTxRx
 #include "SerialTxRx.h"
 //standard
 #include <stdio.h>
+#include <chrono>
 
 using namespace std;
 
@@ -46,10 +49,10 @@ const string CMDLINE = "OSPDataLogger.exe {options}";
 ///The parser object to store options and operators passed in the comman line
 ArgParser parser;
 //Metavariables for options
-int BAUD, DURATION, BFILE, G50BPS, HELP, EPHEM, OBSINT, LOGLEVEL, COMPORT, MID;
+int BAUD, DURATION, BFILE, G50BPS, HELP, EPHEM, OBSINT, LOGLEVEL, COMPORT, MID, CONTAINER;
 //@endcond 
 //functions in this file
-int acquireBin(SerialTxRx, FILE*, int, int, Logger*);
+int acquireBin(SerialTxRx, OSPWriter*, int, int, Logger*);
 
 /**main
  * gets the command line arguments, set parameters accordingly and triggers the data acquisition from the receiver.
@@ -65,6 +68,8 @@ int acquireBin(SerialTxRx, FILE*, int, int, Logger*);
  *<p>
  * The binary OSP output files containt messages where head, check and tail have been removed, that is, the data for each
  * message consists of the two bytes of the payload length and the payload bytes.
+ * Optionally, the output file can be written in the container format (see OSPWriter), where the computer time when
+ * each message was received is recorded, and data are grouped in blocks with checksums.
  *<p>
  * The SynchroRX command line provided in this project can be used to check and set the receiver state: baud rate,
  * accept/send OSP or NMEA messages, etc.
@@ -95,13 +100,14 @@ int main(int argc, char** argv) {
 	time (&rawtime);
 	timeinfo = localtime (&rawtime);
 	strftime (fileName, sizeof fileName,"%Y%m%d_%H%M%S.OSP", timeinfo);
+	CONTAINER = parser.addOption("-x", "--container", "CONTAINER", "Write the OSP file in the container format, with capture times and block checksums", false);
 	MID = parser.addOption("-s", "--stop", "MID", "Stop epoch data acquisition when this MID (Message ID) arrives", "7");
 	COMPORT = parser.addOption("-p", "--port", "COMPORT", "Serial port name where receiver is connected", "COM35");
 	LOGLEVEL = parser.addOption("-l", "--llevel", "LOGLEVEL", "Maximum level to log (SEVERE, WARNING, INFO, CONFIG, FINE, FINER, FINEST)", "INFO");
 	OBSINT = parser.addOption("-i", "--interval", "OBSINT", "Observation interval (in seconds) for epoch data", "5");
 	HELP = parser.addOption("-h", "--help", "HELP", "Show usage data", false);
 	G50BPS = parser.addOption("-g", "--GPS50bps", "G50BPS", "Capture GPS 50bps nav message (MID8)", false);
-	BFILE = parser.addOption("-f", "--binfile", "BFILE", "OSP binary output file", fileName);
+	BFILE = parser.addOption("-f", "--binfile", "BFILE", "OSP binary output file (- for stdout)", fileName);
 	EPHEM = parser.addOption("-e", "--ephemeris", "EPHEM", "Capture GPS ephemeris data (MID15)", true);
 	DURATION = parser.addOption("-d", "--duration", "DURATION", "Duration of acquisition period, in minutes", "5");
 	BAUD = parser.addOption("-b", "--baud", "BAUD", "Set serial port baud rate", "57600");
@@ -187,14 +193,19 @@ int main(int argc, char** argv) {
 		return 4;
 	}
 	/// 8- Creates the output binary file
-	FILE *outFile = fopen(parser.getStrOpt(BFILE).c_str(), "wb");
+	FILE *outFile = openBinaryFile(parser.getStrOpt(BFILE), true);
 	if (outFile == NULL) {
 		log.severe("Cannot create the binary output file " + string(fileName));
 		return 5;
 	}
 	/// 9- Calls acquireBin to acquire and record data form receiver
-	int n = acquireBin(port, outFile, nEpochs * 20, nEpochs, &log);
-	fclose(outFile);
+	OSPWriter writer(outFile, parser.getBoolOpt(CONTAINER));
+	int n = acquireBin(port, &writer, nEpochs * 20, nEpochs, &log);
+	if (!writer.flush()) {
+		log.severe("Cannot write the binary output file");
+		n = -1;
+	}
+	closeBinaryFile(outFile);
 	port.closePort();
 	return n>0? 0:65;
 }
@@ -207,13 +218,13 @@ int main(int argc, char** argv) {
  * - a write error happens
  * 
  *@param  port the SerialTxRx object used to communicate with the receiver
- *@param  outFile the binary output file to record the messages received from receiver
+ *@param  writer the writer of the binary output file to record the messages received from receiver
  *@param maxMsgs the maximum number of messages to be recorded
  *@param maxEpochs the maximum number of epochs to be recorded
  *@param plog the pinter to the Logger
  *@return the number of correct messages read and written; if <0 an error happen when writing
  */
-int acquireBin(SerialTxRx port, FILE *outFile, int maxMsgs, int maxEpochs, Logger* plog) {
+int acquireBin(SerialTxRx port, OSPWriter* writer, int maxMsgs, int maxEpochs, Logger* plog) {
 	/**The acquireBin process sequence follows:*/
 	string txtToLog;
 	int lastMsgMID = stoi(parser.getStrOpt(MID));
@@ -237,11 +248,11 @@ int acquireBin(SerialTxRx port, FILE *outFile, int maxMsgs, int maxEpochs, Logge
 		switch (readResult) {
 		case 0:	//message is correct
 			txtToLog += "OK";
-			/// - Update counters and write message to OSP file
+			/// - Update counters and write message to OSP file, with the computer time when it was received
 			nMsgs++;
 			if (port.payBuff[0] == lastMsgMID) nEpochs++;
-			if ((fwrite(port.paylenBuff, 1, 2, outFile) != 2) ||
-				(fwrite(port.payBuff, 1, port.payloadLen, outFile) != port.payloadLen)) {
+			if (!writer->write(port.payBuff, port.payloadLen,
+					chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count())) {
 				plog->severe(txtToLog + ". Write error");
 				plog->info("nMsgs:" + to_string((long long) nMsgs) + " nEpochs:" + to_string((long long) nEpochs));
 				return -1;
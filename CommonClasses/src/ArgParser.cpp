@@ -306,8 +306,7 @@ void  ArgParser::parseArgs (int argc, char** argv) {
 		name = string(argv[i++]);
 		if (i < argc) value = string(argv[i]);
 		else value.clear();
-		if (name.at(0) == '-') {	//It would be an Option: verify it
-			if(name.size() < 2) throw name + MSG_UnknOption;	//nothing follows -
+		if (name.at(0) == '-' && name.size() > 1) {	//It would be an Option: verify it (a single - is an operand, f.e. stdin)
 			if (name.at(1) == '-') {	//It would be a long name Option: verify it
 				if(name.size() < 3) throw name + MSG_UnknOption;//nothing follows --
 				n = name.find('=', 2);		//find value separator
@@ -330,8 +329,8 @@ void  ArgParser::parseArgs (int argc, char** argv) {
 			else {		//It would be a short name Option: verify it
 				if (!isShortOption(name, false)) throw name + MSG_UnknOption;	//name not in the list
 				if (isShortOption(name, true)) {	//this arg is a string short option
-					//value must be follow (not empty, cannot start with - to be a true value)
-					if (value.empty() || value.at(0)=='-') throw name + MSG_ValueNotSet;
+					//value must be follow (not empty, cannot start with - to be a true value, except a single - for stdin/stdout)
+					if (value.empty() || (value.at(0)=='-' && value.size() > 1)) throw name + MSG_ValueNotSet;
 					//set data for a string short name option
 					opt = Option(-1, name, value, false, true);
 					i++;	//compute index of next argv to examine
@@ -0,0 +1,33 @@
+/** @file FileOffset.h
+ * Contains the definition of the macros used to set and get 64 bits offsets in FILEs in any platform.
+ *
+ *Copyright 2015 Francisco Cancillo
+ *<p>
+ *This file is part of the RXtoRINEX tool.
+ *<p>
+ *RXtoRINEX is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *RXtoRINEX is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ *warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *See the GNU General Public License for more details.
+ *<p>
+ *A copy of the GNU General Public License can be found at <http://www.gnu.org/licenses/>.
+ *
+ *V1.0	First release
+ */
+#pragma once
+
+#include <stdio.h>
+
+#ifdef _WIN32
+///Sets the position in a FILE given as a 64 bits offset
+#define FSEEK64 _fseeki64
+///Gets the position in a FILE as a 64 bits offset
+#define FTELL64 _ftelli64
+#else
+#include <sys/types.h>
+///Sets the position in a FILE given as a 64 bits offset
+#define FSEEK64 fseeko
+///Gets the position in a FILE as a 64 bits offset
+#define FTELL64 ftello
+#endif
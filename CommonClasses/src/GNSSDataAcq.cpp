@@ -9,6 +9,10 @@
 
 #include "GNSSDataAcq.h"
 
+//from CommonClasses
+#include "OSPValidator.h"
+#include "GPSParity.h"
+
 /**Construct a GNSSDataAcq object using parameters passed.
  *
  *@param rcv the receiver name
@@ -19,16 +23,209 @@
 GNSSDataAcq::GNSSDataAcq(string rcv, int minxfix, FILE* f, Logger * pl) {
 	receiver = rcv;
 	minSVSfix = minxfix;
-	ospFile = f;
+	source = ownSource = new OSPFileSource(f);
+	index = NULL;
+	pushedBack = false;
+	countErrors = true;
+	decodeErrors = 0;
+	singlePassEpochs = 0;
+	recording = replaying = false;
+	replayPos = 0;
+	windowSet = false;
+	windowFrom = windowTo = 0;
+	windowStart = 0;
+	windowEntry = 0;
+	windowEndEntry = -1;
+	sessionPos = 0;
+	epochFixSet = epochMaskSet = false;
+	mid28InEpoch = 0;
+	mid28TimeTag = 0.0;
+	for (int t=0; t<MID28OBSTYPES; t++) mid28Obs.obsType.push_back(GNSSsystem::getObsTypeId(MID28OBSTYPE[t]));
+	log = pl;
+}
+
+/**Construct a GNSSDataAcq object using parameters passed.
+ *
+ *@param rcv the receiver name
+ *@param minxfix the minimum of satellites required for a fix to be considered
+ *@param src the OSPSource providing the OSP messages, like an OSPMappedSource
+ *@param pl a pointer to the Logger to be used to record logging messages
+ */
+GNSSDataAcq::GNSSDataAcq(string rcv, int minxfix, OSPSource* src, Logger * pl) {
+	receiver = rcv;
+	minSVSfix = minxfix;
+	source = src;
+	ownSource = NULL;
+	index = NULL;
+	pushedBack = false;
+	countErrors = true;
+	decodeErrors = 0;
+	singlePassEpochs = 0;
+	recording = replaying = false;
+	replayPos = 0;
+	windowSet = false;
+	windowFrom = windowTo = 0;
+	windowStart = 0;
+	windowEntry = 0;
+	windowEndEntry = -1;
+	sessionPos = 0;
+	epochFixSet = epochMaskSet = false;
+	mid28InEpoch = 0;
+	mid28TimeTag = 0.0;
+	for (int t=0; t<MID28OBSTYPES; t++) mid28Obs.obsType.push_back(GNSSsystem::getObsTypeId(MID28OBSTYPE[t]));
 	log = pl;
-	for (int i=0; i<MAXCHANNELS; i++)
-		for (int j=0; j<MAXSUBFR; j++)
-			subfrmCh[i][j].sv = 0;
 }
 
 /**Destroys a GNSSDataAcq object
  */
 GNSSDataAcq::~GNSSDataAcq(void) {
+	if (ownSource != NULL) delete ownSource;
+}
+
+/**rewind sets the message source at its first message to allow a new data acquisition from it.
+ * In single pass mode, the source is not rewound: messages recorded during header data acquisition
+ * are provided again before continuing with the messages in the source.
+ * When the source has been positioned at the start of a time window, it is set again at this position,
+ * and the session messages before it are provided again.
+ *
+ * @return true if the source has been rewound, false otherwise
+ */
+bool GNSSDataAcq::rewind() {
+	pushedBack = false;
+	if (singlePassEpochs > 0) {
+		replayPos = 0;
+		replaying = true;
+		return true;
+	}
+	if (windowStart > 0) {
+		sessionPos = 0;
+		return source->seek(windowStart);
+	}
+	return source->rewind();
+}
+
+/**setIndex sets the index of messages in the source to be used for header data acquisition.
+ * When an index is available, only messages containing header data are read from the source.
+ *
+ * @param idx the index of the messages in the source, or NULL if no index is available
+ */
+void GNSSDataAcq::setIndex(OSPIndex* idx) {
+	index = idx;
+}
+
+/**setSinglePass sets the single pass mode, where each message in the source is read only once.
+ * In this mode, messages read to acquire RINEX header data are recorded to be replayed after rewind. It allows
+ * acquisition from sources that cannot be rewound. As recorded messages are kept in memory, the number of epochs
+ * recorded is limited.
+ * The index, if set, is not used for RINEX header data acquisition.
+ *
+ * @param nEpochs the maximum number of valid epochs to record for header data acquisition, or 0 to unset single pass mode
+ */
+void GNSSDataAcq::setSinglePass(int nEpochs) {
+	singlePassEpochs = nEpochs > 0? nEpochs: 0;
+}
+
+/**selectMessages sets the source to provide only the messages used to acquire the data requested. Other messages
+ * are skipped by the source without copying their payload.
+ * MID6, MID7 and MID19 messages are always selected, as they are needed to set time windows.
+ *<p>
+ * It shall be called before acquiring any data, and the data acquired thereafter shall be of the kind stated.
+ *
+ * @param forRinex true if RINEX data will be acquired, false if RTK data will be acquired
+ * @param useMID15 true if MID15 messages will be used for RINEX navigation data
+ * @param useMID8 true if MID8 messages will be used for RINEX navigation data
+ */
+void GNSSDataAcq::selectMessages(bool forRinex, bool useMID15, bool useMID8) {
+	vector<int> mids;
+	mids.push_back(MID2Layout::MID);
+	mids.push_back(6);
+	mids.push_back(MID7Layout::MID);
+	mids.push_back(MID19Layout::MID);
+	if (forRinex) {
+		mids.push_back(MID28Layout::MID);
+		if (useMID15) mids.push_back(MID15Layout::MID);
+		if (useMID8) mids.push_back(MID8Layout::MID);
+	}
+	source->setWantedMIDs(mids);
+}
+
+/**setTimeWindow sets the GPS time window of the epochs to acquire. Epochs before it are skipped, and acquisition
+ * finishes after the last epoch in the window.
+ *<p>
+ * When an index is available, or the source is a mapped file, the source is positioned at the first message of the first
+ * epoch in the window, found by a binary search in the index, or bisecting the file. Session messages sent by the receiver
+ * only at the beginning of the session (MID6 with receiver identification and MID19 with masks) are read to be provided
+ * before the messages in the window. Otherwise, messages before the window are read, and epochs in them skipped.
+ *<p>
+ * It shall be called after setting the index, if any, and before acquiring header data.
+ *
+ * @param fromWeek the GPS week of the window begin
+ * @param fromTow the GPS TOW, in seconds, of the window begin
+ * @param toWeek the GPS week of the window end
+ * @param toTow the GPS TOW, in seconds, of the window end
+ * @return true if the source has been positioned at the window start, false if messages before it will be read
+ */
+bool GNSSDataAcq::setTimeWindow(int fromWeek, double fromTow, int toWeek, double toTow) {
+	unsigned int fromTow100 = (unsigned int) (fromTow * 100.0 + 0.5);	//TOW in messages is scaled by 100
+	unsigned int toTow100 = (unsigned int) (toTow * 100.0 + 0.5);
+	windowSet = true;
+	windowFrom = fromWeek * OSPWEEKTOW + fromTow100;
+	windowTo = toWeek * OSPWEEKTOW + toTow100;
+	OSPMappedSource* mappedSource = dynamic_cast<OSPMappedSource*>(source);
+	bool indexed = index != NULL && index->size() > 0;
+	if (indexed) {
+		int last = (int) index->size() - 1;
+		windowEntry = index->findEpoch(fromWeek, fromTow100);
+		windowEndEntry = index->findEpoch(toWeek, toTow100 + 1);
+		if (windowEntry <= last) windowStart = index->entry(windowEntry).offset;
+		else windowStart = index->entry(last).offset + 2 + index->entry(last).length;
+		//check the index against the first message in the window provided by the source (others are skipped by it)
+		int check = windowEntry;
+		while (check <= last && !source->isWantedMID(index->entry(check).mid)) check++;
+		indexed = check > last || fillIndexed(check);	//false if the index does not match the file
+	}
+	if (!indexed) {
+		if (mappedSource == NULL) return false;
+		OSPValidator validator;
+		windowStart = validator.findEpoch(mappedSource->fileData(), mappedSource->fileSize(), fromWeek, fromTow100);
+	}
+	//get the session messages sent before the first epoch
+	sessionMsgs.clear();
+	sessionPos = 0;
+	pushedBack = false;
+	if (windowStart > 0 && source->rewind()) {
+		while (source->tell() < windowStart && source->fill(message)) {
+			if (source->tell() > windowStart) break;	//messages skipped by the source reached the window
+			int mid = message.get();
+			if (mid == MID7Layout::MID) break;
+			if (mid == 6 || mid == MID19Layout::MID) {
+				unsigned int length = message.payloadLen();
+				sessionMsgs.push_back((unsigned char) (length >> 8));
+				sessionMsgs.push_back((unsigned char) (length & 0xFF));
+				sessionMsgs.insert(sessionMsgs.end(), message.payloadData(), message.payloadData() + length);
+			}
+		}
+	}
+	return source->seek(windowStart);
+}
+
+/**getDecodeErrors gets the number of messages with decoding errors (wrong length, or data inconsistent with it)
+ * found during epoch data acquisition.
+ * Messages read during header data acquisition are not accounted, as they would be decoded again.
+ *
+ * @return the number of messages with decoding errors
+ */
+unsigned int GNSSDataAcq::getDecodeErrors() {
+	return decodeErrors;
+}
+
+/**decodeError logs the decoding error found in the current message and accounts it.
+ *
+ * @param error the text describing the error
+ */
+void GNSSDataAcq::decodeError(string error) {
+	log->info(error);
+	if (countErrors) decodeErrors++;
 }
 
 /**acqHeaderData extracts data from the binary file for a RINEX file header.
@@ -38,21 +235,40 @@ GNSSDataAcq::~GNSSDataAcq(void) {
  * - the time of first epoch contained in the first valid MID7 message
  * - the measurement interval computed as the time difference between two consecutive valid MID7 
  * The method iterates over the input file extracting messages until above describe data are acquired
- * or it reaches the end of file.
+ * or it reaches the end of file. When an index is available, only MID2, MID6 and MID7 messages are read.
+ * In single pass mode, all messages read are recorded, and it stops after reading the number of valid epochs stated
+ * (those with time data accepted by getMID7TimeData). Reaching this limit before the position, the first epoch time
+ * and the interval are known is logged as a severe error.
+ * When a time window is set, epochs before it are skipped (and messages recorded for them discarded), and
+ * acquisition stops at the first epoch after it.
  * It logs at FINE level a message stating which header data have been acquired or not.
  *
  * @param rinex the RinexData object where data got from receiver will be placed
  * @return	true if all above described header data are properly extracted, false otherwise
  */
 bool GNSSDataAcq::acqHeaderData(RinexData& rinex) {
+	const int headerMIDs[] = {2, 6, 7, 0};
 	bool rxIdSet = false;	//identification of receiver not set
 	bool apxSet = false;	//approximate position not set
 	bool frsEphSet = false;	//first epoch time not set
 	bool intrvBegin = false; //interval begin time has been stated		
 	bool intrvSet = false;	//observations interval not set
+	bool windowPassed = false;	//an epoch after the time window has been read
 	int mid;
-	while (message.fill(ospFile) &&		//there are messages in the binary file
-			!(apxSet && rxIdSet && frsEphSet && intrvSet)) {	//not all header data have been adquired
+	long long time;
+	int next = windowEntry;	//next index entry to check, if index available
+	bool validEpoch;		//the MID7 read has valid time data
+	int epochs = 0;			//number of valid epochs read
+	countErrors = false;
+	OSPIndex* idx = index;
+	if (singlePassEpochs > 0) {
+		index = NULL;		//all messages shall be read and recorded
+		recording = true;
+	}
+	while (fillHeaderMsg(next, headerMIDs) &&		//there are messages in the binary file
+			!(apxSet && rxIdSet && frsEphSet && intrvSet) &&	//not all header data have been adquired
+			!windowPassed &&	//the time window has not been passed
+			!(singlePassEpochs > 0 && epochs >= singlePassEpochs)) {	//not all epochs allowed have been read
 		mid = message.get();		//get first byte (MID)
 		switch(mid) {
 		case 2:	//collect first MID2 data to obtain approximate position (X, Y, Z)
@@ -62,18 +278,38 @@ bool GNSSDataAcq::acqHeaderData(RinexData& rinex) {
 			if (!rxIdSet) rxIdSet = getMID6RxData(rinex);
 			break;
 		case 7: //collect MID7 data for first epoch and the following MID7 data for interval
+			time = mid7Time();
+			if (!inWindow(time)) {
+				if (time > windowTo) windowPassed = true;
+				else {	//the position, if acquired, belongs to an epoch before the window
+					apxSet = false;
+					if (recording) recorded.clear();	//messages of epochs before the window are not needed
+				}
+				break;
+			}
 			if (!frsEphSet) {
-				intrvBegin = frsEphSet = getMID7TimeData(rinex);
-				rinex.setFistObsTime();
+				validEpoch = intrvBegin = frsEphSet = getMID7TimeData(rinex);
+				if (frsEphSet) rinex.setFistObsTime();
 			}
-			else if (!intrvBegin) intrvBegin = getMID7TimeData(rinex);
-			else if (!intrvSet) intrvBegin = intrvSet = getMID7Interval(rinex);
+			else if (!intrvBegin) validEpoch = intrvBegin = getMID7TimeData(rinex);
+			else if (!intrvSet) validEpoch = intrvBegin = intrvSet = getMID7Interval(rinex);
+			else {	//only the receiver identification is missing: check the epoch keeping the current epoch time
+				MID7Layout mid7;
+				validEpoch = mid7.decode(message) == OSPOK && (int) mid7.svs >= minSVSfix;
+			}
+			if (validEpoch) epochs++;
 			break;
 		default:
 			break;
 		}
 		//printf("mid: %d rxIdSet=%s apxSet=%s frsEphSet=%s\n", mid, rxIdSet? "Y":"N", apxSet? "Y":"N", frsEphSet? "Y":"N");
 	}
+	if (singlePassEpochs > 0 && epochs >= singlePassEpochs && !(apxSet && frsEphSet && intrvSet))
+		log->severe("Position, first epoch time or interval not acquired in the " + to_string((long long) epochs) +
+					" epochs recorded in single pass mode");
+	recording = false;
+	if (singlePassEpochs > 0) index = idx;
+	countErrors = true;
 	//log data sources available or not
 	string logMessage = "RINEX header data available: AproxPosition ";
 	logMessage += apxSet?  "YES": "NO";
@@ -95,6 +331,10 @@ bool GNSSDataAcq::acqHeaderData(RinexData& rinex) {
  *<p>
  * The method iterates over the input file extracting messages until above describe data are acquired
  * or it reaches the end of file.
+ * When an index is available, only MID2 messages from the beginning (for the first time) and from the end (for the last time),
+ * and MID19 messages from the end, are read until data are acquired. If the index does not match the file, it is dropped
+ * and the remaining data are acquired reading the file from its beginning.
+ * When a time window is set, only MID2 messages with a time in the window are taken into account.
  *<p>
  * It logs at FINE level a message stating which header data have been acquired or not.
  *
@@ -105,12 +345,38 @@ bool GNSSDataAcq::acqHeaderData(RTKobservation& rtko) {
 	bool maskSet = false;	//mask data set
 	bool fetSet = false;	//first epoch time set
 	int mid;
+	int n;
+	countErrors = false;
+	if (index != NULL) {
+		unsigned int endEntry = windowEndEntry >= 0? (unsigned int) windowEndEntry: index->size();
+		//acquire first epoch time from the first valid MID2
+		for (n = index->findFirst(2, windowEntry); !fetSet && n >= 0 && n < (int) endEntry; n = index->findFirst(2, n + 1)) {
+			if (!fillIndexed(n)) break;		//the index has been dropped
+			if (message.get() == 2 && inWindow(mid2Time()) && getMID2PosData(rtko)) {
+				rtko.setStartTime();
+				fetSet = true;
+			}
+		}
+		//acquire last epoch time from the last valid MID2
+		for (n = index != NULL? index->findLast(2, endEntry): -1; fetSet && n >= 0; n = index->findLast(2, n)) {
+			if (!fillIndexed(n)) break;
+			if (message.get() == 2 && inWindow(mid2Time()) && getMID2PosData(rtko)) {
+				rtko.setEndTime();
+				break;
+			}
+		}
+		//acquire mask data from the last valid MID19
+		for (n = index != NULL? index->findLast(19, endEntry): -1; !maskSet && n >= 0; n = index->findLast(19, n)) {
+			if (!fillIndexed(n)) break;
+			maskSet = message.get() == 19 && getMID19Masks(rtko);
+		}
+	}
 	//acquire mask data and first and last epoch time
-	while (message.fill(ospFile)) {	//there are messages in the binary file
+	while (index == NULL && readMessage()) {	//there are messages in the binary file
 		mid = message.get();		//get first byte (MID)
 		switch(mid) {
 		case 2:
-			if (getMID2PosData(rtko)) {
+			if (inWindow(mid2Time()) && getMID2PosData(rtko)) {
 				if (!fetSet)	{
 					rtko.setStartTime();
 					fetSet = true;
@@ -125,7 +391,29 @@ bool GNSSDataAcq::acqHeaderData(RTKobservation& rtko) {
 			break;
 		}
 	}
-	//log data sources available or not
+	countErrors = true;
+	return logRTKHeaderData(fetSet, maskSet);
+}
+
+/**epochHeaderData tells if RTK header data have been acquired while acquiring epoch data (see acqEpochData), as done
+ * in single pass mode, where header data are not acquired in advance: the first epoch time from a valid MID2, and
+ * mask data from a valid MID19.
+ *<p>
+ * It logs at FINE level a message stating which header data have been acquired or not.
+ *
+ * @return true if all above described header data have been acquired, false otherwise
+ */
+bool GNSSDataAcq::epochHeaderData() {
+	return logRTKHeaderData(epochFixSet, epochMaskSet);
+}
+
+/**logRTKHeaderData logs at FINE level a message stating which RTK header data have been acquired or not.
+ *
+ * @param fetSet true if the first epoch time has been acquired
+ * @param maskSet true if mask data have been acquired
+ * @return true if all header data have been acquired, false otherwise
+ */
+bool GNSSDataAcq::logRTKHeaderData(bool fetSet, bool maskSet) {
 	string logMessage = "RTKO header data available: Fist epoch time ";
 	logMessage += fetSet?  "YES": "NO";
 	logMessage += ";Mask data ";
@@ -134,6 +422,133 @@ bool GNSSDataAcq::acqHeaderData(RTKobservation& rtko) {
 	return maskSet && fetSet;
 }
 
+/**readMessage fills the message buffer with the next message to be processed.
+ * If the current message was pushed back, it is provided again without reading the source.
+ * If messages are being replayed, the next recorded one is provided.
+ * Otherwise the next session message, if any remains, or the next message in the source is provided, and recorded if needed.
+ * Thus each message in the source is read only once.
+ *
+ * @return true if a message is available, false otherwise (end of source or read error)
+ */
+bool GNSSDataAcq::readMessage() {
+	if (pushedBack) {
+		pushedBack = false;
+		message.restart();
+		return true;
+	}
+	if (replaying) {
+		if (replayPos + 2 <= recorded.size()) {
+			unsigned int length = (recorded[replayPos] << 8) | recorded[replayPos+1];
+			message.setView(&recorded[replayPos+2], length);
+			replayPos += 2 + length;
+			return true;
+		}
+		//all recorded messages have been replayed
+		replaying = false;
+		vector<unsigned char>().swap(recorded);
+		replayPos = 0;
+	}
+	if (sessionPos < sessionMsgs.size()) {	//session messages are provided before the ones in the time window
+		unsigned int length = (sessionMsgs[sessionPos] << 8) | sessionMsgs[sessionPos+1];
+		message.setView(&sessionMsgs[sessionPos+2], length);
+		sessionPos += 2 + length;
+	} else if (!source->fill(message)) return false;
+	if (recording) {
+		unsigned int length = message.payloadLen();
+		recorded.push_back((unsigned char) (length >> 8));
+		recorded.push_back((unsigned char) (length & 0xFF));
+		recorded.insert(recorded.end(), message.payloadData(), message.payloadData() + length);
+	}
+	return true;
+}
+
+/**pushBack returns the current message to the message stream, so it will be provided by the next readMessage call.
+ * Only one message can be pushed back, and no other message shall be read from the source before it is provided again.
+ */
+void GNSSDataAcq::pushBack() {
+	pushedBack = true;
+}
+
+/**fillHeaderMsg fills the message buffer with the next message to be used for header data acquisition.
+ * When an index is available, only messages having one of the given MIDs are read from the source,
+ * after the session messages, if any, and up to the end of the time window, if set.
+ * Otherwise, or if the index is dropped because it does not match the source, the next message in the source is read.
+ *
+ * @param next the position of the next index entry to check. It is updated after reading the message
+ * @param mids the list of wanted MIDs, ended by 0
+ * @return true if a message has been read, false otherwise (end of source or read error)
+ */
+bool GNSSDataAcq::fillHeaderMsg(int& next, const int* mids) {
+	if (index == NULL || sessionPos < sessionMsgs.size()) return readMessage();
+	int last = windowEndEntry >= 0? windowEndEntry: (int) index->size();
+	for (; next < last; next++)
+		for (int i=0; mids[i] != 0; i++)
+			if (index->entry(next).mid == mids[i]) return fillIndexed(next++) || (index == NULL && readMessage());
+	return false;
+}
+
+/**mid7Time gets the GPS time in the current message, a MID7, to check it against the time window.
+ *
+ * @return the GPS time (TOW scaled by 100, including weeks), or -1 if the message cannot be decoded
+ */
+long long GNSSDataAcq::mid7Time() {
+	MID7Layout mid7;
+	if (mid7.decode(message) != OSPOK) return -1;
+	return mid7.week * OSPWEEKTOW + mid7.tow;
+}
+
+/**mid2Time gets the GPS time in the current message, a MID2, to check it against the time window.
+ * As MID2 weeks do not include rollovers, one is added (as in getMID2PosData).
+ *
+ * @return the GPS time (TOW scaled by 100, including weeks), or -1 if the message cannot be decoded
+ */
+long long GNSSDataAcq::mid2Time() {
+	MID2Layout mid2;
+	if (mid2.decode(message) != OSPOK) return -1;
+	return (mid2.week + 1024) * OSPWEEKTOW + mid2.tow;
+}
+
+/**inWindow checks if the given time is in the time window.
+ * Unknown times (messages that cannot be decoded) are considered in the window, to be processed as usual.
+ *
+ * @param time the GPS time (TOW scaled by 100, including weeks), or -1 if unknown
+ * @return true if no window is set, the time is unknown, or it is in the window; false otherwise
+ */
+bool GNSSDataAcq::inWindow(long long time) {
+	return !windowSet || time < 0 || (time >= windowFrom && time <= windowTo);
+}
+
+/**fillIndexed fills the message buffer with the message in the given index entry.
+ * The MID and length of the message read shall be the ones in the entry. Otherwise the index does not match the
+ * source (f.e. the OSP file was modified keeping its size), and it is dropped (see dropIndex).
+ *
+ * @param n the position in the index of the message to read
+ * @return true if the message has been read, false otherwise (the index has been dropped)
+ */
+bool GNSSDataAcq::fillIndexed(int n) {
+	const OSPIndexEntry& entry = index->entry(n);
+	pushedBack = false;
+	if (source->seek(entry.offset) && source->fill(message) && message.payloadLen() == entry.length
+			&& (entry.length == 0 || message.payloadData()[0] == entry.mid)) return true;
+	dropIndex();
+	return false;
+}
+
+/**dropIndex stops using the index, because it does not match the source.
+ * Positions got from the index are discarded, and the source is rewound to read messages from its beginning.
+ */
+void GNSSDataAcq::dropIndex() {
+	log->warning("Index does not match the OSP file messages. It is not used");
+	index = NULL;
+	windowStart = 0;
+	windowEntry = 0;
+	windowEndEntry = -1;
+	sessionMsgs.clear();
+	sessionPos = 0;
+	pushedBack = false;
+	source->rewind();
+}
+
 /**acqEpochData extracts observation and time data from binary file messages for a RINEX epoch.
  * Epoch RINEX data are contained in a sequence of {MID28} [MID2] [MID7] messages.
  *<p>
@@ -157,6 +572,8 @@ bool GNSSDataAcq::acqHeaderData(RTKobservation& rtko) {
  * navigation file.
  *<p>
  * Other messages in the binary file are ignored.
+ *<p>
+ * When a time window is set, data of epochs before it are discarded, and acquisition finishes at the first epoch after it.
  *
  * @param rinex the RinexObsData object where data got from receiver will be placed
  * @param useMID15 to acquire (when true) or ignore (when false) navigation data in MID15 messages
@@ -166,13 +583,22 @@ bool GNSSDataAcq::acqHeaderData(RTKobservation& rtko) {
 bool GNSSDataAcq::acqEpochData(RinexData& rinex, bool useMID15, bool useMID8) {
 	int mid;
 	bool sameEpoch;
-	fpos_t msgPos;
 	bool dataAvailable = false;	//there are data available when at least a MID28 msg has been received
-	fgetpos(ospFile, &msgPos);	//get the current position in the binary file 
-	while (message.fill(ospFile)) {	//one message has been read from the binary file
+	long long time;
+	while (readMessage()) {	//one message has been read from the binary file
 		mid = message.get();		//get first byte (MID) from message
+		if (message.getStatus() != OSPOK) decodeError("Message without MID");
 		switch(mid) {
 		case 7:		//the Rx sends MID7 when position for current epoch is computed (after sending MID28 msgs)
+			time = mid7Time();
+			if (!inWindow(time)) {	//discard data of the epoch out of the time window
+				rinex.clearObs();
+				clearMID28NavData();
+				if (time > windowTo) return false;
+				dataAvailable = false;
+				break;
+			}
+			storeMID28NavData(rinex);
 			if (getMID7TimeData(rinex) && dataAvailable) return true;
 			break;
 		case 8:		//collect 50BPS ephemerides data in MID8
@@ -182,13 +608,14 @@ bool GNSSDataAcq::acqEpochData(RinexData& rinex, bool useMID15, bool useMID8) {
 			if (useMID15) getMID15NavData(rinex);
 			break;
 		case 28:	//collect satellite measurements from a channel in MID28
-			if (getMID28NavData(rinex, sameEpoch)) {	//message data are correct and have been stored
+			if (addMID28NavData(rinex, sameEpoch)) {	//message data are correct and have been collected
 				if (sameEpoch) {	//data belong to the same epoch as former messages
 					dataAvailable = true;
 				}
 				else {	//all data for the current epoch have been acquired, and no MID7 has arrived!
-					fsetpos(ospFile, &msgPos);	//rewind to allow further re-extraction of last message
+					pushBack();	//the message will be provided again when acquiring the next epoch
 					rinex.clearObs();	//as no MID7 has been received, the bias to apply is unknown
+					clearMID28NavData();
 					log->info("A MID28 sequence without MID7  in epoch " + to_string((long double) rinex.getGPSTime()));
 					return dataAvailable;
 				}
@@ -197,8 +624,8 @@ bool GNSSDataAcq::acqEpochData(RinexData& rinex, bool useMID15, bool useMID8) {
 		default:
 			break;
 		}
-		fgetpos(ospFile, &msgPos);
 	}
+	storeMID28NavData(rinex);
 	return  dataAvailable;
 }
 
@@ -207,17 +634,33 @@ bool GNSSDataAcq::acqEpochData(RinexData& rinex, bool useMID15, bool useMID8) {
  *<p>
  * The method skips messages from the input binary file until a MID2 message is read.
  * When this happens, it stores MID2 data in the RTKobservation object passed and returns.
+ * Masks in MID19 messages read are also stored, to allow setting header data when they are printed after epochs.
+ * Header data acquired this way are accounted (see epochHeaderData).
+ * When a time window is set, MID2 messages before it are skipped, and acquisition finishes at the first one after it.
  *
  * @param rtko the RTKobservation object where data acquired will be placed
  * @return true if epoch position data properly extracted, false otherwise
  */
 bool GNSSDataAcq::acqEpochData(RTKobservation& rtko) {
 	int mid;
-	while (message.fill(ospFile)) {	//one message has been read from the binary file
+	long long time;
+	while (readMessage()) {	//one message has been read from the binary file
 		mid = message.get();		//get first byte (MID) from message
+		if (message.getStatus() != OSPOK) decodeError("Message without MID");
 		switch(mid) {
 		case 2:		//the MID2 contains position data for this epoch
-			if (getMID2PosData(rtko)) return true;
+			time = mid2Time();
+			if (!inWindow(time)) {
+				if (time > windowTo) return false;
+				break;
+			}
+			if (getMID2PosData(rtko)) {
+				epochFixSet = true;
+				return true;
+			}
+			break;
+		case 19:	//collect MID19 with masks
+			if (getMID19Masks(rtko)) epochMaskSet = true;
 			break;
 		default:
 			break;
@@ -226,6 +669,67 @@ bool GNSSDataAcq::acqEpochData(RTKobservation& rtko) {
 	return  false;
 }
 
+/**acqNavData acquires GPS navigation data from all messages in the source, from its current position to its end.
+ * Messages are processed as in acqEpochData, but only the ones having data needed for navigation are taken into account:
+ * MID7 for the epoch time, and MID15 or MID8 for the ephemerides. Observations are not acquired.
+ * It allows acquiring navigation data in a separate pass when epoch data are acquired in parallel.
+ *
+ * @param rinex the RinexData object where navigation data acquired will be placed
+ * @param useMID15 if MID15 messages shall be used to get ephemerides
+ * @param useMID8 if MID8 messages shall be used to get ephemerides
+ * @return true if any message has been read, false otherwise
+ */
+bool GNSSDataAcq::acqNavData(RinexData& rinex, bool useMID15, bool useMID8) {
+	bool dataRead = false;
+	while (readMessage()) {
+		dataRead = true;
+		switch(message.get()) {
+		case 7:		//decoding errors in MID7 are accounted when acquiring epoch data
+			countErrors = false;
+			getMID7TimeData(rinex);
+			countErrors = true;
+			break;
+		case 8:
+			if (useMID8) getMID8NavData(rinex);
+			break;
+		case 15:
+			if (useMID15) getMID15NavData(rinex);
+			break;
+		default:
+			break;
+		}
+	}
+	return dataRead;
+}
+
+/**findEpochChunks splits the messages in the source, from its current position to its end, into the given number
+ * of chunks of similar size starting at epoch boundaries.
+ * A chunk starts just after a MID7 message with valid time data (see getMID7TimeData). At this point, epoch data
+ * acquisition starts from scratch, without any dependency on messages before it. Navigation data are not taken
+ * into account (see acqNavData).
+ * The source is left where acquisition from it would end: after its last message, or before the first wrong one.
+ *
+ * @param nChunks the number of chunks wanted
+ * @param size the size in bytes of the source
+ * @return the positions in the source where each chunk starts, in increasing order. It may have less elements
+ *	than chunks wanted, when epoch boundaries are not found where needed
+ */
+vector<long long> GNSSDataAcq::findEpochChunks(unsigned int nChunks, long long size) {
+	vector<long long> starts;
+	MID7Layout mid7;
+	long long begin = source->tell();
+	starts.push_back(begin);
+	long long next = begin + (size - begin) / nChunks;	//the point after which the next chunk shall start
+	while (starts.size() < nChunks && source->fill(message)) {
+		if (source->tell() < next || message.payloadLen() == 0 || message.get() != 7) continue;
+		if (mid7.decode(message) != OSPOK || mid7.svs < minSVSfix) continue;
+		starts.push_back(source->tell());
+		next = begin + (size - begin) * starts.size() / nChunks;
+	}
+	while (source->fill(message));	//go to the end, as acquisition would do
+	return starts;
+}
+
 /**getMID2PosData gets solution data from a MID2 message for a RINEX file.
  *
  *@param rinex	the object where acquired data are stored
@@ -233,21 +737,18 @@ bool GNSSDataAcq::acqEpochData(RTKobservation& rtko) {
  *		SVs in solution greather than minimum), false otherwise
  */
 bool GNSSDataAcq::getMID2PosData(RinexData& rinex) {
-	if (message.payloadLen() != 41) {
-		log->info("MID2 msg len <> 41");
+	MID2Layout mid2;
+	if (mid2.decode(message) != OSPOK) {
+		decodeError("MID2 msg len <> 41");
 		return false;
 	}
-	//extract X, Y, Z for the rinex header
-	float x = (float) message.getInt();	//get X
-	float y = (float) message.getInt();	//get Y
-	float z = (float) message.getInt();	//get Z
-	message.skipBytes(15);	//skip from vX to GPS TOW: 3*2S + 3*1U +2U +4U = 15
 	//check if fix has the minimum SVs required
-	if (message.get() < minSVSfix) {
+	if (mid2.svs < minSVSfix) {
 		log->finest("MID2 wrong fix: SVs less than minimum");
 		return false;
 	}
-	rinex.setPosition( x, y, z);
+	//set X, Y, Z for the rinex header
+	rinex.setPosition((float) mid2.x, (float) mid2.y, (float) mid2.z);
 	return true;
 }
 
@@ -257,24 +758,21 @@ bool GNSSDataAcq::getMID2PosData(RinexData& rinex) {
  *@return true if data properly extracted (correct message length), false otherwise
  */
 bool GNSSDataAcq::getMID2PosData(RTKobservation& rtko) {
-	if (message.payloadLen() != 41) {
-		log->info("MID2 msg len <> 41");
+	MID2Layout mid2;
+	if (mid2.decode(message) != OSPOK) {
+		decodeError("MID2 msg len <> 41");
 		return false;
 	}
-	double x = (double) message.getInt();
-	double y = (double) message.getInt();
-	double z = (double) message.getInt();
-	message.skipBytes(9);	//skip from vX to Mode2: 3*2S 3*1U
-	int week = (int) message.getUShort() + 1024;
-	double tow = (double) message.getInt() / 100.0;	//get GPS TOW (scaled by 100)
-	int nsv = message.get();
+	int week = (int) mid2.week + 1024;
+	double tow = (double) (int) mid2.tow / 100.0;	//GPS TOW is scaled by 100
+	int nsv = mid2.svs;
 	//check if fix has the minimum SVs required
 	if (nsv < minSVSfix) {
 		log->finest("MID2 wrong fix: SVs less than minimum");
 		return false;
 	}
 	//it is assumed that "quality" is 5. No data exits in OSP messages to obtain it
-	rtko.setPosition(week, tow, x, y, z, 5, nsv);
+	rtko.setPosition(week, tow, (double) mid2.x, (double) mid2.y, (double) mid2.z, 5, nsv);
 	return true;
 }
 
@@ -292,7 +790,7 @@ bool GNSSDataAcq::getMID6RxData(RinexData& rinex) {
 	int SWcustomerLen = message.get();
 	//verify length of fields and message
 	if (message.payloadLen() != (1 + 2 + SWversionLen + SWcustomerLen)) {
-		log->info("In MID6, message/receiver/customer length don't match");
+		decodeError("In MID6, message/receiver/customer length don't match");
 		return false;
 	}
 	//extract SWversion from message char by char
@@ -320,20 +818,20 @@ bool GNSSDataAcq::getMID6RxData(RinexData& rinex) {
  *		SVs in solution greather than minimum), false otherwise
  */
 bool GNSSDataAcq::getMID7TimeData(RinexData& rinex) {
-	if (message.payloadLen() != 20) {
-		log->info("MID7 msg len <> 20");
+	MID7Layout mid7;
+	if (mid7.decode(message) != OSPOK) {
+		decodeError("MID7 msg len <> 20");
 		return false;
 	}
-	int week = (int) message.getUShort();		//get GPS Week (includes rollover)
-	double tow = (double) message.getUInt() / 100.0;	//get GPS TOW (scaled by 100)
-	int sats = (int) message.get();			//get number of satellites in the solution
+	int week = (int) mid7.week;		//GPS Week (includes rollover)
+	double tow = (double) mid7.tow / 100.0;	//GPS TOW (scaled by 100)
+	int sats = (int) mid7.svs;		//number of satellites in the solution
 	if (sats < minSVSfix) {
 		log->finest("MID7 ignored: solution only " + to_string((long long) sats) + " sats");
 		return false;
 	}
-	double drift = (double) message.getUInt();	//get receiver clock drift (change rate of bias in Hz)
-	//get receiver clock bias in nanoseconds (unsigned 32 bits int) and convert to seconds
-	double bias = (double) message.getUInt() * 1.0e-9;
+	//receiver clock bias is given in nanoseconds (unsigned 32 bits int): convert it to seconds
+	double bias = (double) mid7.bias * 1.0e-9;
 	rinex.setGPSTime(week, tow, bias);
 	return true;
 }
@@ -346,13 +844,14 @@ bool GNSSDataAcq::getMID7TimeData(RinexData& rinex) {
  * @return	true if MID data is usable, false otherwise
  */
 bool GNSSDataAcq::getMID7Interval(RinexData& rinex) {
-	if (message.payloadLen() != 20) {
-		log->info("MID7 msg len <> 20");
+	MID7Layout mid7;
+	if (mid7.decode(message) != OSPOK) {
+		decodeError("MID7 msg len <> 20");
 		return false;
 	}
-	int week = (int) message.getUShort();		//get GPS Week (includes rollover)
-	double tow = (double) message.getUInt() / 100.0;	//get GPS TOW (scaled by 100)
-	int sats = (int) message.get();			//get number of satellites in the solution
+	int week = (int) mid7.week;		//GPS Week (includes rollover)
+	double tow = (double) mid7.tow / 100.0;	//GPS TOW (scaled by 100)
+	int sats = (int) mid7.svs;		//number of satellites in the solution
 	if (sats < minSVSfix) {
 		log->finest("MID7 ignored: solution only " + to_string((long long) sats) + " sats");
 		return false;
@@ -366,38 +865,33 @@ bool GNSSDataAcq::getMID7Interval(RinexData& rinex) {
  * @param rinex		the class instance where data are stored
  */
 bool GNSSDataAcq::getMID8NavData(RinexData& rinex) {
-	if (message.payloadLen() != 43) {
-		log->info("MID8 msg len <> 43");
+	MID8Layout mid8;
+	if (mid8.decode(message) != OSPOK) {
+		decodeError("MID8 msg len <> 43");
 		return false;
 	}
 	unsigned int wd[10];	//a place to store the ten words of GPS message
 	unsigned int dt[45];	//a place to pack message data as per MID 15 (see SiRF ICD)
-	int ch = (int) message.get();
-	int sv = (int) message.get();
-	//debug//printf("MID8 CH:%2d;SV:%2d\n\t", ch, sv);
-	if (!(ch>=0 && ch<MAXCHANNELS)) {
-		log->finest("MID8 channel not in range");
+	int sv = (int) mid8.svID;
+	//debug//printf("MID8 CH:%2d;SV:%2d\n\t", (int) mid8.channel, sv);
+	if (sv <= 0) {
+		log->finest("MID8 satellite not valid");
 		return false;	//data not valid
 	}
 	//read ten words from the message. Bits in each 32 bits word are: D29 D30 d1 d2 ... d30
 	//that is: two last parity bits from previous word followed by the 30 bits of the current word
-	for (int i=0; i<10; i++) wd[i] = message.getUInt();
-	//check parity of each subframe word
-	bool parityOK = checkParity(wd[0]);
-	for (int i=1; parityOK && i<10; i++) parityOK &= checkParity(wd[i]);
-	//debug//printf(";P:%s\n\t", parityOK? "true" : "false");
+	for (int i=0; i<10; i++) wd[i] = mid8.words[i];
+	//check parity of all subframe words
 	//debug//for (int i=0; i<10; i++) printf("%08X ", wd[i]);
 	//if parity not OK, ignore all subframe data and return
-	if (!parityOK) {
+	if (!GPSParity::checkSubframe(wd)) {
 		log->finest("MID8 parity not OK");
 		//debug//printf("\n");
 		return false;
 	}
 	//remove parity from each GPS word getting the useful 24 bits
 	//Note that when D30 is set, data bits are complemented (a non documented SiRF OSP feature)
-	for (int i=0; i<10; i++)
-		if ((wd[i] & 0x40000000) == 0) wd[i] = (wd[i]>>6) & 0xFFFFFF;
-		else wd[i] = ~(wd[i]>>6) & 0xFFFFFF;
+	for (int i=0; i<10; i++) wd[i] = GPSParity::data(wd[i]);
 	//debug//printf("\n\t");
 	//debug//for (int i=0; i<10; i++) printf("%06X   ", wd[i]);
 	//get subframe and page identification (page identification valid only for subframes 4 & 5)
@@ -407,17 +901,19 @@ bool GNSSDataAcq::getMID8NavData(RinexData& rinex) {
 	//only have interest subframes: 1,2,3 & page 18 of subframe 4 (pgID = 56 in GPS ICD Table 20-V)
 	if ((subfrmID>0 && subfrmID<4) || (subfrmID==4 && pgID==56)) {
 		subfrmID--;		//convert it to its index
-		//store satellite number and message words
-		subfrmCh[ch][subfrmID].sv = sv;
-		for (int i=0; i<10; i++) subfrmCh[ch][subfrmID].words[i] = wd[i];
+		//store satellite number and message words with the ones of the satellite, whatever the channel used
+		if (sv >= (int) subfrmSV.size()) subfrmSV.resize(sv + 1, vector<SubframeData>(MAXSUBFR));
+		vector<SubframeData>& subfrm = subfrmSV[sv];
+		subfrm[subfrmID].sv = sv;
+		for (int i=0; i<10; i++) subfrm[subfrmID].words[i] = wd[i];
 		//check if all ephemerides have been already received
-		if (allEphemReceived(ch)) {
+		if (allEphemReceived(sv)) {
 			//if all 3 frames received , pack their data as per MID 15 (see SiRF ICD)
 			for (int i=0; i<3; i++) {	//for each subframe index 0, 1, 2
 				for (int j=0; j<5; j++) { //for each 2 WORDs group
-					dt[i*15+j*3] = (subfrmCh[ch][i].words[j*2]>>8) & 0xFFFF;
-					dt[i*15+j*3+1] = ((subfrmCh[ch][i].words[j*2] & 0xFF)<<8) | ((subfrmCh[ch][i].words[j*2+1]>>16) & 0xFF);
-					dt[i*15+j*3+2] = subfrmCh[ch][i].words[j*2+1] & 0xFFFF;
+					dt[i*15+j*3] = (subfrm[i].words[j*2]>>8) & 0xFFFF;
+					dt[i*15+j*3+1] = ((subfrm[i].words[j*2] & 0xFF)<<8) | ((subfrm[i].words[j*2+1]>>16) & 0xFF);
+					dt[i*15+j*3+2] = subfrm[i].words[j*2+1] & 0xFFFF;
 				}
 				//the exception is WORD1 (TLM word) of each subframe, whose data are not needed
 				dt[i*15] = sv;
@@ -425,10 +921,10 @@ bool GNSSDataAcq::getMID8NavData(RinexData& rinex) {
 			}
 			//extract ephemeris data and store them into the RINEX instance
 			extractEphemeris (rinex, dt);
-			//TBW check if iono data exist & extract and store iono data in subfrmCh[ch][3]
-			//debug//printf(";IONO:%b\n\t",subfrmCh[ch][3].sv != 0);
+			//TBW check if iono data exist & extract and store iono data in subfrm[3]
+			//debug//printf(";IONO:%b\n\t",subfrm[3].sv != 0);
 			//clear storage
-			for (int i=0; i<3; i++) subfrmCh[ch][i].sv = 0;
+			for (int i=0; i<3; i++) subfrm[i].sv = 0;
 		}
 	}
 	//debug//printf("\n");
@@ -440,13 +936,13 @@ bool GNSSDataAcq::getMID8NavData(RinexData& rinex) {
  * @param rinex		the class instance where data are stored
  */
 bool GNSSDataAcq::getMID15NavData(RinexData& rinex) {
-	if (message.payloadLen() != 92) {
-		log->info("MID15 msg len <> 92");
+	MID15Layout mid15;
+	if (mid15.decode(message) != OSPOK) {
+		decodeError("MID15 msg len <> 92");
 		return false;
 	}
 	unsigned int dt[45];		//to store the 3x15 data items in the message
-	int svID = (int) message.get();
-	for (int i=0; i<45; i++) dt[i] = (unsigned int) message.getUShort();
+	for (int i=0; i<45; i++) dt[i] = (unsigned int) mid15.data[i];
 	//set HOW bits in dt[1] and dt[2] to 0 (MID15 does not provide data from HOW)
 	dt[1] &= 0xFF00;
 	dt[2] &= 0x0003;
@@ -459,135 +955,133 @@ bool GNSSDataAcq::getMID15NavData(RinexData& rinex) {
  * @param rtko	the RTKobservation class instance where data are stored
  */
 bool GNSSDataAcq::getMID19Masks(RTKobservation& rtko) {
-	if (message.payloadLen() != 65) {
-		log->info("MID19 msg len <> 65");
+	MID19Layout mid19;
+	if (mid19.decode(message) != OSPOK) {
+		decodeError("MID19 msg len <> 65");
 		return false;
 	}
-	double elevationMask;
-	double snrMask;
-	message.skipBytes(19);	//skip from SubID to DOPmask: 1U 2U 3*1U 2S 6*1U 4U 1U
-	elevationMask = (double) message.getShort();
-	snrMask = (double) message.get();
-	rtko.setMasks(elevationMask/10.0, snrMask);
+	rtko.setMasks((double) mid19.elevationMask / 10.0, (double) mid19.powerMask);
 	return true;
 }
 /**
- * getMID28NavData gets measurements (time, pseudorange, carrier phase, etc.) for a satellite from a MID28 message
+ * addMID28NavData adds a MID28 message with measurements for a satellite to the batch of the current epoch.
+ * Messages in the batch are decoded and their data stored when the epoch ends (see storeMID28NavData).
  * 
  * @param rinex	the RinexData class instance where data are to be stored
  * @param sameEpoch true when measurements added belongs to the current epoch, false otherwise
- * @return true if nav message and data are valid and have been added to RinexData, false otherwise
+ * @return true if nav message and data are valid and have been added to the batch, false otherwise
  */
-bool GNSSDataAcq::getMID28NavData(RinexData& rinex, bool& sameEpoch) {
-	if (message.payloadLen() != 56) {
-		log->info("MID28 msg len <> 20");
+bool GNSSDataAcq::addMID28NavData(RinexData& rinex, bool& sameEpoch) {
+	if (mid28Batch.add(message) != OSPOK) {
+		decodeError("MID28 msg len <> 20");
 		return false;
 	}
 	sameEpoch = false;
-	char sys = 'G';
-	//get data from message MID28
-	int channel = message.get();	
-	message.getInt();			//a time tag not used
-	int satID = message.get();
-	if (satID > 100) {			//it is a SBAS satellite
-		sys = 'S';
-		satID -= 100;
-	}
-	double gpsSWtime = message.getDouble();
-	double pseudorange = message.getDouble();
-	double carrierFrequency = (double) message.getFloat(); //signo - ?
-	//carrier phase is given in meters; convert it to cycles
-	double carrierPhase = message.getDouble() * L1WLINV;
-	message.getUShort();		//the timeIntrack is not used
-	int syncFlags = message.get();
-	//get the signal strength as the worst of the C/N0 given
-	int carrier2noise = 0;
-	int strength = message.get();
-	for (int i=1; i<10; i++)
-		if ((carrier2noise = message.get()) < strength) strength = carrier2noise;
-	//compute strengthIndex as per RINEX spec (5.7): min(max(strength / 6, 1), 9)
-	int strengthIndex = strength / 6;
-	if (strengthIndex < 1) strengthIndex = 1;
-	if (strengthIndex > 9) strengthIndex = 9;
-	//according SiRF ICD, if deltaRangeInterval == 0, dopplerFreq 
-	//unsigned short int deltaRangeInterval = message.getUShort();
-	//TBW Phase Error Count puede usarse para obtener LoL:
-	//si PhEC != PhEC anterior de este satlite hay "slip" en carrierPhase
-	//debug//System.out.format("MID28 CH:%2d;SV:%2d;SWt:%17.10f;%04X\n", channel, satID, gpsSWtime, syncFlags);
-	if ((syncFlags & 0x01) != 0) {	//bit 0 set only when acquisition complete
-		sameEpoch = rinex.addMeasurement(sys, satID, "S1C", (double) strength, 0, 0, gpsSWtime);
-		rinex.addMeasurement(sys, satID, "C1C", pseudorange, 0, strengthIndex, gpsSWtime);
-		//check syncFlags to see if carrier phase measurement is valid
-		if ((syncFlags & 0x02) != 0) {
-			rinex.addMeasurement(sys, satID, "L1C", carrierPhase, 0, strengthIndex, gpsSWtime);
+	unsigned int last = mid28Batch.size() - 1;
+	double gpsSWtime = mid28Batch.gpsSWTime[last];
+	int syncFlags = mid28Batch.syncFlags[last];
+	if ((syncFlags & 0x01) == 0) {	//bit 0 set only when acquisition complete
+		const unsigned char* p = message.payloadData();
+		int satID = p[MID28Layout::svIDOffset];
+		char sys = 'G';
+		if (satID > 100) {			//it is a SBAS satellite
+			sys = 'S';
+			satID -= 100;
 		}
-		//check deltaRangeInterval. If 0 carrierFrequency is the Doppler frequency
-		//if (deltaRangeInterval == 0) {
-			rinex.addMeasurement(sys, satID, "D1C", carrierFrequency  * L1WLINV, 0, 0, gpsSWtime);
-		//}
-		return true;
+		string error =  "MID28 data NOK. Ch:" + to_string((long long) p[MID28Layout::channelOffset]);
+		error += " Eph:" + to_string((long double) gpsSWtime) + " SV:";
+		error.push_back(sys);
+		error += to_string((long long) satID);
+		error += " SynchFlag:" + to_string((long long) syncFlags);
+		log->info(error);
+		mid28Batch.removeLast();
+		return false;
 	}
-	string error =  "MID28 data NOK. Ch:" + to_string((long long) channel);
-	error += " Eph:" + to_string((long double) gpsSWtime) + " SV:";
-	error.push_back(sys);
-	error += to_string((long long) satID);
-	error += " SynchFlag:" + to_string((long long) syncFlags);
-	log->info(error);
-	return false;
+	//messages in the batch shall have the same time tag, and it shall be the one of observations already stored
+	if (mid28InEpoch == 0) {
+		sameEpoch = rinex.isSameEpoch(gpsSWtime);
+		mid28TimeTag = gpsSWtime;
+	} else sameEpoch = gpsSWtime == mid28TimeTag;
+	if (sameEpoch) mid28InEpoch++;
+	return true;
 }
+
 /**
- * checkParity checks the parity of a GPS message subframe word using procedure in GPS ICD
+ * storeMID28NavData decodes the MID28 messages collected in the batch of the current epoch, and stores their
+ * measurements (time, pseudorange, carrier phase, etc.) in the RinexData object. The batch is cleared after it.
  * 
- * To check the parity, the six bits of parity are computes for the word contents,
- *  and then compared with the current parity in the 6 LSB of the word passed
- *  
- * @param d The subframe word passed, where the two LSB bits of the previous word have been added  
- * @return True if parity computed is equal to the current parity in the six LSB of the word
- */
-bool GNSSDataAcq::checkParity (unsigned int d) {
-	//d has de form: D29 D30 d1 .. d30)
-	unsigned int toCheck = d;
-	if ((d & 0x40000000) != 0) toCheck = (d & 0xC0000000) | (~d & 0x3FFFFFFF);
-	//compute the parity of the bit stream
-	unsigned int parity = 0;
-	for (int i=0; i<6; i++) parity |= (bitsSet(parityBitMask[i] & toCheck) % 2) << (5-i);
-	//debug//printf("%02X:%02X:%02X;", parity, d & 0x3FL, toCheck & 0x3FL);
-	return parity == (d & 0x3F);
+ * @param rinex	the RinexData class instance where data are to be stored
+ */
+void GNSSDataAcq::storeMID28NavData(RinexData& rinex) {
+	unsigned int n = mid28InEpoch;
+	if (n == 0) return;
+	//get data from messages MID28 (the time tag and the timeIntrack are not used)
+	mid28Batch.decode();
+	mid28Obs.resize(n);
+	for (unsigned int i=0; i<n; i++) {
+		int satID = mid28Batch.svID[i];
+		char sys = 'G';
+		if (satID > 100) {			//it is a SBAS satellite
+			sys = 'S';
+			satID -= 100;
+		}
+		mid28Obs.system[i] = sys;
+		mid28Obs.satellite[i] = satID;
+		mid28Obs.timeTag[i] = mid28Batch.gpsSWTime[i];
+		//get the signal strength as the worst of the C/N0 given
+		int strength = mid28Batch.cn0Min[i];
+		//compute strengthIndex as per RINEX spec (5.7): min(max(strength / 6, 1), 9)
+		int strengthIndex = strength / 6;
+		if (strengthIndex < 1) strengthIndex = 1;
+		if (strengthIndex > 9) strengthIndex = 9;
+		mid28Obs.value[MID28S1C][i] = (double) strength;
+		mid28Obs.strength[MID28S1C][i] = 0;
+		mid28Obs.value[MID28C1C][i] = mid28Batch.pseudorange[i];
+		mid28Obs.strength[MID28C1C][i] = strengthIndex;
+		//carrier phase is given in meters; convert it to cycles
+		mid28Obs.value[MID28L1C][i] = mid28Batch.carrierPhase[i] * L1WLINV;
+		mid28Obs.strength[MID28L1C][i] = strengthIndex;
+		//TBW Phase Error Count puede usarse para obtener LoL:
+		//si PhEC != PhEC anterior de este satlite hay "slip" en carrierPhase
+		//according SiRF ICD, if deltaRangeInterval == 0, carrierFrequency is the Doppler frequency
+		mid28Obs.value[MID28D1C][i] = (double) mid28Batch.carrierFrequency[i] * L1WLINV;
+		mid28Obs.strength[MID28D1C][i] = 0;
+		mid28Obs.present[i] = (1 << MID28S1C) | (1 << MID28C1C) | (1 << MID28D1C);
+		//check syncFlags to see if carrier phase measurement is valid
+		if ((mid28Batch.syncFlags[i] & 0x02) != 0) mid28Obs.present[i] |= 1 << MID28L1C;
+	}
+	rinex.addMeasurements(mid28Obs);
+	clearMID28NavData();
 }
+
 /**
- * Count the number of bits set in a given 32 bits stream
- * 
- * Used to compute the XOR of a bit stream for computing parity
- * 
- * @param lw The 32 bit stream to be processed (32 LSB in the long)
- * @return	The number of bits set to 1
+ * clearMID28NavData discards the MID28 messages collected in the batch of the current epoch.
  */
-unsigned int GNSSDataAcq::bitsSet(unsigned int lw) {
-	int count = 0;
-	for (int i=0; i<32; i++) count += (int)((lw>>i) & 0x01);
-	return count;
+void GNSSDataAcq::clearMID28NavData() {
+	mid28Batch.clear();
+	mid28InEpoch = 0;
 }
 /**
- * allEphemReceived checks if all ephemerides in a given channel have been received
+ * allEphemReceived checks if all ephemerides of a given satellite have been received
  * 
  * All ephemerides have been received if subframes 1, 2 and 3 have been received and their data
- * belong to the same IOD
+ * belong to the same IOD. Subframes can be received from any channel tracking the satellite.
  * 
- * @param ch The data channel to be checked
+ * @param sv The satellite (PRN) to be checked
  * @return True, if all data received, false otherwise
  */
-bool GNSSDataAcq::allEphemReceived(int ch) {
-	bool allReceived =  (subfrmCh[ch][0].sv == subfrmCh[ch][1].sv)
-						&& (subfrmCh[ch][0].sv == subfrmCh[ch][2].sv);
-	//debug//printf("\n\tCh:%2d , svs:" ,ch);
-	//debug//for(int i=0;i<3;i++) printf("%2d ", subfrmCh[ch][i].sv);
+bool GNSSDataAcq::allEphemReceived(int sv) {
+	vector<SubframeData>& subfrm = subfrmSV[sv];
+	bool allReceived =  (subfrm[0].sv == sv) && (subfrm[1].sv == sv) && (subfrm[2].sv == sv);
+	//debug//printf("\n\tSV:%2d , svs:" ,sv);
+	//debug//for(int i=0;i<3;i++) printf("%2d ", subfrm[i].sv);
 	//IODC (8LSB in subframe 1) must be equal to IODE in subframe 2 and IODE in subframe 3
-	unsigned int iodcLSB = (subfrmCh[ch][0].words[7]>>16) & 0xFF;
+	unsigned int iodcLSB = (subfrm[0].words[7]>>16) & 0xFF;
 	//debug//printf(";IODClsb:%3d",iodcLSB);
-	allReceived &= iodcLSB == ((subfrmCh[ch][1].words[2]>>16) & 0xFF);
-	//debug//printf(";IODE2:%3d",(subfrmCh[ch][1].words[2]>>16) & 0xFF);
-	allReceived &= iodcLSB == ((subfrmCh[ch][2].words[9]>>16) & 0xFF);
-	//debug//printf(";IODE3:%3d",(subfrmCh[ch][2].words[9]>>16) & 0xFF);
+	allReceived &= iodcLSB == ((subfrm[1].words[2]>>16) & 0xFF);
+	//debug//printf(";IODE2:%3d",(subfrm[1].words[2]>>16) & 0xFF);
+	allReceived &= iodcLSB == ((subfrm[2].words[9]>>16) & 0xFF);
+	//debug//printf(";IODE3:%3d",(subfrm[2].words[9]>>16) & 0xFF);
 	return allReceived;
 }
 /**
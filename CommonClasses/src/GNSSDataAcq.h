@@ -19,28 +19,29 @@
  */
 #pragma once
 
+#include <vector>
+
 //from CommonClasses
 #include "Logger.h"
 #include "OSPMessage.h"
+#include "OSPSource.h"
+#include "OSPIndex.h"
+#include "OSPLayouts.h"
 #include "RinexData.h"
 #include "RTKobservation.h"
 
 //Receiver and GPS specific data
-/// The maximum number of channels in the receiver
-#define MAXCHANNELS 12
 ///The maximum number of subframes in the nav message
 #define MAXSUBFR 4
 
 //@cond DUMMY
-//other constants needed here derived from ones defined in RinexData.h
-//a bit mask definition for the bits participating in the computation of parity (see GPS ICD)
-//bit mask order: D29 D30 d1 d2 d3 ... d24 ... d29 d30
-//parityBitMask[i] identifies bits participating (set to 1) or not (set to 0) in the computation of parity bit i.
-const unsigned int parityBitMask[] = {0xBB1F3480, 0x5D8F9A40, 0xAEC7CD00, 0x5763E680, 0x6BB1F340, 0x8B7A89C0};
+//the observable types got from MID28 messages, in the order they are stored for each satellite
+enum {MID28S1C, MID28C1C, MID28L1C, MID28D1C, MID28OBSTYPES};
+const string MID28OBSTYPE[MID28OBSTYPES] = {"S1C", "C1C", "L1C", "D1C"};
 
 //A type to store 50bps message data
 struct SubframeData {
-	int sv;					//the satelite number
+	int sv;					//the satelite number, or 0 if no data are stored
 	unsigned int words[10];	//the ten words with nav data
 };
 //@endcond
@@ -49,12 +50,21 @@ struct SubframeData {
  * Header and epoch data can be used to generate and print RINEX or RTK files.
  *<p>
  * A program using GNSSDataAcq would perform the following steps:
- *	-# Declare a GNSSDataAcq object stating the receiver, the file name with the binary messages containing the data
- *		to be acquired, and the logger to be used
+ *	-# Declare a GNSSDataAcq object stating the receiver, the file (or the OSPSource) with the binary messages containing
+ *		the data to be acquired, and the logger to be used
+ *	-# Optionally, set the index of the OSP file to allow header data acquisition without reading the whole file
+ *	-# Optionally, set the single pass mode to read each message from the source only once
+ *	-# Optionally, set the GPS time window of the epochs to acquire. When possible, the source is positioned
+ *		at the window start without reading the messages before it
  *	-# Acquire header data to be placed in the header of the output file (RINEX or RTK)
- *	-# As header data may be sparse among the binary file, rewind it before performing any other data acquisition
+ *	-# As header data may be sparse among the binary file, rewind it before performing any other data acquisition.
+ *		In single pass mode, rewind replays the messages read during header acquisition
  *	-# Iterate epoch by epoch acquiring its data until end of file reached
  *<p>
+ * To acquire RINEX epoch data in parallel, the source can be split into chunks starting at epoch boundaries
+ * (see findEpochChunks). Observations in each chunk are acquired by a separate GNSSDataAcq object not collecting
+ * navigation data, while navigation data are acquired from the whole source in a separate pass (see acqNavData).
+ *<p>
  * This version implements acquisition from binary files containing OSP messages collected from SiRFIV receivers.
  * Each OSP message starts with the payload length (2 bytes) and follows the n bytes of the message payload.
  *<p>
@@ -67,13 +77,45 @@ struct SubframeData {
 class GNSSDataAcq {
 	string receiver;
 	int minSVSfix;
-	FILE* ospFile;
+	OSPSource* source;
+	OSPFileSource* ownSource;	//the source created when a FILE is given
+	OSPIndex* index;			//the index of messages in the source, if available
 	Logger* log;
 	OSPMessage message;
-	struct SubframeData subfrmCh[MAXCHANNELS][MAXSUBFR];
+	bool pushedBack;			//true when the current message has been pushed back to be read again
+	bool countErrors;			//true when decoding errors shall be accounted
+	unsigned int decodeErrors;	//number of messages with decoding errors
+	int singlePassEpochs;		//in single pass mode, the maximum number of valid epochs to record for header data. 0 otherwise
+	bool recording;				//true when messages read are being recorded to be replayed
+	vector<unsigned char> recorded;	//messages recorded (payload length and payload, as in the OSP file)
+	unsigned int replayPos;		//position in recorded of the next message to be replayed
+	bool replaying;				//true when messages are being provided from the recorded ones
+	bool windowSet;				//true when a time window has been set
+	long long windowFrom;		//the time window begin (GPS TOW scaled by 100, including weeks)
+	long long windowTo;			//the time window end (GPS TOW scaled by 100, including weeks)
+	long long windowStart;		//position in the source of the first message in the window
+	int windowEntry;			//position in the index of the first message in the window
+	int windowEndEntry;			//position in the index of the first message after the window, or -1 if not known
+	vector<unsigned char> sessionMsgs;	//session messages before the window start, to be provided before the ones in it
+	unsigned int sessionPos;	//position in sessionMsgs of the next message to be provided
+	bool epochFixSet;			//true when a valid MID2 has been acquired with RTK epoch data
+	bool epochMaskSet;			//true when a valid MID19 has been acquired with RTK epoch data
+	vector<vector<SubframeData> > subfrmSV;	//subframes received for each satellite, indexed by its PRN and subframe index
+	MID28Batch mid28Batch;		//the MID28 messages of the current epoch, to be decoded when it ends
+	unsigned int mid28InEpoch;	//the number of MID28 messages in the batch
+	double mid28TimeTag;		//the time tag of the MID28 messages in the batch
+	ObsColumns mid28Obs;		//the measurements got from the batch
 
-	bool checkParity (unsigned int );
-	unsigned int bitsSet(unsigned int );
+	bool readMessage();
+	void decodeError(string );
+	void pushBack();
+	bool fillHeaderMsg(int&, const int* );
+	bool fillIndexed(int );
+	void dropIndex();
+	long long mid7Time();
+	long long mid2Time();
+	bool inWindow(long long );
+	bool logRTKHeaderData(bool, bool);
 	bool allEphemReceived(int );
 	bool extractEphemeris (RinexData&, unsigned int* );
 	unsigned int getTwosComplement(unsigned int, unsigned int );
@@ -86,14 +128,26 @@ class GNSSDataAcq {
 	bool getMID8NavData(RinexData& );
 	bool getMID15NavData(RinexData& );
 	bool getMID19Masks(RTKobservation& );
-	bool getMID28NavData(RinexData&, bool&);
+	bool addMID28NavData(RinexData&, bool&);
+	void storeMID28NavData(RinexData&);
+	void clearMID28NavData();
 
 public:
 	GNSSDataAcq(string, int, FILE*, Logger*);
+	GNSSDataAcq(string, int, OSPSource*, Logger*);
 	~GNSSDataAcq(void);
+	bool rewind();
+	void setIndex(OSPIndex* );
+	void setSinglePass(int );
+	void selectMessages(bool, bool, bool);
+	bool setTimeWindow(int, double, int, double);
+	unsigned int getDecodeErrors();
 	bool acqHeaderData(RinexData& );
 	bool acqHeaderData(RTKobservation& );
 	bool acqEpochData(RinexData& , bool, bool);
 	bool acqEpochData(RTKobservation& );
+	bool epochHeaderData();
+	bool acqNavData(RinexData& , bool, bool);
+	vector<long long> findEpochChunks(unsigned int, long long);
 };
 
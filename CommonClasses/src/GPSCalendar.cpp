@@ -0,0 +1,182 @@
+/** @file GPSCalendar.cpp
+ * Contains the implementation of the GPSCalendar class.
+ */
+
+#include "GPSCalendar.h"
+
+/**Constructs a GPSCalendar object, with the calendar data of the GPS epoch (1980-01-06 00:00:00).
+ */
+GPSCalendar::GPSCalendar(void) {
+	day = -1;
+	setTime(0, 0.0);
+}
+
+/**Destructs a GPSCalendar object.
+ */
+GPSCalendar::~GPSCalendar(void) {
+}
+
+/**setTime sets the calendar data for the given GPS time.
+ * The calendar date is computed only when the time is not in the day of the former one.
+ *
+ * @param week the GPS week from 6/1/1980
+ * @param sec the GPS seconds from the beginning of the week (truncated to an integer)
+ */
+void GPSCalendar::setTime(int week, double sec) {
+	long long seconds = (long long) week * 7 * DAYSECONDS + (int) sec;
+	long long d = seconds / DAYSECONDS;
+	long long daySeconds = seconds % DAYSECONDS;
+	if (daySeconds < 0) {
+		daySeconds += DAYSECONDS;
+		d--;
+	}
+	hour = (int) (daySeconds / 3600);
+	minute = (int) (daySeconds % 3600 / 60);
+	second = (int) (daySeconds % 60);
+	if (d == day) return;
+	day = d;
+	//compute the civil date from days in 400 years eras of a calendar starting on March 1st (leap day at the end)
+	long long days = d + GPSEPOCHDAYS;
+	long long era = (days >= 0? days: days - 146096) / 146097;
+	long long eraDay = days - era * 146097;		//[0, 146096]
+	long long eraYear = (eraDay - eraDay / 1460 + eraDay / 36524 - eraDay / 146096) / 365;	//[0, 399]
+	long long marchYearDay = eraDay - (365 * eraYear + eraYear / 4 - eraYear / 100);	//[0, 365], from March 1st
+	int marchMonth = (int) ((5 * marchYearDay + 2) / 153);	//[0, 11], from March
+	monthDay = (int) (marchYearDay - (153 * marchMonth + 2) / 5 + 1);
+	month = marchMonth < 10? marchMonth + 3: marchMonth - 9;
+	year = (int) (eraYear + era * 400) + (month <= 2? 1: 0);
+	bool leap = (year % 4 == 0) && ((year % 100 != 0) || (year % 400 == 0));
+	//days from March 1st are converted to days from January 1st, before March having 59 days, or 60 in leap years
+	if (month <= 2) yearDay = (int) marchYearDay - 305;
+	else yearDay = (int) marchYearDay + 59 + (leap? 1: 0) + 1;
+}
+
+/**getYear gets the year of the time set.
+ *
+ * @return the year (f.e. 2015)
+ */
+int GPSCalendar::getYear() {
+	return year;
+}
+
+/**getMonth gets the month of the time set.
+ *
+ * @return the month (1 to 12)
+ */
+int GPSCalendar::getMonth() {
+	return month;
+}
+
+/**getDay gets the day of month of the time set.
+ *
+ * @return the day of month (1 to 31)
+ */
+int GPSCalendar::getDay() {
+	return monthDay;
+}
+
+/**getYearDay gets the day of year of the time set.
+ *
+ * @return the day of year (1 to 366)
+ */
+int GPSCalendar::getYearDay() {
+	return yearDay;
+}
+
+/**getHour gets the hour of the time set.
+ *
+ * @return the hour (0 to 23)
+ */
+int GPSCalendar::getHour() {
+	return hour;
+}
+
+/**getMinute gets the minute of the time set.
+ *
+ * @return the minute (0 to 59)
+ */
+int GPSCalendar::getMinute() {
+	return minute;
+}
+
+/**getSecond gets the second of the time set.
+ *
+ * @return the second (0 to 59)
+ */
+int GPSCalendar::getSecond() {
+	return second;
+}
+
+/**format sets the calendar data for the given GPS time, and gives them as text using the format provided.
+ * The format conversions allowed are those of strftime for numeric calendar data: %Y, %y, %m, %d, %j, %H, %M, %S
+ * and %%. Other characters are copied to the buffer. Text not fitting in the buffer is truncated.
+ *
+ * @param buffer the text buffer where calendar data are placed
+ * @param bufferSize of the text buffer in bytes
+ * @param fmt the format to be used for conversion, as per strftime
+ * @param week the GPS week from 6/1/1980
+ * @param sec the GPS seconds from the beginning of the week
+ */
+void GPSCalendar::format(char* buffer, int bufferSize, const char* fmt, int week, double sec) {
+	if (bufferSize <= 0) return;
+	setTime(week, sec);
+	char* end = buffer + bufferSize - 1;
+	char* p = buffer;
+	for (; *fmt != 0 && p < end; fmt++) {
+		if (*fmt != '%' || *(fmt + 1) == 0) {
+			*p++ = *fmt;
+			continue;
+		}
+		int value;
+		int digits = 2;
+		switch (*++fmt) {
+		case 'Y': value = year; digits = 4; break;
+		case 'y': value = year % 100; break;
+		case 'm': value = month; break;
+		case 'd': value = monthDay; break;
+		case 'j': value = yearDay; digits = 3; break;
+		case 'H': value = hour; break;
+		case 'M': value = minute; break;
+		case 'S': value = second; break;
+		case '%': *p++ = '%'; continue;
+		default:
+			*p++ = '%';
+			if (p < end) *p++ = *fmt;
+			continue;
+		}
+		//print the value with the given digits, filling with zeros
+		char text[16];
+		char* t = text + sizeof text;
+		int count = 0;
+		do {
+			*--t = '0' + value % 10;
+			value /= 10;
+			count++;
+		} while (value != 0 || count < digits);
+		while (t < text + sizeof text && p < end) *p++ = *t++;
+	}
+	*p = 0;
+}
+
+/**unixSeconds converts the given UTC calendar date and time to seconds from the Unix epoch (1970-01-01 00:00:00),
+ * as timegm does, using integer arithmetic. It does not depend on the time zone or daylight saving time of the computer.
+ * Days, hours, minutes and seconds out of their usual range are accounted as given (f.e. 24:00:00 is the next day).
+ *
+ * @param year the year (f.e. 2015)
+ * @param month the month (1 to 12)
+ * @param day the day of month
+ * @param hour the hour
+ * @param minute the minute
+ * @param second the second
+ * @return the seconds from the Unix epoch
+ */
+long long GPSCalendar::unixSeconds(int year, int month, int day, int hour, int minute, int second) {
+	//compute days in 400 years eras of a calendar starting on March 1st (as in setTime, in reverse order)
+	long long y = month <= 2? year - 1: year;
+	long long era = (y >= 0? y: y - 399) / 400;
+	long long eraYear = y - era * 400;		//[0, 399]
+	long long marchYearDay = (153 * (month > 2? month - 3: month + 9) + 2) / 5 + day - 1;
+	long long eraDay = eraYear * 365 + eraYear / 4 - eraYear / 100 + marchYearDay;
+	long long days = era * 146097 + eraDay - UNIXEPOCHDAYS;
+	return days * DAYSECONDS + hour * 3600 + minute * 60 + second;
+}
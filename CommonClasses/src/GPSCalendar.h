@@ -0,0 +1,60 @@
+/** @file GPSCalendar.h
+ * Contains the definition of the GPSCalendar class, used to convert GPS week and time of week to calendar data.
+ *
+ *Copyright 2015 Francisco Cancillo
+ *<p>
+ *This file is part of the RXtoRINEX tool.
+ *<p>
+ *RXtoRINEX is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *RXtoRINEX is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ *warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *See the GNU General Public License for more details.
+ *<p>
+ *A copy of the GNU General Public License can be found at <http://www.gnu.org/licenses/>.
+ *
+ *V1.0	First release
+ */
+#pragma once
+
+///The number of seconds in a day
+#define DAYSECONDS 86400
+///The number of days from 0000-03-01 (proleptic Gregorian calendar) to the GPS epoch 1980-01-06
+#define GPSEPOCHDAYS 723125
+///The number of days from 0000-03-01 (proleptic Gregorian calendar) to the Unix epoch 1970-01-01
+#define UNIXEPOCHDAYS 719468
+
+/**GPSCalendar class converts GPS times, given as week and seconds from the beginning of the week, to GPS time
+ * calendar data (year, month, day, hour, minute and second), and formats them.
+ *<p>
+ * Conversion is made using integer arithmetic, without the C library time functions: it does not depend on the
+ * time zone or daylight saving time of the computer, and it does not take their locks.
+ * The calendar date of the last day converted is kept, and it is computed again only when a time in a different day
+ * is converted. As seconds are integer numbers (as per strftime), the seconds of time given are truncated.
+ *<p>
+ * The reverse conversion, from UTC calendar data to seconds from the Unix epoch, is also provided (see unixSeconds).
+ */
+class GPSCalendar {
+	long long day;		//the day of the calendar date kept, as days from the GPS epoch
+	int year;			//the calendar date of the day kept
+	int month;
+	int monthDay;
+	int yearDay;		//the day of year (1 to 366)
+	int hour;			//the time in the day of the last time converted
+	int minute;
+	int second;
+
+public:
+	GPSCalendar(void);
+	~GPSCalendar(void);
+	void setTime(int, double);
+	int getYear();
+	int getMonth();
+	int getDay();
+	int getYearDay();
+	int getHour();
+	int getMinute();
+	int getSecond();
+	void format(char*, int, const char*, int, double);
+	static long long unixSeconds(int, int, int, int, int, int);
+};
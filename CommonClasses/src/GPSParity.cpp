@@ -0,0 +1,77 @@
+/** @file GPSParity.cpp
+ * Contains the implementation of the GPSParity class.
+ */
+
+#include "GPSParity.h"
+
+//@cond DUMMY
+//the bits complemented in the word when D30 is set (d1 to d30)
+#define COMPLEMENTMASK 0x3FFFFFFF
+
+//computes bit by bit the parity bits of the given word bits (used to set tables)
+static unsigned int slowParity(unsigned int bits) {
+	unsigned int parity = 0;
+	for (int i=0; i<6; i++) {
+		unsigned int count = 0;
+		for (int j=0; j<32; j++) count += ((parityBitMask[i] & bits) >> j) & 0x01;
+		parity |= (count % 2) << (5-i);
+	}
+	return parity;
+}
+//@endcond
+
+unsigned char GPSParity::byteParity[4][256];
+unsigned int GPSParity::complementParity;
+bool GPSParity::tablesReady = GPSParity::setTables();
+
+/**setTables computes the parity bits contributed by each value of each word byte, and by the complement mask.
+ *
+ * @return true
+ */
+bool GPSParity::setTables() {
+	for (int k=0; k<4; k++)
+		for (unsigned int v=0; v<256; v++) byteParity[k][v] = (unsigned char) slowParity(v << (8 * k));
+	complementParity = slowParity(COMPLEMENTMASK);
+	return true;
+}
+
+/**compute computes the six parity bits of a GPS subframe word, taking into account complemented data when D30 is set.
+ *
+ * @param d the subframe word (D29 D30 d1 ... d30)
+ * @return the parity bits computed, in the six LSB
+ */
+unsigned int GPSParity::compute(unsigned int d) {
+	unsigned int complemented = complementParity & (0u - ((d >> 30) & 0x01));
+	return byteParity[0][d & 0xFF] ^ byteParity[1][(d >> 8) & 0xFF] ^ byteParity[2][(d >> 16) & 0xFF]
+		^ byteParity[3][d >> 24] ^ complemented;
+}
+
+/**check checks the parity of a GPS subframe word.
+ *
+ * @param d the subframe word (D29 D30 d1 ... d30)
+ * @return true if the parity computed is equal to the one in the six LSB of the word, false otherwise
+ */
+bool GPSParity::check(unsigned int d) {
+	return compute(d) == (d & 0x3F);
+}
+
+/**checkSubframe checks the parity of all words in a GPS subframe.
+ * All words are checked in a single loop without branches, to allow the compiler to vectorize it.
+ *
+ * @param words the GPSSUBFRWORDS words of the subframe (D29 D30 d1 ... d30)
+ * @return true if the parity of all words is correct, false otherwise
+ */
+bool GPSParity::checkSubframe(const unsigned int* words) {
+	unsigned int errors = 0;
+	for (int i=0; i<GPSSUBFRWORDS; i++) errors |= compute(words[i]) ^ (words[i] & 0x3F);
+	return errors == 0;
+}
+
+/**data extracts the 24 data bits of a GPS subframe word, complementing them when D30 is set.
+ *
+ * @param d the subframe word (D29 D30 d1 ... d30)
+ * @return the data bits d1 to d24, in the 24 LSB
+ */
+unsigned int GPSParity::data(unsigned int d) {
+	return ((d >> 6) ^ (0u - ((d >> 30) & 0x01))) & 0xFFFFFF;
+}
@@ -0,0 +1,53 @@
+/** @file GPSParity.h
+ * Contains the definition of the GPSParity class, used to check the parity of GPS LNAV subframe words.
+ *
+ *Copyright 2015 Francisco Cancillo
+ *<p>
+ *This file is part of the RXtoRINEX tool.
+ *<p>
+ *RXtoRINEX is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *RXtoRINEX is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ *warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *See the GNU General Public License for more details.
+ *<p>
+ *A copy of the GNU General Public License can be found at <http://www.gnu.org/licenses/>.
+ *
+ *V1.0	First release
+ */
+#pragma once
+
+///The number of words in a GPS LNAV subframe
+#define GPSSUBFRWORDS 10
+
+//@cond DUMMY
+//a bit mask definition for the bits participating in the computation of parity (see GPS ICD)
+//bit mask order: D29 D30 d1 d2 d3 ... d24 ... d29 d30
+//parityBitMask[i] identifies bits participating (set to 1) or not (set to 0) in the computation of parity bit i.
+const unsigned int parityBitMask[] = {0xBB1F3480, 0x5D8F9A40, 0xAEC7CD00, 0x5763E680, 0x6BB1F340, 0x8B7A89C0};
+//@endcond
+
+/**GPSParity class provides methods to check the parity of GPS LNAV subframe words, as per the procedure in the GPS ICD,
+ * and to extract their data bits.
+ *<p>
+ * Words are given as 32 bits values with the form D29 D30 d1 d2 ... d30, that is: the two last parity bits of the
+ * previous word followed by the 30 bits of the current word. When D30 is set, data bits d1 to d24 are complemented.
+ *<p>
+ * Parity bits are the XOR of the word bits selected by each parity mask. As XOR is linear, the six parity bits are
+ * obtained XORing the ones contributed by each byte of the word, taken from precomputed tables (four lookups per word,
+ * instead of a population count for each parity bit). In the same way, complemented data are taken into account
+ * XORing the precomputed parity bits of the complement mask, avoiding branches.
+ */
+class GPSParity {
+	static unsigned char byteParity[4][256];	//parity bits contributed by each value of each word byte
+	static unsigned int complementParity;		//parity bits contributed by the complement of d1 to d30
+	static bool tablesReady;					//true when tables have been computed
+
+	static bool setTables();
+
+public:
+	static unsigned int compute(unsigned int);
+	static bool check(unsigned int);
+	static bool checkSubframe(const unsigned int*);
+	static unsigned int data(unsigned int);
+};
@@ -0,0 +1,28 @@
+/** @file LocalTime.h
+ * Contains the definition of the macro used to convert times to local time in any platform.
+ *
+ *Copyright 2015 Francisco Cancillo
+ *<p>
+ *This file is part of the RXtoRINEX tool.
+ *<p>
+ *RXtoRINEX is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *RXtoRINEX is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ *warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *See the GNU General Public License for more details.
+ *<p>
+ *A copy of the GNU General Public License can be found at <http://www.gnu.org/licenses/>.
+ *
+ *V1.0	First release
+ */
+#pragma once
+
+#include <time.h>
+
+#ifdef _WIN32
+///Converts the time_t pointed by rawtime to local time in the struct tm pointed by result, not using a static buffer shared among threads
+#define LOCALTIME(rawtime, result) localtime_s(result, rawtime)
+#else
+///Converts the time_t pointed by rawtime to local time in the struct tm pointed by result, not using a static buffer shared among threads
+#define LOCALTIME(rawtime, result) localtime_r(rawtime, result)
+#endif
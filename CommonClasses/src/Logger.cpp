@@ -3,6 +3,7 @@
  */
 
 #include "Logger.h"
+#include "LocalTime.h"
 
 /**Constructs an empty Logger object.
  *It sets the default log level to INFO, and states the stderr as log file.
@@ -10,6 +11,7 @@
 Logger::Logger(void) {
 	levelSet = INFO;
 	fileLog = stderr;
+	ownFile = false;
 }
 
 /**Constructs a Logger object.
@@ -21,13 +23,28 @@ Logger::Logger(void) {
 Logger::Logger(string fileName) {
 	levelSet = INFO;
 	fileLog = fopen(fileName.c_str(), "a");
+	ownFile = fileLog != NULL;
 	if (fileLog == NULL) fileLog = stderr;
 }
 
+/**Constructs a Logger object with the program name and log level of the given one, which logs messages
+ *in the given already open file. The file is not closed when the Logger is destructed.
+ *It allows, for example, to log messages from a thread in a separate file to append them later to the main log.
+ *
+ *@param model the Logger whose program name and log level are used
+ *@param file the already open FILE where messages will be logged
+ */
+Logger::Logger(const Logger& model, FILE* file) {
+	program = model.program;
+	levelSet = model.levelSet;
+	fileLog = file;
+	ownFile = false;
+}
+
 /**Destruct the Logger object after closing its log file. 
  */
 Logger::~Logger(void) {
-	if (fileLog != stderr) fclose(fileLog);
+	if (ownFile) fclose(fileLog);
 }
 
 /**setPrgName sets the program name to be used in message tagging
@@ -48,6 +65,19 @@ void Logger::setLevel(logLevel level) {
 	levelSet = level;
 }
 
+/**append appends to the log the whole content of the given file, f.e. messages logged in it by another Logger.
+ *
+ *@param file the already open FILE with the messages to append
+ */
+void Logger::append(FILE* file) {
+	char buffer[4096];
+	size_t n;
+	fflush(file);
+	rewind(file);
+	while ((n = fread(buffer, 1, sizeof buffer, file)) > 0) fwrite(buffer, 1, n, fileLog);
+	fflush(fileLog);
+}
+
 /**logMsg is an internal method to tag, format, and log messages data passed by log level methods.
  *
  *@param logLevel states the level to tag the message
@@ -55,12 +85,12 @@ void Logger::setLevel(logLevel level) {
  */
 void Logger::logMsg (logLevel msgLevel, string msg) {
 	time_t rawtime;
-	struct tm * timeinfo;
+	struct tm timeinfo;
 	char txtBuf[80];
 
 	time (&rawtime);
-	timeinfo = localtime (&rawtime);
-	strftime(txtBuf, sizeof txtBuf, " %d/%m/%y %H:%M ", timeinfo);
+	LOCALTIME (&rawtime, &timeinfo);
+	strftime(txtBuf, sizeof txtBuf, " %d/%m/%y %H:%M ", &timeinfo);
 	fprintf(fileLog, "%s %s ", program.c_str(), txtBuf);
 	switch (msgLevel) {
 	case SEVERE: fprintf(fileLog, "(SVR) "); break;
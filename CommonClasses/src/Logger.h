@@ -38,13 +38,16 @@ class Logger {
 	string program;		//program name to tag logs
 	logLevel levelSet;	//maximum level to log
 	FILE * fileLog;
+	bool ownFile;		//true when fileLog has been open by the logger
 	void logMsg (logLevel msgLevel, string msg);
 public:
 	Logger(string);
 	Logger(void);
+	Logger(const Logger&, FILE*);
 	~Logger(void);
 	void setPrgName(string);
 	void setLevel (logLevel);
+	void append (FILE*);
 	void severe (string);
 	void warning (string);
 	void info (string);
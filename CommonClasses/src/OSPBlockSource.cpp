@@ -0,0 +1,247 @@
+/** @file OSPBlockSource.cpp
+ * Contains the implementation of the OSPBlockSource class.
+ */
+
+#include "OSPBlockSource.h"
+
+#include <string.h>
+#include <stdint.h>
+#include <chrono>
+
+/**Constructs an OSPBlockSource object without blocks. Derived classes shall set them and start the reader thread.
+ */
+OSPBlockSource::OSPBlockSource(void) {
+	blockSize = 0;
+	readerDone = stopReader = readError = false;
+	current = -1;
+	currentPos = 0;
+	position = 0;
+	stalls = 0;
+	stallTime = 0;
+}
+
+/**Destructs an OSPBlockSource object, stopping the reader thread if it is still running.
+ */
+OSPBlockSource::~OSPBlockSource(void) {
+	stop();
+}
+
+/**setBlocks allocates the blocks where the reader thread puts data. It shall be called before starting it.
+ *
+ * @param size the size in bytes of each block
+ * @param n the number of blocks
+ * @param align the alignment in bytes of blocks in memory
+ */
+void OSPBlockSource::setBlocks(unsigned int size, unsigned int n, unsigned int align) {
+	blockSize = size;
+	buffers.resize(n);
+	blocks.resize(n);
+	blockLength.resize(n);
+	for (unsigned int i=0; i<n; i++) {
+		buffers[i].resize(blockSize + align);
+		uintptr_t address = (uintptr_t) &buffers[i][0];
+		blocks[i] = &buffers[i][0] + (align - address % align) % align;
+	}
+}
+
+/**start sets the initial state of blocks and starts the reader thread.
+ *
+ * @param pos the offset in the plain OSP data where the reader thread starts getting data
+ */
+void OSPBlockSource::start(long long pos) {
+	freeBlocks.clear();
+	readyBlocks.clear();
+	for (unsigned int i=0; i<blocks.size(); i++) {
+		freeBlocks.push_back(i);
+		blockLength[i] = 0;
+	}
+	readerDone = stopReader = readError = false;
+	current = -1;
+	currentPos = 0;
+	position = pos;
+	reader = thread(&OSPBlockSource::readBlocks, this);
+}
+
+/**stop requests the reader thread to finish and waits for it.
+ */
+void OSPBlockSource::stop() {
+	{
+		lock_guard<mutex> lock(blocksMutex);
+		stopReader = true;
+	}
+	blocksChanged.notify_all();
+	if (reader.joinable()) reader.join();
+}
+
+/**beginReading is called from the reader thread before filling any block.
+ * By default nothing is done.
+ *
+ * @return true if data can be got, false otherwise (the reader thread finishes with an error)
+ */
+bool OSPBlockSource::beginReading() {
+	return true;
+}
+
+/**endReading is called from the reader thread when it finishes.
+ * By default nothing is done.
+ */
+void OSPBlockSource::endReading() {
+}
+
+/**readBlocks is the body of the reader thread.
+ * It fills free blocks with data (see readBlock), which are queued as ready when filled.
+ * It finishes when all data have been got, an error happens, or it is requested to stop.
+ */
+void OSPBlockSource::readBlocks() {
+	bool last = !beginReading();	//no more data will be got
+	bool error = last;				//an error happened getting data
+	while (!last) {
+		//get a free block
+		int block;
+		{
+			unique_lock<mutex> lock(blocksMutex);
+			while (freeBlocks.empty() && !stopReader) blocksChanged.wait(lock);
+			if (stopReader) break;
+			block = freeBlocks.front();
+			freeBlocks.pop_front();
+		}
+		//fill it with data
+		unsigned int length = readBlock(blocks[block], blockSize, last, error);
+		{
+			lock_guard<mutex> lock(blocksMutex);
+			blockLength[block] = length;
+			if (length > 0) readyBlocks.push_back(block);
+			else freeBlocks.push_back(block);
+		}
+		blocksChanged.notify_all();
+	}
+	endReading();
+	{
+		lock_guard<mutex> lock(blocksMutex);
+		readerDone = true;
+		if (error) readError = true;
+	}
+	blocksChanged.notify_all();
+}
+
+/**nextBlock releases the current block to the reader thread and waits for the next block with data.
+ * When the next block is not ready yet, the time waiting for it is accounted as a stall.
+ *
+ * @return true if a new block is available, false if all data have been used
+ */
+bool OSPBlockSource::nextBlock() {
+	unique_lock<mutex> lock(blocksMutex);
+	if (current >= 0) {
+		freeBlocks.push_back(current);
+		current = -1;
+		blocksChanged.notify_all();
+	}
+	if (readyBlocks.empty() && !readerDone) {
+		chrono::steady_clock::time_point waitStart = chrono::steady_clock::now();
+		while (readyBlocks.empty() && !readerDone) blocksChanged.wait(lock);
+		stalls++;
+		stallTime += chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - waitStart).count();
+	}
+	if (readyBlocks.empty()) return false;
+	current = readyBlocks.front();
+	readyBlocks.pop_front();
+	currentPos = 0;
+	return true;
+}
+
+/**getBytes copies the given number of bytes, getting new blocks as needed.
+ *
+ * @param dest the place where bytes are copied
+ * @param n the number of bytes to copy
+ * @return true if all bytes were copied, false otherwise (not enough data)
+ */
+bool OSPBlockSource::getBytes(unsigned char* dest, unsigned int n) {
+	while (n > 0) {
+		if (current < 0 || currentPos == blockLength[current])
+			if (!nextBlock()) return false;
+		unsigned int count = blockLength[current] - currentPos;
+		if (count > n) count = n;
+		memcpy(dest, blocks[current] + currentPos, count);
+		currentPos += count;
+		dest += count;
+		n -= count;
+	}
+	return true;
+}
+
+/**fill sets the message as a view of the next message payload in the data having a wanted MID.
+ *
+ * @param msg the OSPMessage to be set
+ * @return true when a message was correctly provided, false otherwise (wrong length or end of data found)
+ */
+bool OSPBlockSource::fill(OSPMessage& msg) {
+	do {
+		if (!fillNext(msg)) return false;
+	} while (!isWanted(msg.payloadData(), msg.payloadLen()));
+	return true;
+}
+
+/**fillNext sets the message as a view of the next message payload in the data.
+ * For a message to be provided, its payload length shall be less than the maximum payload size
+ * (as defined in the OSP ICD) and all its payload bytes shall be in the data.
+ *
+ * @param msg the OSPMessage to be set
+ * @return true when a message was correctly provided, false otherwise (wrong length or end of data found)
+ */
+bool OSPBlockSource::fillNext(OSPMessage& msg) {
+	if (current < 0 || currentPos == blockLength[current])
+		if (!nextBlock()) return false;
+	unsigned int available = blockLength[current] - currentPos;
+	const unsigned char* p = blocks[current] + currentPos;
+	unsigned int payloadLength;
+	if (available >= 2) {
+		payloadLength = (p[0] << 8) | p[1];	//numbers in msg are big endians
+		if (payloadLength > MAXPAYLOADSIZE) return false;
+		if (available >= 2 + payloadLength) {	//the message is in the current block: use it
+			msg.setView(p + 2, payloadLength);
+			currentPos += 2 + payloadLength;
+			position += 2 + payloadLength;
+			return true;
+		}
+	}
+	//the message spans two blocks: copy it to the spill buffer
+	if (!getBytes(spill, 2)) return false;
+	payloadLength = (spill[0] << 8) | spill[1];
+	if (payloadLength > MAXPAYLOADSIZE || !getBytes(spill + 2, payloadLength)) return false;
+	msg.setView(spill + 2, payloadLength);
+	position += 2 + payloadLength;
+	return true;
+}
+
+/**tell gets the position of the next message to be provided.
+ *
+ * @return the byte offset from the beginning of the plain OSP data
+ */
+long long OSPBlockSource::tell() {
+	return position;
+}
+
+/**hasErrors tells if errors were found getting data. Messages got before the error are provided.
+ *
+ * @return true if errors were found, false otherwise
+ */
+bool OSPBlockSource::hasErrors() {
+	lock_guard<mutex> lock(blocksMutex);
+	return readError;
+}
+
+/**getStalls gets the number of times messages could not be provided without waiting for the reader thread.
+ *
+ * @return the number of stalls
+ */
+unsigned int OSPBlockSource::getStalls() {
+	return stalls;
+}
+
+/**getStallTime gets the total time spent waiting for the reader thread.
+ *
+ * @return the stall time in seconds
+ */
+double OSPBlockSource::getStallTime() {
+	return stallTime / 1000000.0;
+}
@@ -0,0 +1,85 @@
+/** @file OSPBlockSource.h
+ * Contains the definition of the OSPBlockSource class, the base of OSP sources reading their data by blocks
+ * in a reader thread.
+ *
+ *Copyright 2015 Francisco Cancillo
+ *<p>
+ *This file is part of the RXtoRINEX tool.
+ *<p>
+ *RXtoRINEX is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *RXtoRINEX is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ *warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *See the GNU General Public License for more details.
+ *<p>
+ *A copy of the GNU General Public License can be found at <http://www.gnu.org/licenses/>.
+ *
+ *V1.0	First release
+ */
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+//from CommonClasses
+#include "OSPSource.h"
+
+using namespace std;
+
+/**OSPBlockSource class is the base of sources providing OSP messages from plain OSP data put into a ring of blocks
+ * by a reader thread. While messages are provided from a block already filled, the reader thread fills next blocks.
+ * Thus, getting data (reading or decompressing them) overlaps with message processing.
+ *<p>
+ * Derived classes state how blocks are filled implementing readBlock, and optionally beginReading and endReading,
+ * which are called from the reader thread. They shall call stop in their destructors, before their data are destroyed.
+ *<p>
+ * Messages provided are views of payloads in the blocks, or in an internal buffer when they span two blocks.
+ * A message provided remains valid until the next one is requested. The time spent waiting for the reader thread
+ * (a stall) is accounted.
+ */
+class OSPBlockSource : public OSPSource {
+	unsigned int blockSize;			//the size in bytes of each block
+	vector<vector<unsigned char> > buffers;	//the memory allocated for blocks
+	vector<unsigned char*> blocks;	//the blocks, aligned in their buffers
+	vector<unsigned int> blockLength;	//the number of bytes put in each block
+	deque<int> freeBlocks;			//blocks available to the reader thread
+	deque<int> readyBlocks;			//blocks with data ready to be used, in order
+	bool readerDone;				//true when the reader thread has no more data to put in blocks
+	bool stopReader;				//true to request the reader thread to finish
+	bool readError;					//true when an error happened getting data
+	thread reader;					//the reader thread
+	mutex blocksMutex;				//to access block queues and reader flags
+	condition_variable blocksChanged;	//to signal changes in block queues or reader flags
+	int current;					//the block in use, or -1 if none
+	unsigned int currentPos;		//position in the current block of the next byte to use
+	long long position;				//offset in the plain OSP data of the next message
+	unsigned char spill[MAXPAYLOADSIZE + 2];	//a buffer for messages spanning two blocks
+	unsigned int stalls;			//the number of times the consumer waited for a block
+	long long stallTime;			//the total time waiting for blocks, in microseconds
+
+	void readBlocks();
+	bool nextBlock();
+	bool getBytes(unsigned char*, unsigned int);
+	bool fillNext(OSPMessage&);
+
+protected:
+	void setBlocks(unsigned int, unsigned int, unsigned int);
+	void start(long long);
+	void stop();
+	virtual bool beginReading();		//prepare getting data, in the reader thread
+	//fill the given block of the given size, returning the bytes put. Flags are set when no more data will follow, or on error
+	virtual unsigned int readBlock(unsigned char*, unsigned int, bool&, bool&) = 0;
+	virtual void endReading();			//release resources used to get data, in the reader thread
+
+public:
+	OSPBlockSource(void);
+	virtual ~OSPBlockSource(void);
+	bool fill(OSPMessage&);
+	long long tell();
+	bool hasErrors();
+	unsigned int getStalls();
+	double getStallTime();
+};
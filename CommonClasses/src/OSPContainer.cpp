@@ -0,0 +1,329 @@
+/** @file OSPContainer.cpp
+ * Contains the implementation of the OSPWriter and OSPContainerSource classes.
+ */
+
+#include "OSPContainer.h"
+#include "FileOffset.h"
+
+#include <string.h>
+#include <zlib.h>
+
+//@cond DUMMY
+//the sync bytes at the beginning of each block
+static const unsigned char OSP2SYNC[4] = {0xA0, 0xA2, 0xB0, 0xB3};
+
+//functions to put and get big endian numbers
+static void putU16(unsigned char* p, unsigned int v) {
+	p[0] = (unsigned char) (v >> 8);
+	p[1] = (unsigned char) v;
+}
+static void putU32(unsigned char* p, unsigned int v) {
+	putU16(p, v >> 16);
+	putU16(p + 2, v & 0xFFFF);
+}
+static unsigned int getU16(const unsigned char* p) {
+	return (p[0] << 8) | p[1];
+}
+static unsigned int getU32(const unsigned char* p) {
+	return (getU16(p) << 16) | getU16(p + 2);
+}
+//@endcond
+
+/**Constructs an OSPWriter object to write messages to the given file.
+ *
+ * @param f the pointer to the already open binary FILE where messages will be written
+ * @param v2 true to use the container format, false to use the plain OSP format
+ */
+OSPWriter::OSPWriter(FILE* f, bool v2) {
+	file = f;
+	container = v2;
+	headerWritten = false;
+	nRecords = 0;
+	baseTime = 0;
+}
+
+/**Destructs an OSPWriter object. The file is not closed, and messages pending in the current block are not written
+ * (flush shall be called before closing the file).
+ */
+OSPWriter::~OSPWriter(void) {
+}
+
+/**write writes a message to the file, or adds it to the current block when the container format is used.
+ *
+ * @param payload the pointer to the message payload bytes
+ * @param length the payload length
+ * @param hostTime the host time when the message was received, in milliseconds (ignored in the plain format)
+ * @return true if the message has been written or added, false if a write error happened
+ */
+bool OSPWriter::write(const unsigned char* payload, unsigned int length, long long hostTime) {
+	if (!container) {
+		unsigned char lengthBytes[2];
+		putU16(lengthBytes, length);
+		return fwrite(lengthBytes, 1, 2, file) == 2 && fwrite(payload, 1, length, file) == length;
+	}
+	//times in a block shall be in the interval [baseTime, baseTime + OSP2BLOCKTIME]
+	if (nRecords > 0 && (hostTime < baseTime || hostTime - baseTime > OSP2BLOCKTIME) && !writeBlock()) return false;
+	if (nRecords == 0) baseTime = hostTime;
+	unsigned char recordHead[OSP2RECORDHEADSIZE];
+	putU32(recordHead, (unsigned int) (hostTime - baseTime));
+	putU16(recordHead + 4, length);
+	block.insert(block.end(), recordHead, recordHead + OSP2RECORDHEADSIZE);
+	block.insert(block.end(), payload, payload + length);
+	nRecords++;
+	if (block.size() >= OSP2BLOCKSIZE) return writeBlock();
+	return true;
+}
+
+/**flush writes the messages pending in the current block and flushes the file.
+ *
+ * @return true if data have been written, false if a write error happened
+ */
+bool OSPWriter::flush() {
+	bool ok = !container || writeBlock();
+	return fflush(file) == 0 && ok;
+}
+
+/**writeBlock writes the file header, if not already written, and the current block, if it has messages.
+ *
+ * @return true if data have been written, false if a write error happened
+ */
+bool OSPWriter::writeBlock() {
+	if (!headerWritten) {
+		unsigned char fileHead[OSP2HEADSIZE];
+		memcpy(fileHead, OSP2MAGIC, 4);
+		putU16(fileHead + 4, OSP2VERSION);
+		putU16(fileHead + 6, 0);
+		if (fwrite(fileHead, 1, OSP2HEADSIZE, file) != OSP2HEADSIZE) return false;
+		headerWritten = true;
+	}
+	if (nRecords == 0) return true;
+	unsigned char blockHead[OSP2BLOCKHEADSIZE];
+	memcpy(blockHead, OSP2SYNC, 4);
+	putU32(blockHead + 4, (unsigned int) block.size());
+	putU16(blockHead + 8, nRecords);
+	putU32(blockHead + 10, (unsigned int) ((unsigned long long) baseTime >> 32));
+	putU32(blockHead + 14, (unsigned int) (baseTime & 0xFFFFFFFF));
+	uLong crc = crc32(0L, blockHead + 4, 14);
+	crc = crc32(crc, &block[0], (uInt) block.size());
+	putU32(blockHead + 18, (unsigned int) crc);
+	bool ok = fwrite(blockHead, 1, OSP2BLOCKHEADSIZE, file) == OSP2BLOCKHEADSIZE &&
+		fwrite(&block[0], 1, block.size(), file) == block.size();
+	block.clear();
+	nRecords = 0;
+	return ok;
+}
+
+/**Constructs an OSPContainerSource object to read messages from the given container file.
+ *
+ * @param f the pointer to the already open binary FILE in the container format, positioned at its beginning
+ */
+OSPContainerSource::OSPContainerSource(FILE* f) {
+	file = f;
+	reset();
+	badBlocks = 0;
+}
+
+/**Destructs an OSPContainerSource object. The file is not closed.
+ */
+OSPContainerSource::~OSPContainerSource(void) {
+}
+
+/**reset sets the initial state for reading the file from its beginning.
+ */
+void OSPContainerSource::reset() {
+	pending.clear();
+	filePos = 0;
+	started = false;
+	headerError = false;
+	block.clear();
+	blockPos = 0;
+	blockOffset = 0;
+	baseTime = 0;
+	lastTime = 0;
+}
+
+/**getBytes gets the given number of bytes, using first the ones pending and then reading them from the file.
+ *
+ * @param dest the place where bytes are copied
+ * @param n the number of bytes to get
+ * @return the number of bytes got (less than requested if end of file is found)
+ */
+unsigned int OSPContainerSource::getBytes(unsigned char* dest, unsigned int n) {
+	unsigned int count = 0;
+	while (count < n && !pending.empty()) {
+		dest[count++] = pending.front();
+		pending.pop_front();
+	}
+	if (count < n) count += (unsigned int) fread(dest + count, 1, n - count, file);
+	filePos += count;
+	return count;
+}
+
+/**ungetBytes puts back bytes already got, to be got again in the same order.
+ *
+ * @param src the bytes to put back
+ * @param n the number of bytes
+ */
+void OSPContainerSource::ungetBytes(const unsigned char* src, unsigned int n) {
+	for (unsigned int i=n; i>0; i--) pending.push_front(src[i-1]);
+	filePos -= n;
+}
+
+/**findSync gets bytes until the sync bytes of a block are found.
+ *
+ * @return true if sync bytes were found, false if end of file was reached
+ */
+bool OSPContainerSource::findSync() {
+	unsigned char c;
+	unsigned int matched = 0;
+	while (getBytes(&c, 1) == 1) {
+		if (c == OSP2SYNC[matched]) matched++;
+		else matched = (c == OSP2SYNC[0])? 1: 0;
+		if (matched == sizeof OSP2SYNC) {
+			blockOffset = filePos - sizeof OSP2SYNC;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**readBlock reads the next correct block in the file. It shall have a correct CRC, and its records shall match
+ * the block data length and number of messages. Blocks not correct are skipped, searching for the next sync bytes
+ * after the wrong block sync.
+ *
+ * @return true if a block was read, false if end of file was reached
+ */
+bool OSPContainerSource::readBlock() {
+	unsigned char head[OSP2BLOCKHEADSIZE];
+	while (findSync()) {
+		memcpy(head, OSP2SYNC, sizeof OSP2SYNC);
+		unsigned int nHead = getBytes(head + 4, OSP2BLOCKHEADSIZE - 4);
+		unsigned int nData = 0;
+		if (nHead == OSP2BLOCKHEADSIZE - 4) {
+			unsigned int length = getU32(head + 4);
+			if (length <= OSP2MAXBLOCKSIZE) {
+				block.resize(length);
+				if (length > 0) nData = getBytes(&block[0], length);
+				if (nData == length) {
+					uLong crc = crc32(0L, head + 4, 14);
+					if (length > 0) crc = crc32(crc, &block[0], length);
+					//check records
+					unsigned int nRecords = getU16(head + 8);
+					unsigned int pos = 0;
+					while (nRecords > 0 && pos + OSP2RECORDHEADSIZE <= length) {
+						unsigned int payloadLength = getU16(&block[pos + 4]);
+						if (payloadLength > MAXPAYLOADSIZE) break;
+						pos += OSP2RECORDHEADSIZE + payloadLength;
+						nRecords--;
+					}
+					if (crc == getU32(head + 18) && nRecords == 0 && pos == length) {
+						baseTime = ((long long) getU32(head + 10) << 32) | getU32(head + 14);
+						blockPos = 0;
+						return true;
+					}
+				}
+			}
+		}
+		//wrong block: search sync again from the byte after the wrong sync
+		if (nData > 0) ungetBytes(&block[0], nData);
+		ungetBytes(head + 1, sizeof OSP2SYNC - 1 + nHead);
+		badBlocks++;
+	}
+	block.clear();
+	blockPos = 0;
+	return false;
+}
+
+/**fill sets the message as a view of the next message payload in the file having a wanted MID.
+ * When starting, the file header is checked.
+ *
+ * @param msg the OSPMessage to be set
+ * @return true when a message was provided, false otherwise (wrong file header or end of file found)
+ */
+bool OSPContainerSource::fill(OSPMessage& msg) {
+	if (!started) {
+		unsigned char head[OSP2HEADSIZE];
+		headerError = getBytes(head, OSP2HEADSIZE) != OSP2HEADSIZE || memcmp(head, OSP2MAGIC, 4) != 0
+			|| getU16(head + 4) != OSP2VERSION;
+		started = true;
+	}
+	if (headerError) return false;
+	unsigned int payloadLength;
+	const unsigned char* payload;
+	do {
+		while (blockPos >= block.size())
+			if (!readBlock()) return false;
+		payloadLength = getU16(&block[blockPos + 4]);
+		payload = &block[blockPos + OSP2RECORDHEADSIZE];
+		lastTime = baseTime + getU32(&block[blockPos]);
+		blockPos += OSP2RECORDHEADSIZE + payloadLength;
+	} while (!isWanted(payload, payloadLength));
+	msg.setView(payload, payloadLength);
+	return true;
+}
+
+/**rewind sets the position at the beginning of the file.
+ *
+ * @return true if the file could be positioned at its beginning, false otherwise (f.e. a pipe)
+ */
+bool OSPContainerSource::rewind() {
+	if (FSEEK64(file, 0, SEEK_SET) != 0) return false;
+	reset();
+	badBlocks = 0;
+	return true;
+}
+
+/**tell gets the position of the block containing the next message to be provided.
+ * Note that, if some messages of this block have been already provided, they would be provided again after seeking it.
+ *
+ * @return the file offset of the block, or of the next data to read if no message is pending in the current block
+ */
+long long OSPContainerSource::tell() {
+	return blockPos < block.size()? blockOffset: filePos;
+}
+
+/**seek sets the position at the first block starting at or after the given file offset.
+ *
+ * @param pos the file offset from where the block is searched (f.e. the one given by tell)
+ * @return true if the position could be set, false otherwise
+ */
+bool OSPContainerSource::seek(long long pos) {
+	if (pos < OSP2HEADSIZE) return rewind();
+	if (FSEEK64(file, pos, SEEK_SET) != 0) return false;
+	reset();
+	started = true;
+	filePos = pos;
+	return true;
+}
+
+/**canSeek tells if the file allows setting positions in it.
+ *
+ * @return true if the file is a disk file allowing positioning, false otherwise
+ */
+bool OSPContainerSource::canSeek() {
+	return OSPFileSource(file).canSeek();
+}
+
+/**hostTime gets the host time when the last message provided was captured.
+ *
+ * @return the host time in milliseconds from 1970-01-01 00:00:00
+ */
+long long OSPContainerSource::hostTime() {
+	return lastTime;
+}
+
+/**getBadBlocks gets the number of blocks skipped because of wrong CRC or data.
+ *
+ * @return the number of blocks skipped
+ */
+unsigned int OSPContainerSource::getBadBlocks() {
+	return badBlocks;
+}
+
+/**hasErrors tells if errors were found in the file (wrong header or blocks skipped).
+ *
+ * @return true if errors were found, false otherwise
+ */
+bool OSPContainerSource::hasErrors() {
+	return headerError || badBlocks > 0;
+}
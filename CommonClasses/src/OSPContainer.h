@@ -0,0 +1,126 @@
+/** @file OSPContainer.h
+ * Contains the definition of the OSPWriter and OSPContainerSource classes, used to write and read OSP files
+ * in the container format (v2), having capture times and block checksums.
+ *
+ *Copyright 2015 Francisco Cancillo
+ *<p>
+ *This file is part of the RXtoRINEX tool.
+ *<p>
+ *RXtoRINEX is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *RXtoRINEX is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ *warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *See the GNU General Public License for more details.
+ *<p>
+ *A copy of the GNU General Public License can be found at <http://www.gnu.org/licenses/>.
+ *
+ *V1.0	First release
+ */
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+#include <deque>
+
+//from CommonClasses
+#include "OSPSource.h"
+
+using namespace std;
+
+///The identification bytes at the beginning of container files
+#define OSP2MAGIC "OSP2"
+///The version of the container format
+#define OSP2VERSION 2
+///The size in bytes of the container file header: identification (4), version (2), reserved (2)
+#define OSP2HEADSIZE 8
+///The size in bytes of a block header: sync (4), data length (4), messages (2), base host time (8), CRC (4)
+#define OSP2BLOCKHEADSIZE 22
+///The size in bytes of the header of each message record in a block: host time offset (4), payload length (2)
+#define OSP2RECORDHEADSIZE 6
+///The block data size that, when reached, makes the writer to close the block
+#define OSP2BLOCKSIZE 65536
+///The maximum block data size: the block size plus the last record added
+#define OSP2MAXBLOCKSIZE (OSP2BLOCKSIZE + OSP2RECORDHEADSIZE + MAXPAYLOADSIZE)
+///The maximum time span (in milliseconds) of messages in a block
+#define OSP2BLOCKTIME 10000
+
+/**OSPWriter class writes OSP messages to a binary FILE, using the plain OSP format (payload length and payload bytes
+ * for each message) or the container format (v2).
+ *<p>
+ * A container file has the following structure (multi byte numbers are big endians, as in OSP messages):
+ *	- A file header with the identification bytes "OSP2", the format version and two reserved bytes.
+ *	- A sequence of blocks, each one having a header and a data part. The block header contains the sync bytes
+ *	  (A0 A2 B0 B3), the data part length, the number of messages, the base host time, and a CRC-32 computed over
+ *	  the header data after the sync bytes and the data part.
+ *	- The data part of a block has a record for each message, containing the host time when it was received
+ *	  (as an offset in milliseconds from the block base time), the payload length and the payload bytes.
+ *<p>
+ * Host times are milliseconds from 1970-01-01 00:00:00 in the computer clock where messages were captured.
+ * Note that a container file cannot be taken as a plain one, because its first byte would give a payload length
+ * greater than the maximum allowed.
+ *<p>
+ * Messages are accumulated in a block, which is written when its data size reaches OSP2BLOCKSIZE bytes, when
+ * the time span of its messages exceeds OSP2BLOCKTIME milliseconds, or when the writer is flushed.
+ * The writer shall be flushed before closing the file.
+ */
+class OSPWriter {
+	FILE* file;						//the output file
+	bool container;					//true if the container format is used
+	bool headerWritten;				//true when the container file header has been written
+	vector<unsigned char> block;	//the data part of the current block
+	unsigned int nRecords;			//the number of messages in the current block
+	long long baseTime;				//the host time of the first message in the current block
+
+	bool writeBlock();
+
+public:
+	OSPWriter(FILE*, bool);
+	~OSPWriter(void);
+	bool write(const unsigned char*, unsigned int, long long);
+	bool flush();
+};
+
+/**OSPContainerSource class provides OSP messages from a binary FILE in the container format (v2), and the host time
+ * when each one was captured (see OSPWriter for a description of the format).
+ *<p>
+ * Blocks are read one at a time, checking their CRC. Blocks with wrong CRC or data are skipped, searching the sync
+ * bytes of the next block. Thus, damaged data only lose the messages of the blocks affected.
+ *<p>
+ * Messages provided are views of payloads in the current block. A message provided remains valid until the next
+ * one is requested.
+ *<p>
+ * Positions in the source are file offsets of blocks: tell gives the offset of the block containing the next message,
+ * and seek sets the position at the first block found from the given offset. Positions can be set only when the FILE
+ * allows it.
+ */
+class OSPContainerSource : public OSPSource {
+	FILE* file;						//the container file
+	deque<unsigned char> pending;	//bytes read from the file, but not used, when searching sync bytes
+	long long filePos;				//the file offset of the next byte to use
+	bool started;					//true when the file header has been read
+	bool headerError;				//true when the file header is not correct
+	vector<unsigned char> block;	//the data part of the current block
+	unsigned int blockPos;			//position in the current block of the next record
+	long long blockOffset;			//the file offset of the current block
+	long long baseTime;				//the base host time of the current block
+	long long lastTime;				//the host time of the last message provided
+	unsigned int badBlocks;			//the number of blocks skipped because of errors
+
+	void reset();
+	unsigned int getBytes(unsigned char*, unsigned int);
+	void ungetBytes(const unsigned char*, unsigned int);
+	bool findSync();
+	bool readBlock();
+
+public:
+	OSPContainerSource(FILE*);
+	~OSPContainerSource(void);
+	bool fill(OSPMessage&);
+	bool rewind();
+	long long tell();
+	bool seek(long long);
+	bool canSeek();
+	long long hostTime();
+	unsigned int getBadBlocks();
+	bool hasErrors();
+};
@@ -0,0 +1,197 @@
+/** @file OSPGzipSource.cpp
+ * Contains the implementation of the OSPGzipSource class.
+ */
+
+#include "OSPGzipSource.h"
+#include "OSPContainer.h"
+#include "OSPPrefetchSource.h"
+#include "FileOffset.h"
+
+#include <string.h>
+
+//@cond DUMMY
+//the size of the buffer for compressed data read from the file
+#define GZINSIZE 65536
+//the first byte of gzip compressed data
+#define GZID1 0x1F
+//@endcond
+
+/**Constructs an OSPGzipSource object to read messages from the given compressed file.
+ * The reader thread is started to decompress data from the current file position.
+ *
+ * @param f the pointer to the already open binary FILE with gzip compressed OSP data
+ */
+OSPGzipSource::OSPGzipSource(FILE* f) {
+	file = f;
+	seekable = OSPFileSource(file).canSeek();
+	inBuffer.resize(GZINSIZE);
+	streamEnd = firstBlock = false;
+	containerData = false;
+	setBlocks(GZBLOCKSIZE, GZBLOCKS, 1);
+	start(0);
+}
+
+/**Destructs an OSPGzipSource object, stopping the reader thread. The file is not closed.
+ */
+OSPGzipSource::~OSPGzipSource(void) {
+	stop();
+}
+
+/**beginReading initializes the zlib stream to decompress gzip data. It is called from the reader thread.
+ *
+ * @return true if the stream could be initialized, false otherwise
+ */
+bool OSPGzipSource::beginReading() {
+	memset(&strm, 0, sizeof strm);
+	streamEnd = false;
+	firstBlock = true;
+	return inflateInit2(&strm, 15 + 16) == Z_OK;	//gzip format only
+}
+
+/**readBlock reads compressed data from the file and decompresses them into the given block until it is full or
+ * no more data exist. Concatenated gzip members are decompressed one after another.
+ * If the first block decompressed starts with the container identification bytes, decompression finishes with error
+ * and no data are provided (see isContainer).
+ * It is called from the reader thread.
+ *
+ * @param block the block to fill
+ * @param size the size in bytes of the block
+ * @param last set to true when all data have been decompressed or an error happened
+ * @param error set to true when compressed data are not correct or are truncated
+ * @return the number of bytes decompressed
+ */
+unsigned int OSPGzipSource::readBlock(unsigned char* block, unsigned int size, bool& last, bool& error) {
+	strm.next_out = block;
+	strm.avail_out = size;
+	while (strm.avail_out > 0) {
+		if (strm.avail_in == 0) {
+			strm.avail_in = (uInt) fread(&inBuffer[0], 1, GZINSIZE, file);
+			strm.next_in = &inBuffer[0];
+			if (strm.avail_in == 0) {	//no more compressed data
+				last = true;
+				error = !streamEnd;		//data are truncated if the gzip member is not complete
+				break;
+			}
+		}
+		streamEnd = false;
+		int ret = inflate(&strm, Z_NO_FLUSH);
+		if (ret == Z_STREAM_END) {	//a gzip member finished; next data, if any, would be another member
+			streamEnd = true;
+			inflateReset(&strm);
+		} else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+			last = error = true;
+			break;
+		}
+	}
+	unsigned int length = size - strm.avail_out;
+	if (firstBlock) {
+		firstBlock = false;
+		if (length >= OSP2HEADSIZE && memcmp(block, OSP2MAGIC, strlen(OSP2MAGIC)) == 0) {
+			containerData = true;
+			last = error = true;
+			return 0;
+		}
+	}
+	return length;
+}
+
+/**endReading releases the zlib stream. It is called from the reader thread.
+ */
+void OSPGzipSource::endReading() {
+	inflateEnd(&strm);
+}
+
+/**rewind restarts decompression from the beginning of the file.
+ * When the file does not allow positioning, the source is left unchanged.
+ *
+ * @return true if the file could be positioned at its beginning, false otherwise (f.e. a pipe)
+ */
+bool OSPGzipSource::rewind() {
+	if (!seekable) return false;
+	stop();
+	if (FSEEK64(file, 0, SEEK_SET) != 0) return false;	//no more data will be decompressed
+	start(0);
+	return true;
+}
+
+/**seek sets the position of the next message to be provided. Only the current position can be set.
+ *
+ * @param pos the byte offset from the beginning of the decompressed data
+ * @return true if the position is the current one, false otherwise
+ */
+bool OSPGzipSource::seek(long long pos) {
+	return pos == tell();
+}
+
+/**canSeek tells if positions can be set in the source. Compressed sources do not allow it.
+ *
+ * @return false
+ */
+bool OSPGzipSource::canSeek() {
+	return false;
+}
+
+/**isContainer tells if decompressed data are in the container format, which is not supported for compressed files.
+ * It is known once the first message has been requested.
+ *
+ * @return true if the decompressed data are a container file, false otherwise
+ */
+bool OSPGzipSource::isContainer() {
+	return containerData;
+}
+
+/**newOSPStreamSource creates the source to read messages from the given FILE, taking into account if it contains
+ * gzip compressed data, data in the container format, or plain OSP data (the first byte is checked without consuming it).
+ * Note that valid OSP data cannot start with the gzip or container identification bytes, as payload length would
+ * exceed the maximum.
+ * The source created shall be deleted by the caller.
+ *
+ * @param f the pointer to the already open binary FILE with OSP data
+ * @return the OSPGzipSource, OSPContainerSource or OSPFileSource created
+ */
+OSPSource* newOSPStreamSource(FILE* f) {
+	return newOSPStreamSource(f, 0, 0);
+}
+
+/**newOSPStreamSource creates the source to read messages from the given FILE, as above, but plain OSP data are read
+ * by an OSPPrefetchSource when prefetch blocks are requested.
+ * The source created shall be deleted by the caller.
+ *
+ * @param f the pointer to the already open binary FILE with OSP data
+ * @param blockSize the size in bytes of prefetch blocks (0 for the default one)
+ * @param blocks the number of prefetch blocks, or 0 to read plain OSP data without prefetching
+ * @return the OSPGzipSource, OSPContainerSource, OSPPrefetchSource or OSPFileSource created
+ */
+OSPSource* newOSPStreamSource(FILE* f, unsigned int blockSize, unsigned int blocks) {
+	int c = getc(f);
+	if (c != EOF) ungetc(c, f);
+	if (c == GZID1) return new OSPGzipSource(f);
+	if (c == OSP2MAGIC[0]) return new OSPContainerSource(f);
+	if (blocks > 0) return new OSPPrefetchSource(f, blockSize, blocks);
+	return new OSPFileSource(f);
+}
+
+/**logOSPStreamSource logs the errors found by a source created by newOSPStreamSource once messages have been read
+ * from it, and the performance data of prefetching sources. When prefetch was requested but the source does not
+ * prefetch data (compressed or container files), it is also reported.
+ *
+ * @param source the source created by newOSPStreamSource
+ * @param fileName the name of the file read by the source
+ * @param prefetch true if prefetch blocks were requested for the source
+ * @param plog the Logger to be used to record messages
+ */
+void logOSPStreamSource(OSPSource* source, string fileName, bool prefetch, Logger* plog) {
+	OSPGzipSource* gzSource = dynamic_cast<OSPGzipSource*>(source);
+	if (gzSource != NULL && gzSource->isContainer())
+		plog->severe("Compressed container files are not supported: " + fileName + " shall be decompressed before processing");
+	else if (gzSource != NULL && gzSource->hasErrors()) plog->warning("Wrong or truncated compressed data in " + fileName);
+	OSPContainerSource* v2Source = dynamic_cast<OSPContainerSource*>(source);
+	if (v2Source != NULL && v2Source->hasErrors())
+		plog->warning("Wrong header or damaged blocks in " + fileName + ". Blocks skipped: " + to_string((long long) v2Source->getBadBlocks()));
+	OSPPrefetchSource* pfSource = dynamic_cast<OSPPrefetchSource*>(source);
+	if (pfSource != NULL) {
+		if (pfSource->hasErrors()) plog->warning("Read error in " + fileName);
+		plog->info("Prefetch stalls: " + to_string((long long) pfSource->getStalls()) +
+			". Time waiting for data (s): " + to_string((long double) pfSource->getStallTime()));
+	} else if (prefetch) plog->warning("Prefetch not used: " + fileName + " is compressed or in the container format");
+}
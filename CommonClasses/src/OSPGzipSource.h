@@ -0,0 +1,71 @@
+/** @file OSPGzipSource.h
+ * Contains the definition of the OSPGzipSource class, used to read messages from gzip compressed OSP files.
+ *
+ *Copyright 2015 Francisco Cancillo
+ *<p>
+ *This file is part of the RXtoRINEX tool.
+ *<p>
+ *RXtoRINEX is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *RXtoRINEX is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ *warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *See the GNU General Public License for more details.
+ *<p>
+ *A copy of the GNU General Public License can be found at <http://www.gnu.org/licenses/>.
+ *
+ *V1.0	First release
+ */
+#pragma once
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <zlib.h>
+
+//from CommonClasses
+#include "OSPBlockSource.h"
+#include "Logger.h"
+
+using namespace std;
+
+///The size in bytes of each block of decompressed data
+#define GZBLOCKSIZE 262144
+///The number of blocks of decompressed data
+#define GZBLOCKS 4
+
+/**OSPGzipSource class provides OSP messages from a gzip compressed OSP binary FILE (or from a sequence of gzip members).
+ * Compressed data are read and decompressed by a reader thread into a set of blocks (see OSPBlockSource), while messages
+ * are provided from blocks already decompressed. Thus, decompression of next data overlaps with message processing.
+ * Errors are reported when compressed data are not correct or are truncated.
+ * Compressed container files (see OSPContainerSource) are not supported: they are reported and no message is provided.
+ *<p>
+ * The source can be rewound only when the FILE allows positioning. Other positions cannot be set.
+ */
+class OSPGzipSource : public OSPBlockSource {
+	FILE* file;						//the compressed OSP file
+	bool seekable;					//the file allows positioning
+	//the decompression state, used only by the reader thread
+	z_stream strm;					//the zlib stream
+	vector<unsigned char> inBuffer;	//the buffer for compressed data read from the file
+	bool streamEnd;					//the end of the last gzip member has been reached
+	bool firstBlock;				//the next block to fill is the first one
+	atomic<bool> containerData;		//decompressed data are in the container format
+
+protected:
+	bool beginReading();
+	unsigned int readBlock(unsigned char*, unsigned int, bool&, bool&);
+	void endReading();
+
+public:
+	OSPGzipSource(FILE*);
+	~OSPGzipSource(void);
+	bool rewind();
+	bool seek(long long);
+	bool canSeek();
+	bool isContainer();
+};
+
+OSPSource* newOSPStreamSource(FILE*);	//create the source for a compressed, container or plain OSP FILE
+OSPSource* newOSPStreamSource(FILE*, unsigned int, unsigned int);	//idem, prefetching plain OSP data by blocks
+void logOSPStreamSource(OSPSource*, string, bool, Logger*);	//log errors found by a source given by newOSPStreamSource
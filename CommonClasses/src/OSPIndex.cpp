@@ -0,0 +1,207 @@
+/** @file OSPIndex.cpp
+ * Contains the implementation of the OSPIndex class.
+ */
+
+#include "OSPIndex.h"
+
+#include <stdio.h>
+#include <string.h>
+
+//@cond DUMMY
+//the identification text at the beginning of index files
+const char OSPIDXID[8] = {'O', 'S', 'P', 'I', 'D', 'X', '0', '1'};
+//the sizes in bytes of the index file header and of each entry
+#define IDXHEADSIZE 24
+#define IDXENTRYSIZE 17
+//the minimum size in bytes of a message in the OSP file (payload length, for messages without payload)
+#define MINMSGSIZE 2
+
+//local functions to store / extract numbers in buffers with the most significant byte first
+static void putNumber(unsigned char* p, unsigned long long value, int nbytes) {
+	for (int i=nbytes-1; i>=0; i--) {
+		p[i] = (unsigned char) (value & 0xFF);
+		value >>= 8;
+	}
+}
+
+static unsigned long long getNumber(const unsigned char* p, int nbytes) {
+	unsigned long long value = 0;
+	for (int i=0; i<nbytes; i++) value = (value << 8) | p[i];
+	return value;
+}
+//@endcond
+
+/**Constructs an empty OSPIndex object.
+ */
+OSPIndex::OSPIndex(void) {
+	ospSize = 0;
+}
+
+/**Destructs OSPIndex objects.
+ */
+OSPIndex::~OSPIndex(void) {
+}
+
+/**build builds the index reading all messages in the OSP source from its current position.
+ * Times of messages are set from the MID7 message closing the epoch they belong to.
+ *
+ * @param source the OSPSource providing the messages to index
+ * @param fileSize the size in bytes of the OSP file, stored to detect index files not matching it
+ * @return true if at least a message has been indexed, false otherwise
+ */
+bool OSPIndex::build(OSPSource& source, long long fileSize) {
+	OSPMessage message;
+	OSPIndexEntry entry;
+	unsigned int epochStart = 0;	//index of the first entry of the current epoch
+	int week = 0;
+	unsigned int tow = 0;
+	entries.clear();
+	entry.offset = source.tell();
+	while (source.fill(message)) {
+		entry.length = message.payloadLen();
+		entry.mid = entry.length > 0? message.get(): -1;
+		entry.week = 0;
+		entry.tow = 0;
+		entries.push_back(entry);
+		if (entry.mid == 7 && entry.length == 20) {	//a MID7 closes the epoch: set time of its messages
+			week = (int) message.getUShort();
+			tow = message.getUInt();
+			for (unsigned int i=epochStart; i<entries.size(); i++) {
+				entries[i].week = week;
+				entries[i].tow = tow;
+			}
+			epochStart = entries.size();
+		}
+		entry.offset += 2 + entry.length;
+	}
+	//messages after the last MID7 are assigned its time
+	for (unsigned int i=epochStart; i<entries.size(); i++) {
+		entries[i].week = week;
+		entries[i].tow = tow;
+	}
+	ospSize = fileSize;
+	return entries.size() > 0;
+}
+
+/**save writes the index data to the given index file.
+ *
+ * @param fileName the index file name (usually the OSP file name followed by OSPIDXEXT)
+ * @return true if index data have been written, false otherwise
+ */
+bool OSPIndex::save(string fileName) {
+	FILE* idxFile;
+	unsigned char buffer[IDXHEADSIZE];
+	if ((idxFile = fopen(fileName.c_str(), "wb")) == NULL) return false;
+	memcpy(buffer, OSPIDXID, sizeof OSPIDXID);
+	putNumber(buffer + 8, ospSize, 8);
+	putNumber(buffer + 16, entries.size(), 8);
+	bool ok = fwrite(buffer, 1, IDXHEADSIZE, idxFile) == IDXHEADSIZE;
+	for (unsigned int i=0; ok && i<entries.size(); i++) {
+		putNumber(buffer, entries[i].offset, 8);
+		putNumber(buffer + 8, entries[i].mid & 0xFF, 1);	//messages without payload have no MID: it is not used
+		putNumber(buffer + 9, entries[i].length, 2);
+		putNumber(buffer + 11, entries[i].week, 2);
+		putNumber(buffer + 13, entries[i].tow, 4);
+		ok = fwrite(buffer, 1, IDXENTRYSIZE, idxFile) == IDXENTRYSIZE;
+	}
+	if (fclose(idxFile) != 0) ok = false;
+	return ok;
+}
+
+/**load reads index data from the given index file.
+ * Index data are loaded only if they correspond to an OSP file having the given size, the number of entries stated
+ * in the header is possible for this size, and the index file contains exactly these entries.
+ *
+ * @param fileName the index file name (usually the OSP file name followed by OSPIDXEXT)
+ * @param expectedSize the size in bytes of the OSP file being indexed
+ * @return true if index data have been loaded, false otherwise (no index file, wrong format, size or number of entries)
+ */
+bool OSPIndex::load(string fileName, long long expectedSize) {
+	FILE* idxFile;
+	unsigned char buffer[IDXHEADSIZE];
+	OSPIndexEntry entry;
+	entries.clear();
+	if ((idxFile = fopen(fileName.c_str(), "rb")) == NULL) return false;
+	bool ok = (fread(buffer, 1, IDXHEADSIZE, idxFile) == IDXHEADSIZE)
+				&& (memcmp(buffer, OSPIDXID, sizeof OSPIDXID) == 0)
+				&& ((long long) getNumber(buffer + 8, 8) == expectedSize);
+	unsigned long long nEntries = ok? getNumber(buffer + 16, 8): 0;
+	if (ok) ok = nEntries <= (unsigned long long) expectedSize / MINMSGSIZE;
+	if (ok) entries.reserve((size_t) nEntries);
+	for (unsigned long long i=0; ok && i<nEntries; i++) {
+		if ((ok = fread(buffer, 1, IDXENTRYSIZE, idxFile) == IDXENTRYSIZE)) {
+			entry.offset = (long long) getNumber(buffer, 8);
+			entry.length = (unsigned int) getNumber(buffer + 9, 2);
+			entry.mid = entry.length > 0? (int) getNumber(buffer + 8, 1): -1;
+			entry.week = (int) getNumber(buffer + 11, 2);
+			entry.tow = (unsigned int) getNumber(buffer + 13, 4);
+			entries.push_back(entry);
+		}
+	}
+	if (ok) ok = fgetc(idxFile) == EOF;		//no data shall exist after the entries
+	fclose(idxFile);
+	if (ok) ospSize = expectedSize;
+	else entries.clear();
+	return ok;
+}
+
+/**size gets the number of entries in the index.
+ *
+ * @return the number of messages indexed
+ */
+unsigned int OSPIndex::size() {
+	return entries.size();
+}
+
+/**entry gets the index entry at the given position.
+ *
+ * @param n the position of the entry (0 to size()-1)
+ * @return the entry data
+ */
+const OSPIndexEntry& OSPIndex::entry(unsigned int n) {
+	return entries[n];
+}
+
+/**findFirst finds the first entry for a message with the given MID, starting at the given position.
+ *
+ * @param mid the MID of the message to find
+ * @param from the position of the first entry to check
+ * @return the position of the entry found, or -1 if none exists
+ */
+int OSPIndex::findFirst(int mid, unsigned int from) {
+	for (unsigned int i=from; i<entries.size(); i++)
+		if (entries[i].mid == mid) return (int) i;
+	return -1;
+}
+
+/**findLast finds the last entry for a message with the given MID placed before the given position.
+ *
+ * @param mid the MID of the message to find
+ * @param before the position where backward search starts (not checked). Use size() to start at the last entry
+ * @return the position of the entry found, or -1 if none exists
+ */
+int OSPIndex::findLast(int mid, unsigned int before) {
+	if (before > entries.size()) before = entries.size();
+	for (int i=(int) before-1; i>=0; i--)
+		if (entries[i].mid == mid) return i;
+	return -1;
+}
+
+/**findEpoch finds, using a binary search, the first message belonging to the first epoch having a time
+ * equal or after the given one.
+ * It assumes that epochs are recorded in the file in increasing time.
+ *
+ * @param week the GPS week
+ * @param tow the GPS TOW (scaled by 100)
+ * @return the position of the entry found, or size() if all epochs are before the given time
+ */
+int OSPIndex::findEpoch(int week, unsigned int tow) {
+	unsigned int first = 0;
+	unsigned int last = entries.size();
+	while (first < last) {
+		unsigned int middle = first + (last - first) / 2;
+		if ((entries[middle].week < week) || (entries[middle].week == week && entries[middle].tow < tow)) first = middle + 1;
+		else last = middle;
+	}
+	return (int) first;
+}
@@ -0,0 +1,69 @@
+/** @file OSPIndex.h
+ * Contains the OSPIndex class definition.
+ * An OSPIndex object contains, for each message in an OSP binary file, data to locate and identify it
+ * without reading the file.
+ *
+ *Copyright 2015 Francisco Cancillo
+ *<p>
+ *This file is part of the RXtoRINEX tool.
+ *<p>
+ *RXtoRINEX is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *RXtoRINEX is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ *warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *See the GNU General Public License for more details.
+ *<p>
+ *A copy of the GNU General Public License can be found at <http://www.gnu.org/licenses/>.
+ *
+ *V1.0	First release
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+//from CommonClasses
+#include "OSPSource.h"
+
+using namespace std;
+
+///The extension added to the OSP file name to name its index file
+#define OSPIDXEXT ".ospidx"
+
+/**OSPIndexEntry contains index data of a message in the OSP file.
+ */
+struct OSPIndexEntry {
+	long long offset;		///<byte offset in the OSP file of the message (its payload length bytes)
+	int mid;				///<the message identification (first payload byte), or -1 for messages without payload
+	unsigned int length;	///<the payload length in bytes
+	int week;				///<the GPS week of the epoch the message belongs to, as given in its MID7
+	unsigned int tow;		///<the GPS TOW (scaled by 100) of the epoch the message belongs to, as given in its MID7
+};
+
+/**OSPIndex class defines a container for index data of messages in an OSP binary file, and methods to build,
+ * save and load them.
+ * Index data are stored in a sidecar file, having the OSP file name followed by the .ospidx extension.
+ *<p>
+ * Messages in an epoch are sent by the receiver before the MID7 message closing it. Accordingly, the time
+ * assigned to each message is the one in the next MID7. Messages after the last MID7 in the file are assigned
+ * the time of this last MID7.
+ *<p>
+ * The index file contains a header with an identification text, the size of the OSP file indexed and the number
+ * of entries, followed by the entries data. All numbers are stored with the most significant byte first.
+ */
+class OSPIndex {
+	vector<OSPIndexEntry> entries;	//the index entries in the order messages are in the file
+	long long ospSize;				//size in bytes of the OSP file indexed
+
+public:
+	OSPIndex(void);
+	~OSPIndex(void);
+	bool build(OSPSource&, long long);
+	bool save(string);
+	bool load(string, long long);
+	unsigned int size();
+	const OSPIndexEntry& entry(unsigned int);
+	int findFirst(int, unsigned int);
+	int findLast(int, unsigned int);
+	int findEpoch(int, unsigned int);
+};
@@ -0,0 +1,283 @@
+/** @file OSPLayouts.h
+ * Contains the layout definitions of OSP messages used to decode their payload.
+ * For each OSP message used, its layout states the MID, the payload length, and the type and offset in the payload
+ * of each field. From it, a structure is generated containing the fields values and a decode method to extract them
+ * from the message payload.
+ *<p>
+ * Decoding validates the payload length once. Fields are extracted after it without further checking, taking into account
+ * the SiRF byte ordering: integers are big endian, floats are big endian, and doubles are two big endian 32 bits
+ * words with the least significant one first.
+ * Offsets of fields are checked at compile time against the payload length.
+ *<p>
+ * The layout of a new message is defined listing its fields in a macro with two arguments:
+ *	- F(type, name, offset) for single value fields
+ *	- A(type, name, offset, count) for arrays of count values
+ *<p>
+ * and passing it to OSP_LAYOUT with the name of the structure to generate, the MID and the payload length.
+ * Fields not listed are ignored.
+ *
+ *Copyright 2015 Francisco Cancillo
+ *<p>
+ *This file is part of the RXtoRINEX tool.
+ *<p>
+ *RXtoRINEX is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *RXtoRINEX is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ *warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *See the GNU General Public License for more details.
+ *<p>
+ *A copy of the GNU General Public License can be found at <http://www.gnu.org/licenses/>.
+ *
+ *V1.0	First release
+ */
+#pragma once
+
+#include <string.h>
+#include <vector>
+
+//from CommonClasses
+#include "OSPMessage.h"
+
+using namespace std;
+
+/**ospLoad extracts a value of the given type from the payload bytes at p, without any checking.
+ * It is specialized for each type used in OSP messages.
+ *
+ * @param p the pointer to the first payload byte of the value
+ * @return the value extracted
+ */
+template <typename T> T ospLoad(const unsigned char* p);
+
+//@cond DUMMY
+template <> inline unsigned char ospLoad<unsigned char>(const unsigned char* p) {
+	return p[0];
+}
+
+template <> inline signed char ospLoad<signed char>(const unsigned char* p) {
+	return (signed char) p[0];
+}
+
+template <> inline unsigned short ospLoad<unsigned short>(const unsigned char* p) {
+	return (unsigned short) (p[0] << 8 | p[1]);
+}
+
+template <> inline short ospLoad<short>(const unsigned char* p) {
+	return (short) ospLoad<unsigned short>(p);
+}
+
+template <> inline unsigned int ospLoad<unsigned int>(const unsigned char* p) {
+	return (unsigned int) p[0] << 24 | (unsigned int) p[1] << 16 | (unsigned int) p[2] << 8 | (unsigned int) p[3];
+}
+
+template <> inline int ospLoad<int>(const unsigned char* p) {
+	return (int) ospLoad<unsigned int>(p);
+}
+
+template <> inline float ospLoad<float>(const unsigned char* p) {
+	unsigned int bits = ospLoad<unsigned int>(p);
+	float value;
+	memcpy(&value, &bits, sizeof value);
+	return value;
+}
+
+template <> inline double ospLoad<double>(const unsigned char* p) {
+	unsigned long long bits = (unsigned long long) ospLoad<unsigned int>(p + 4) << 32 | ospLoad<unsigned int>(p);
+	double value;
+	memcpy(&value, &bits, sizeof value);
+	return value;
+}
+
+//generators of the layout structure elements for each field
+#define OSP_FIELD_DECLARE(type, name, offset) type name;
+#define OSP_ARRAY_DECLARE(type, name, offset, count) type name[count];
+#define OSP_FIELD_CHECK(type, name, offset) \
+	static_assert((offset) > 0 && (offset) + sizeof(type) <= LENGTH, "OSP field " #name " out of payload");
+#define OSP_ARRAY_CHECK(type, name, offset, count) \
+	static_assert((offset) > 0 && (offset) + (count) * sizeof(type) <= LENGTH, "OSP field " #name " out of payload");
+#define OSP_FIELD_OFFSET(type, name, offset) name##Offset = (offset),
+#define OSP_ARRAY_OFFSET(type, name, offset, count) name##Offset = (offset),
+#define OSP_FIELD_LOAD(type, name, offset) name = ospLoad<type>(p + (offset));
+#define OSP_ARRAY_LOAD(type, name, offset, count) \
+	for (int i=0; i<(count); i++) name[i] = ospLoad<type>(p + (offset) + i * sizeof(type));
+//@endcond
+
+/**ospLoadColumn extracts a value of the given type from each payload in a sequence of payloads of the same length,
+ * placing the values in a column (an array with an element for each payload).
+ * Iterations are independent of each other, allowing compilers to vectorize the byte swapping.
+ *
+ * @param p the pointer to the value in the first payload
+ * @param stride the payload length
+ * @param n the number of payloads
+ * @param column the array where values extracted are placed
+ */
+template <typename T> void ospLoadColumn(const unsigned char* p, unsigned int stride, unsigned int n, T* column) {
+	for (unsigned int i=0; i<n; i++) column[i] = ospLoad<T>(p + i * stride);
+}
+
+/**OSP_LAYOUT generates a structure named layoutName to decode messages with the given MID and payload length,
+ * having the fields listed in FIELDS.
+ * It also has an enumerator nameOffset with the offset of each field.
+ * The decode method of the structure extracts all fields from the message payload if it has the expected length,
+ * and returns OSPOK. Otherwise it returns OSPBADLENGTH, and no field is extracted.
+ * It does not check the MID, which is assumed to be already checked by the caller.
+ */
+#define OSP_LAYOUT(layoutName, mid, length, FIELDS) \
+struct layoutName { \
+	enum {MID = mid, LENGTH = length}; \
+	enum {FIELDS(OSP_FIELD_OFFSET, OSP_ARRAY_OFFSET)}; \
+	FIELDS(OSP_FIELD_DECLARE, OSP_ARRAY_DECLARE) \
+	FIELDS(OSP_FIELD_CHECK, OSP_ARRAY_CHECK) \
+	OSPStatus decode(OSPMessage& message) { \
+		if (message.validate(LENGTH) != OSPOK) return OSPBADLENGTH; \
+		const unsigned char* p = message.payloadData(); \
+		FIELDS(OSP_FIELD_LOAD, OSP_ARRAY_LOAD) \
+		return OSPOK; \
+	} \
+};
+
+///MID2 Measure Navigation Data Out fields
+#define OSP_MID2_FIELDS(F, A) \
+	F(int, x, 1) \
+	F(int, y, 5) \
+	F(int, z, 9) \
+	F(short, vX, 13) \
+	F(short, vY, 15) \
+	F(short, vZ, 17) \
+	F(unsigned char, mode1, 19) \
+	F(unsigned char, hdop2, 20) \
+	F(unsigned char, mode2, 21) \
+	F(unsigned short, week, 22) \
+	F(unsigned int, tow, 24) \
+	F(unsigned char, svs, 28) \
+	A(unsigned char, chPRN, 29, 12)
+OSP_LAYOUT(MID2Layout, 2, 41, OSP_MID2_FIELDS)
+
+///MID7 Clock Status Data fields
+#define OSP_MID7_FIELDS(F, A) \
+	F(unsigned short, week, 1) \
+	F(unsigned int, tow, 3) \
+	F(unsigned char, svs, 7) \
+	F(unsigned int, drift, 8) \
+	F(unsigned int, bias, 12) \
+	F(unsigned int, estGPSTime, 16)
+OSP_LAYOUT(MID7Layout, 7, 20, OSP_MID7_FIELDS)
+///The number of MID7 TOW units (1/100 s) in a GPS week, to compute times including weeks
+#define OSPWEEKTOW 60480000LL
+
+///MID8 50 BPS Data fields
+#define OSP_MID8_FIELDS(F, A) \
+	F(unsigned char, channel, 1) \
+	F(unsigned char, svID, 2) \
+	A(unsigned int, words, 3, 10)
+OSP_LAYOUT(MID8Layout, 8, 43, OSP_MID8_FIELDS)
+
+///MID15 Ephemeris Data fields
+#define OSP_MID15_FIELDS(F, A) \
+	F(unsigned char, svID, 1) \
+	A(unsigned short, data, 2, 45)
+OSP_LAYOUT(MID15Layout, 15, 92, OSP_MID15_FIELDS)
+
+///MID19 Navigation Parameters fields (only masks)
+#define OSP_MID19_FIELDS(F, A) \
+	F(unsigned char, subID, 1) \
+	F(short, elevationMask, 20) \
+	F(unsigned char, powerMask, 22)
+OSP_LAYOUT(MID19Layout, 19, 65, OSP_MID19_FIELDS)
+
+///MID28 Navigation Library Measurement Data fields
+#define OSP_MID28_FIELDS(F, A) \
+	F(unsigned char, channel, 1) \
+	F(unsigned int, timeTag, 2) \
+	F(unsigned char, svID, 6) \
+	F(double, gpsSWTime, 7) \
+	F(double, pseudorange, 15) \
+	F(float, carrierFrequency, 23) \
+	F(double, carrierPhase, 27) \
+	F(unsigned short, timeInTrack, 35) \
+	F(unsigned char, syncFlags, 37) \
+	A(unsigned char, cn0, 38, 10) \
+	F(unsigned short, deltaRangeInterval, 48) \
+	F(unsigned short, meanDeltaRangeTime, 50) \
+	F(short, extrapolationTime, 52) \
+	F(unsigned char, phaseErrorCount, 54) \
+	F(unsigned char, lowPowerCount, 55)
+OSP_LAYOUT(MID28Layout, 28, 56, OSP_MID28_FIELDS)
+
+/**MID28Batch collects the MID28 messages of an epoch and decodes them at once into columns (structure of arrays):
+ * a vector for each field used, having an element for each message collected, in the order they were added.
+ * Payloads are copied when added. The fields needed to group messages in epochs (gpsSWTime and syncFlags) are
+ * extracted when each message is added; the other ones are extracted by decode, field by field for all messages.
+ */
+struct MID28Batch {
+	vector<unsigned char> payloads;	//the payloads of the messages collected
+	vector<unsigned char> channel;
+	vector<unsigned char> svID;
+	vector<double> gpsSWTime;
+	vector<double> pseudorange;
+	vector<float> carrierFrequency;
+	vector<double> carrierPhase;
+	vector<unsigned char> syncFlags;
+	vector<unsigned char> cn0Min;	//the minimum of the ten C/N0 values of each message
+
+	/**size gets the number of messages collected.
+	 *
+	 * @return the number of messages collected
+	 */
+	unsigned int size() const {
+		return (unsigned int) gpsSWTime.size();
+	}
+
+	/**clear removes all messages collected.
+	 */
+	void clear() {
+		payloads.clear();
+		gpsSWTime.clear();
+		syncFlags.clear();
+	}
+
+	/**add adds the given MID28 message to the batch, extracting its gpsSWTime and syncFlags fields.
+	 *
+	 * @param message the MID28 message
+	 * @return OSPOK if the message has the expected length and has been added, OSPBADLENGTH otherwise
+	 */
+	OSPStatus add(OSPMessage& message) {
+		if (message.validate(MID28Layout::LENGTH) != OSPOK) return OSPBADLENGTH;
+		const unsigned char* p = message.payloadData();
+		payloads.insert(payloads.end(), p, p + MID28Layout::LENGTH);
+		gpsSWTime.push_back(ospLoad<double>(p + MID28Layout::gpsSWTimeOffset));
+		syncFlags.push_back(p[MID28Layout::syncFlagsOffset]);
+		return OSPOK;
+	}
+
+	/**removeLast removes the last message added.
+	 */
+	void removeLast() {
+		payloads.resize(payloads.size() - MID28Layout::LENGTH);
+		gpsSWTime.pop_back();
+		syncFlags.pop_back();
+	}
+
+	/**decode extracts the other fields of all messages collected into their columns.
+	 */
+	void decode() {
+		const unsigned int n = size();
+		const unsigned int stride = MID28Layout::LENGTH;
+		channel.resize(n);
+		svID.resize(n);
+		pseudorange.resize(n);
+		carrierFrequency.resize(n);
+		carrierPhase.resize(n);
+		cn0Min.resize(n);
+		if (n == 0) return;
+		const unsigned char* p = &payloads[0];
+		ospLoadColumn(p + MID28Layout::channelOffset, stride, n, &channel[0]);
+		ospLoadColumn(p + MID28Layout::svIDOffset, stride, n, &svID[0]);
+		ospLoadColumn(p + MID28Layout::pseudorangeOffset, stride, n, &pseudorange[0]);
+		ospLoadColumn(p + MID28Layout::carrierFrequencyOffset, stride, n, &carrierFrequency[0]);
+		ospLoadColumn(p + MID28Layout::carrierPhaseOffset, stride, n, &carrierPhase[0]);
+		ospLoadColumn(p + MID28Layout::cn0Offset, stride, n, &cn0Min[0]);
+		for (int j=1; j<10; j++)
+			for (unsigned int i=0; i<n; i++)
+				if (p[i * stride + MID28Layout::cn0Offset + j] < cn0Min[i]) cn0Min[i] = p[i * stride + MID28Layout::cn0Offset + j];
+	}
+};
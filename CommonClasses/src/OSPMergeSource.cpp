@@ -0,0 +1,200 @@
+/** @file OSPMergeSource.cpp
+ * Contains the implementation of the OSPMergeSource class.
+ */
+
+#include "OSPMergeSource.h"
+
+//from CommonClasses
+#include "OSPGzipSource.h"
+#include "OSPLayouts.h"
+#include "Utilities.h"
+
+/**Constructs an OSPMergeSource object without sources.
+ */
+OSPMergeSource::OSPMergeSource(void) {
+	started = false;
+	current = -1;
+	currentPos = 0;
+	lastTime = -1;
+	position = 0;
+	droppedEpochs = droppedMessages = 0;
+}
+
+/**Destructs an OSPMergeSource object, deleting the sources created and closing the files open by addFile.
+ */
+OSPMergeSource::~OSPMergeSource(void) {
+	for (unsigned int i=0; i<ownSources.size(); i++) delete ownSources[i];
+	for (unsigned int i=0; i<ownFiles.size(); i++) closeBinaryFile(ownFiles[i]);
+}
+
+/**addSource adds an already open source to be merged. It shall be added before requesting any message.
+ * The source is not deleted when the OSPMergeSource is destructed.
+ *
+ * @param src the source to add
+ */
+void OSPMergeSource::addSource(OSPSource* src) {
+	Input input;
+	input.source = src;
+	input.time = -1;
+	input.ended = false;
+	inputs.push_back(input);
+}
+
+/**addFile opens the given OSP file and adds it to be merged. It shall be added before requesting any message.
+ * The file is mapped into memory when possible, or read as a stream otherwise (f.e. if it is compressed or in the container format).
+ *
+ * @param fileName the name of the OSP file
+ * @return true if the file has been open, false otherwise
+ */
+bool OSPMergeSource::addFile(string fileName) {
+	OSPMappedSource* mapped = new OSPMappedSource();
+	if (fileName.compare("-") != 0 && mapped->open(fileName) && !mapped->isGzipped() && !mapped->isContainer()) {
+		ownSources.push_back(mapped);
+		addSource(mapped);
+		return true;
+	}
+	delete mapped;
+	FILE* file = openBinaryFile(fileName, false);
+	if (file == NULL) return false;
+	ownFiles.push_back(file);
+	OSPSource* src = newOSPStreamSource(file);
+	ownSources.push_back(src);
+	addSource(src);
+	return true;
+}
+
+/**readEpoch reads from the given input the messages of its next epoch, up to a MID7 message, and queues its time.
+ * If no MID7 message is found, the input is marked as ended and messages read are dropped.
+ *
+ * @param i the index of the input
+ */
+void OSPMergeSource::readEpoch(int i) {
+	Input& input = inputs[i];
+	MID7Layout mid7;
+	unsigned int nMessages = 0;
+	input.epoch.clear();
+	while (input.source->fill(inMessage)) {
+		unsigned int length = inMessage.payloadLen();
+		input.epoch.push_back((unsigned char) (length >> 8));
+		input.epoch.push_back((unsigned char) (length & 0xFF));
+		input.epoch.insert(input.epoch.end(), inMessage.payloadData(), inMessage.payloadData() + length);
+		nMessages++;
+		if (length > 0 && inMessage.get() == MID7Layout::MID && mid7.decode(inMessage) == OSPOK) {
+			input.time = mid7.week * OSPWEEKTOW + mid7.tow;
+			heads.push(make_pair(input.time, i));
+			return;
+		}
+	}
+	droppedMessages += nMessages;
+	input.epoch.clear();
+	input.ended = true;
+}
+
+/**start reads the first epoch of each input.
+ */
+void OSPMergeSource::start() {
+	for (unsigned int i=0; i<inputs.size(); i++) readEpoch(i);
+	started = true;
+}
+
+/**fill sets the message as a view of the next message in the merged source having a wanted MID.
+ * Sources are read without filtering, because the MID7 messages are needed to merge epochs.
+ * When all messages of the current epoch have been provided, the oldest epoch at the head of the sources
+ * is selected, dropping the ones having a time not later than the last epoch provided.
+ *
+ * @param msg the OSPMessage to be set
+ * @return true when a message was provided, false otherwise (no more epochs in sources)
+ */
+bool OSPMergeSource::fill(OSPMessage& msg) {
+	if (!started) start();
+	do {
+		while (current < 0 || currentPos + 2 > inputs[current].epoch.size()) {
+			if (current >= 0) {	//the current epoch has been provided: read the next one from its input
+				readEpoch(current);
+				current = -1;
+			}
+			if (heads.empty()) return false;
+			pair<long long, int> head = heads.top();
+			heads.pop();
+			if (head.first <= lastTime) {	//duplicated or out of order: drop it
+				droppedEpochs++;
+				readEpoch(head.second);
+				continue;
+			}
+			current = head.second;
+			currentPos = 0;
+			lastTime = head.first;
+		}
+		vector<unsigned char>& epoch = inputs[current].epoch;
+		unsigned int length = (epoch[currentPos] << 8) | epoch[currentPos+1];
+		msg.setView(&epoch[currentPos+2], length);
+		currentPos += 2 + length;
+		position += 2 + length;
+	} while (!isWanted(msg.payloadData(), msg.payloadLen()));
+	return true;
+}
+
+/**rewind rewinds all sources to merge them again from their beginning.
+ *
+ * @return true if all sources have been rewound, false otherwise
+ */
+bool OSPMergeSource::rewind() {
+	bool ok = true;
+	for (unsigned int i=0; i<inputs.size(); i++) {
+		ok &= inputs[i].source->rewind();
+		inputs[i].epoch.clear();
+		inputs[i].time = -1;
+		inputs[i].ended = false;
+	}
+	while (!heads.empty()) heads.pop();
+	started = false;
+	current = -1;
+	currentPos = 0;
+	lastTime = -1;
+	position = 0;
+	droppedEpochs = droppedMessages = 0;
+	return ok;
+}
+
+/**tell gets the position of the next message to be provided in the merged stream.
+ *
+ * @return the byte offset from the beginning of the merged stream
+ */
+long long OSPMergeSource::tell() {
+	return position;
+}
+
+/**seek sets the position of the next message to be provided. Only the current position can be set.
+ *
+ * @param pos the byte offset from the beginning of the merged stream
+ * @return true if the position is the current one, false otherwise
+ */
+bool OSPMergeSource::seek(long long pos) {
+	return pos == position;
+}
+
+/**canSeek tells if the merged source can be rewound, that is, if all its sources can.
+ *
+ * @return true if all sources can be rewound, false otherwise
+ */
+bool OSPMergeSource::canSeek() {
+	for (unsigned int i=0; i<inputs.size(); i++)
+		if (!inputs[i].source->canSeek()) return false;
+	return true;
+}
+
+/**getDroppedEpochs gets the number of epochs dropped because their time was not later than the last one provided.
+ *
+ * @return the number of epochs dropped
+ */
+unsigned int OSPMergeSource::getDroppedEpochs() {
+	return droppedEpochs;
+}
+
+/**getDroppedMessages gets the number of messages dropped because they were after the last MID7 in their source.
+ *
+ * @return the number of messages dropped
+ */
+unsigned int OSPMergeSource::getDroppedMessages() {
+	return droppedMessages;
+}
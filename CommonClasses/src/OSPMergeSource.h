@@ -0,0 +1,85 @@
+/** @file OSPMergeSource.h
+ * Contains the definition of the OSPMergeSource class, used to merge chronologically messages from several OSP sources.
+ *
+ *Copyright 2015 Francisco Cancillo
+ *<p>
+ *This file is part of the RXtoRINEX tool.
+ *<p>
+ *RXtoRINEX is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *RXtoRINEX is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ *warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *See the GNU General Public License for more details.
+ *<p>
+ *A copy of the GNU General Public License can be found at <http://www.gnu.org/licenses/>.
+ *
+ *V1.0	First release
+ */
+#pragma once
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <queue>
+#include <functional>
+
+//from CommonClasses
+#include "OSPSource.h"
+
+using namespace std;
+
+/**OSPMergeSource class provides OSP messages from several OSP sources (f.e. files from consecutive capture sessions)
+ * merged in chronological order, as a single continuous source.
+ *<p>
+ * Messages are merged epoch by epoch. An epoch is the sequence of messages in a source ending with a MID7 message,
+ * which gives the GPS time (week and TOW) of the epoch. The epochs at the head of each source are merged selecting
+ * the oldest one (k-way merge). Epochs having a time not later than the last one provided (duplicated epochs from
+ * overlapping sources) are dropped, as well as the messages after the last MID7 in each source.
+ * Only the next epoch of each source is kept in memory.
+ *<p>
+ * Messages provided are views of payloads in the epoch buffers. A message provided remains valid until the next one
+ * is requested. Positions in the merged source are byte offsets in the merged stream; the only position that can be
+ * set is the current one. The merged source can be rewound if all sources can.
+ *<p>
+ * A program using OSPMergeSource would perform the following steps:
+ *	-# Declare the OSPMergeSource object
+ *	-# Add the OSP files to merge using addFile, or already open sources using addSource
+ *	-# Get messages using the fill method until it returns false
+ */
+class OSPMergeSource : public OSPSource {
+	//data of each source merged
+	struct Input {
+		OSPSource* source;			//the source of messages
+		vector<unsigned char> epoch;	//messages of its next epoch (payload length and payload, as in OSP files)
+		long long time;				//the GPS time of the next epoch (TOW scaled by 100, including weeks)
+		bool ended;					//true when the source has no more epochs
+	};
+	vector<Input> inputs;			//the sources merged
+	vector<OSPSource*> ownSources;	//sources created by the object
+	vector<FILE*> ownFiles;			//files open by the object
+	priority_queue<pair<long long, int>, vector<pair<long long, int> >, greater<pair<long long, int> > > heads;	//time and input of next epochs
+	OSPMessage inMessage;			//message read from sources
+	bool started;					//true when the first epochs have been read
+	int current;					//the input whose epoch messages are being provided, or -1 if none
+	unsigned int currentPos;		//position in the current epoch of the next message to provide
+	long long lastTime;				//time of the last epoch provided
+	long long position;				//offset in the merged stream of the next message
+	unsigned int droppedEpochs;		//number of epochs dropped (duplicated or out of order)
+	unsigned int droppedMessages;	//number of messages dropped after the last MID7 in sources
+
+	void start();
+	void readEpoch(int);
+
+public:
+	OSPMergeSource(void);
+	~OSPMergeSource(void);
+	void addSource(OSPSource*);
+	bool addFile(string);
+	bool fill(OSPMessage&);
+	bool rewind();
+	long long tell();
+	bool seek(long long);
+	bool canSeek();
+	unsigned int getDroppedEpochs();
+	unsigned int getDroppedMessages();
+};
@@ -4,11 +4,26 @@
 
 #include "OSPMessage.h"
 
+#include <string.h>
+
 /**Constructs and empty OSPMessage object.
  */
 OSPMessage::OSPMessage(void) {
+	payload = buffer;
 	cursor = 0;
 	payloadLength = 0;
+	status = OSPOK;
+}
+
+/**Constructs an OSPMessage object copying data from other.
+ * If the payload of the other message is in its buffer, it is copied to the buffer of the new one.
+ * If it is a view, the new message will be a view of the same payload.
+ *
+ * @param other the OSPMessage to copy
+ */
+OSPMessage::OSPMessage(const OSPMessage& other) {
+	payload = buffer;
+	*this = other;
 }
 
 /**Destructs OSPmessage objects.
@@ -16,6 +31,23 @@ OSPMessage::OSPMessage(void) {
 OSPMessage::~OSPMessage(void) {
 }
 
+/**operator= assigns to this message data from other, taking into account where the other payload is stored.
+ *
+ * @param other the OSPMessage to copy
+ * @return this message
+ */
+OSPMessage& OSPMessage::operator=(const OSPMessage& other) {
+	if (this == &other) return *this;
+	payloadLength = other.payloadLength;
+	cursor = other.cursor;
+	status = other.status;
+	if (other.payload == other.buffer) {
+		memcpy(buffer, other.buffer, payloadLength);
+		payload = buffer;
+	} else payload = other.payload;
+	return *this;
+}
+
 /**fill fills a OSPMessage object buffer with data extracted from next message in the OSP binary file.
  * First the length of next payload message is read, and then the payload bytes are read into the payload buffer.
  * The payload buffer cursor for further extractions from the buffer is set to 0.
@@ -27,18 +59,72 @@ OSPMessage::~OSPMessage(void) {
  * @return true when a message was correctly read, false otherwise (read error or end of file found)
  */
 bool OSPMessage::fill(FILE* file) {
-	unsigned char buffer[2];
+	unsigned char lenBuffer[2];
 
 	cursor = 0;
+	payload = buffer;
+	status = OSPOK;
 	//read message length from the input stream
-	if (fread(buffer, 1, 2, file) < 2) return false;
-	payloadLength = (buffer[0] << 8) | buffer[1];	//numbers in msg are big endians
+	if (fread(lenBuffer, 1, 2, file) < 2) return false;
+	payloadLength = (lenBuffer[0] << 8) | lenBuffer[1];	//numbers in msg are big endians
 	//read payload bytes
 	if (payloadLength > MAXPAYLOADSIZE) return false;
-	if (fread(payload, 1, payloadLength, file) < payloadLength) return false;
+	if (fread(buffer, 1, payloadLength, file) < payloadLength) return false;
+	return true;
+}
+
+/**fill fills a OSPMessage object buffer with data extracted from the next message in the OSP binary file having
+ * a wanted MID. Messages without payload are also provided.
+ * For messages not wanted only the payload length and the MID are read, and the rest of the payload is skipped
+ * positioning the file after it. If the file does not allow positioning (f.e. a pipe), the payload bytes are read
+ * into the buffer.
+ *
+ * @param file the pointer to the OSP binary FILE containing messages
+ * @param wanted an array of 256 booleans, with true for the wanted MIDs
+ * @return true when a message was correctly read, false otherwise (read error or end of file found)
+ */
+bool OSPMessage::fill(FILE* file, const bool* wanted) {
+	unsigned char lenBuffer[2];
+
+	cursor = 0;
+	payload = buffer;
+	status = OSPOK;
+	while (true) {
+		if (fread(lenBuffer, 1, 2, file) < 2) return false;
+		payloadLength = (lenBuffer[0] << 8) | lenBuffer[1];	//numbers in msg are big endians
+		if (payloadLength > MAXPAYLOADSIZE) return false;
+		if (payloadLength == 0) return true;
+		if (fread(buffer, 1, 1, file) < 1) return false;
+		if (wanted[buffer[0]]) break;
+		//skip the rest of the payload
+		if (payloadLength > 1 && fseek(file, payloadLength - 1, SEEK_CUR) != 0
+			&& fread(buffer + 1, 1, payloadLength - 1, file) < payloadLength - 1) return false;
+	}
+	if (fread(buffer + 1, 1, payloadLength - 1, file) < payloadLength - 1) return false;
 	return true;
 }
 
+/**setView sets the payload of this message as a view of payload bytes stored elsewhere, without copying them.
+ * The payload bytes shall remain available while the message is in use.
+ * The payload buffer cursor for further extractions is set to 0.
+ *
+ * @param p the pointer to the first payload byte
+ * @param length the payload length in bytes
+ */
+void OSPMessage::setView(const unsigned char* p, unsigned int length) {
+	payload = p;
+	payloadLength = length;
+	cursor = 0;
+	status = OSPOK;
+}
+
+/**restart sets the payload cursor to 0 to allow extracting again data from the current message.
+ */
+void OSPMessage::restart() {
+	cursor = 0;
+	status = OSPOK;
+}
+
 /**skipBytes skips the number of bytes stated in the argument from the payload buffer.
  * It increments the payload cursor to allow next data extraction of values after bytes skipped. 
  *
@@ -59,14 +145,43 @@ unsigned int OSPMessage::payloadLen() {
 	return payloadLength;
 }
 
+/**payloadData provides the pointer to the current payload bytes
+ *
+ * @return the pointer to the first payload byte (the MID)
+ */
+const unsigned char* OSPMessage::payloadData() {
+	return payload;
+}
+
+/**validate checks the payload length against the one expected for the message.
+ * After a successful validation, fields inside the expected length can be extracted without further checks.
+ *
+ * @param expectedLength the payload length expected for the message
+ * @return OSPOK if payload has the expected length, OSPBADLENGTH otherwise (the message status is also set)
+ */
+OSPStatus OSPMessage::validate(unsigned int expectedLength) {
+	if (payloadLength != expectedLength) status = OSPBADLENGTH;
+	return payloadLength == expectedLength? OSPOK: OSPBADLENGTH;
+}
+
+/**getStatus provides the status of data extraction from the current payload.
+ *
+ * @return OSPOK if no errors happened, or the status of the last error
+ */
+OSPStatus OSPMessage::getStatus() {
+	return status;
+}
+
 /**get gets the byte value in the payload at current cursor position.
  * The cursor is incremented by one after getting the byte.
  *
- * @return the byte value at cursor
- * @throws 1 when it is intended to get data after the end of payload 
+ * @return the byte value at cursor, or 0 when it is intended to get data after the end of payload (status is set to OSPOVERRUN)
  */
 int OSPMessage::get() {
-	if (cursor >= payloadLength) throw 1;
+	if (cursor >= payloadLength) {
+		status = OSPOVERRUN;
+		return 0;
+	}
 	unsigned int value = payload[cursor];
 	cursor += 1;
 	return value;
@@ -76,11 +191,13 @@ int OSPMessage::get() {
  * Integers are stored in the payload with the most significant byte first.
  * The cursor is incremented by four
  *
- * @return the integer value of the four bytes starting at cursor 
- * @throws 2 when it is intended to get data after the end of payload 
+ * @return the integer value of the four bytes starting at cursor, or 0 when it is intended to get data after the end of payload (status is set to OSPOVERRUN)
  */
 int OSPMessage::getInt() {
-	if (cursor+3 >= payloadLength) throw 2;
+	if (cursor+3 >= payloadLength) {
+		status = OSPOVERRUN;
+		return 0;
+	}
 	unsigned int value = 
 		payload[cursor] << 24 |
 		payload[cursor+1] << 16 |
@@ -94,11 +211,13 @@ int OSPMessage::getInt() {
  * Integers are stored in the payload with the most significant byte first.
  * The cursor is incremented by four
  *
- * @return the unsigned integer value of the four bytes starting at cursor 
- * @throws 3 when it is intended to get data after the end of payload 
+ * @return the unsigned integer value of the four bytes starting at cursor, or 0 when it is intended to get data after the end of payload (status is set to OSPOVERRUN)
  */
 unsigned int OSPMessage::getUInt() {
-	if (cursor+3 >= payloadLength) throw 3;
+	if (cursor+3 >= payloadLength) {
+		status = OSPOVERRUN;
+		return 0;
+	}
 	unsigned int value = 
 		payload[cursor] << 24 |
 		payload[cursor+1] << 16 |
@@ -112,11 +231,13 @@ unsigned int OSPMessage::getUInt() {
  * Integers are stored in the payload with the most significant byte first.
  * The cursor is incremented by four
  *
- * @return the short integer value of the two bytes starting at cursor 
- * @throws 4 when it is intended to get data after the end of payload 
+ * @return the short integer value of the two bytes starting at cursor, or 0 when it is intended to get data after the end of payload (status is set to OSPOVERRUN)
  */
 short OSPMessage::getShort() {
-	if (cursor+1 >= payloadLength) throw 4;
+	if (cursor+1 >= payloadLength) {
+		status = OSPOVERRUN;
+		return 0;
+	}
 	unsigned short value = payload[cursor] << 8 | payload[cursor+1];
 	cursor += 2;
 	return value;
@@ -126,11 +247,13 @@ short OSPMessage::getShort() {
  * Integers are stored in the payload with the most significant byte first.
  * The cursor is incremented by four
  *
- * @return the unsigned short integer value of the two bytes starting at cursor 
- * @throws 5 when it is intended to get data after the end of payload 
+ * @return the unsigned short integer value of the two bytes starting at cursor, or 0 when it is intended to get data after the end of payload (status is set to OSPOVERRUN)
  */
 unsigned short OSPMessage::getUShort() {
-	if (cursor+1 >= payloadLength) throw 5;
+	if (cursor+1 >= payloadLength) {
+		status = OSPOVERRUN;
+		return 0;
+	}
 	unsigned short value = payload[cursor] << 8 | payload[cursor+1];
 	cursor += 2;
 	return value;
@@ -140,13 +263,15 @@ unsigned short OSPMessage::getUShort() {
  * Floating numbers are stored in the payload with bytes in reverse order.
  * The cursor is incremented by four
  *
- * @return the float value of the four bytes starting at cursor
- * @throws 6 when it is intended to get data after the end of payload 
+ * @return the float value of the four bytes starting at cursor, or 0 when it is intended to get data after the end of payload (status is set to OSPOVERRUN)
  */
 float OSPMessage::getFloat() {
 	unsigned char buffer[4];
 	float* p2value = (float*) buffer;
-	if (cursor+3 >= payloadLength) throw 6;
+	if (cursor+3 >= payloadLength) {
+		status = OSPOVERRUN;
+		return 0;
+	}
 	buffer[0] = payload[cursor + 3];
 	buffer[1] = payload[cursor + 2];
 	buffer[2] = payload[cursor + 1];
@@ -158,13 +283,15 @@ float OSPMessage::getFloat() {
 /**getDouble gets eight bytes starting at cursor which are interpreted as a 64 bits floating number.
  * Double numbers are stored in the payload with bytes in the following order: 3, 2, 1, 0, 4, 5, 6, 7.
  *
- * @return : the float value of the eight bytes starting at cursor 
- * @throws 7 when it is intended to get data after the end of payload 
+ * @return : the float value of the eight bytes starting at cursor, or 0 when it is intended to get data after the end of payload (status is set to OSPOVERRUN)
  */
 double OSPMessage::getDouble() {
 	unsigned char buffer[8];
 	double* p2value = (double*) buffer;
-	if (cursor+7 >= payloadLength) throw 7;
+	if (cursor+7 >= payloadLength) {
+		status = OSPOVERRUN;
+		return 0;
+	}
 	buffer[0] = payload[cursor + 3];
 	buffer[1] = payload[cursor + 2];
 	buffer[2] = payload[cursor + 1];
@@ -22,24 +22,46 @@
 ///The maximum size in bytes of any message payload
 #define MAXPAYLOADSIZE 2048
 
+/**OSPStatus defines the status values of data extraction from a message payload.
+ */
+enum OSPStatus {
+	OSPOK = 0,		///<data extracted from the payload are correct
+	OSPBADLENGTH,	///<the payload length is not the one expected for the message
+	OSPOVERRUN		///<data were requested after the end of the payload
+};
+
 /**OSPMessage class provides resources to perform data acquisition from OSP message payload.
  * Note that a payload is a part of the OSP message described in the SiRF ICD
  * The class provides support to allow a buffered acquisition process from the OSP file.
+ * The payload can be stored in the object buffer, or can be a view (pointer and length) of a payload
+ * stored elsewhere, like a memory mapped OSP file (see OSPMappedSource), avoiding copy of payload bytes.
  * Methods are defined to:
- * - fill the buffer with a OSP message read from OSP binary file
+ * - fill the buffer with a OSP message read from OSP binary file, or set the view to a payload
  * - get the value of the specific types the message could contain (byte, integer (short or not,
  *		unsigned or not), float or double. Bit and byte ordering in the source are taken into account.
  * - skip unsuccessful data from the buffer
+ * - validate the payload length against the one expected for the message, to extract data without further checks
+ *		(see OSPLayouts.h)
+ *<p>
+ * Extraction methods do not throw exceptions: when data are requested after the end of payload, they return 0
+ * and the message status is set to OSPOVERRUN. The status is reset when a new payload is set.
  */
 class OSPMessage {
-	unsigned char payload[MAXPAYLOADSIZE];	//buffer for the OSP message payload
+	unsigned char buffer[MAXPAYLOADSIZE];	//buffer for the OSP message payload read from a file
+	const unsigned char* payload;	//the current payload: points to buffer or to a payload view
 	unsigned int payloadLength;		//the payload length in bytes of current message
 	unsigned int cursor;	//payload index to the first byte to be extracted by any method defined below
 							//it is incremented after any extraction
+	OSPStatus status;		//the status of data extraction from the current payload
 public:
 	OSPMessage(void);
+	OSPMessage(const OSPMessage&);
 	~OSPMessage(void);
+	OSPMessage& operator=(const OSPMessage&);
 	bool fill(FILE*);	//fill the buffer whith a OSP message read from OSP binary file
+	bool fill(FILE*, const bool*);	//fill the buffer with the next OSP message having a wanted MID, skipping other ones
+	void setView(const unsigned char*, unsigned int);	//set the payload as a view of bytes stored elsewhere
+	void restart();		//set the cursor at the first payload byte to allow a new extraction of message data
 	int get();			//get from payload the byte value at cursor. Increment it by one
 	int getInt();		//get from payload the 32 bits integer at cursor. Increment it by four
 	unsigned int getUInt(); //get from payload the 32 bits unsigned integer at cursor. Increment it by four
@@ -49,4 +71,7 @@ public:
 	double getDouble();	//get from payload the 64 bits floating point at cursor. Increment it by eigth
 	bool skipBytes(int n);	//skip n bytes advancing cursor by n
 	unsigned int payloadLen(); //provides the payload length
+	const unsigned char* payloadData();	//provides the pointer to the first payload byte
+	OSPStatus validate(unsigned int);	//check the payload length against the expected one
+	OSPStatus getStatus();	//provides the status of data extraction from the current payload
 };
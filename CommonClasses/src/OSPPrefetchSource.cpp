@@ -0,0 +1,77 @@
+/** @file OSPPrefetchSource.cpp
+ * Contains the implementation of the OSPPrefetchSource class.
+ */
+
+#include "OSPPrefetchSource.h"
+#include "FileOffset.h"
+
+/**Constructs an OSPPrefetchSource object to read messages from the given file.
+ * The reader thread is started to read data from the beginning of the file.
+ *
+ * @param f the pointer to the already open binary FILE with plain OSP data, positioned at its beginning
+ * @param size the size in bytes of each block (0 for the default PFBLOCKSIZE). It is rounded up to a multiple of PFALIGN
+ * @param n the number of blocks (0 for the default PFBLOCKS). At least two blocks are used
+ */
+OSPPrefetchSource::OSPPrefetchSource(FILE* f, unsigned int size, unsigned int n) {
+	file = f;
+	seekable = OSPFileSource(file).canSeek();
+	if (size == 0) size = PFBLOCKSIZE;
+	if (size < MAXPAYLOADSIZE + 2) size = MAXPAYLOADSIZE + 2;
+	if (n == 0) n = PFBLOCKS;
+	if (n < 2) n = 2;
+	setBlocks((size + PFALIGN - 1) / PFALIGN * PFALIGN, n, PFALIGN);
+	start(0);
+}
+
+/**Destructs an OSPPrefetchSource object, stopping the reader thread. The file is not closed.
+ */
+OSPPrefetchSource::~OSPPrefetchSource(void) {
+	stop();
+}
+
+/**readBlock reads data from the file into the given block. It is called from the reader thread.
+ *
+ * @param block the block to fill
+ * @param size the size in bytes of the block
+ * @param last set to true when the end of file has been reached or an error happened
+ * @param error set to true when an error happened reading the file
+ * @return the number of bytes read
+ */
+unsigned int OSPPrefetchSource::readBlock(unsigned char* block, unsigned int size, bool& last, bool& error) {
+	unsigned int length = (unsigned int) fread(block, 1, size, file);
+	if (length < size) {
+		last = true;
+		error = ferror(file) != 0;
+	}
+	return length;
+}
+
+/**rewind restarts reading from the beginning of the file.
+ *
+ * @return true if the file could be positioned at its beginning, false otherwise (f.e. a pipe)
+ */
+bool OSPPrefetchSource::rewind() {
+	return seek(0);
+}
+
+/**seek sets the position of the next message to be provided, restarting the reader thread from it.
+ *
+ * @param pos the byte offset from the beginning of the file
+ * @return true if the position could be set, false otherwise (f.e. a pipe, where only the current position can be set)
+ */
+bool OSPPrefetchSource::seek(long long pos) {
+	if (pos == tell()) return true;
+	if (!seekable) return false;
+	stop();
+	bool ok = FSEEK64(file, pos, SEEK_SET) == 0;
+	start(pos);
+	return ok;
+}
+
+/**canSeek tells if the file allows setting positions in it.
+ *
+ * @return true if the file is a disk file allowing positioning, false otherwise
+ */
+bool OSPPrefetchSource::canSeek() {
+	return seekable;
+}
@@ -0,0 +1,59 @@
+/** @file OSPPrefetchSource.h
+ * Contains the definition of the OSPPrefetchSource class, used to read OSP messages from a FILE prefetching
+ * its data in a reader thread.
+ *
+ *Copyright 2015 Francisco Cancillo
+ *<p>
+ *This file is part of the RXtoRINEX tool.
+ *<p>
+ *RXtoRINEX is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *RXtoRINEX is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ *warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *See the GNU General Public License for more details.
+ *<p>
+ *A copy of the GNU General Public License can be found at <http://www.gnu.org/licenses/>.
+ *
+ *V1.0	First release
+ */
+#pragma once
+
+#include <stdio.h>
+
+//from CommonClasses
+#include "OSPBlockSource.h"
+
+using namespace std;
+
+///The alignment in bytes of prefetch blocks, in memory and in their size
+#define PFALIGN 4096
+///The default size in bytes of each prefetch block
+#define PFBLOCKSIZE 1048576
+///The default number of prefetch blocks
+#define PFBLOCKS 4
+
+/**OSPPrefetchSource class provides OSP messages from a plain OSP binary FILE, like OSPFileSource, but reading data
+ * in large blocks by a reader thread (see OSPBlockSource). While messages are provided from a block already read,
+ * the reader thread reads next blocks in advance. Thus, the latency of slow media (network or removable storage)
+ * overlaps with message processing.
+ *<p>
+ * The size of blocks (rounded up to a multiple of PFALIGN bytes) and their number can be stated. At least two blocks
+ * are used, one being read while the other is used.
+ *<p>
+ * Positions in the source are offsets from the beginning of the FILE. They can be set only when the FILE allows it.
+ * Setting a position restarts the reader thread from it.
+ */
+class OSPPrefetchSource : public OSPBlockSource {
+	FILE* file;						//the plain OSP file
+	bool seekable;					//true if the file allows setting positions
+
+protected:
+	unsigned int readBlock(unsigned char*, unsigned int, bool&, bool&);
+
+public:
+	OSPPrefetchSource(FILE*, unsigned int, unsigned int);
+	~OSPPrefetchSource(void);
+	bool rewind();
+	bool seek(long long);
+	bool canSeek();
+};
@@ -0,0 +1,339 @@
+/** @file OSPSource.cpp
+ * Contains the implementation of the OSPSource classes.
+ */
+
+#include "OSPSource.h"
+#include "OSPContainer.h"
+#include "FileOffset.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**Constructs OSPSource objects, having all messages wanted.
+ */
+OSPSource::OSPSource(void) {
+	allWanted = true;
+	for (int i=0; i<256; i++) wanted[i] = true;
+}
+
+/**Destructs OSPSource objects.
+ */
+OSPSource::~OSPSource(void) {
+}
+
+/**setWantedMIDs sets the MIDs of the messages to be provided by fill. Messages with other MIDs are skipped.
+ *
+ * @param mids the list of wanted MIDs. If it is empty, all messages are wanted
+ */
+void OSPSource::setWantedMIDs(const vector<int>& mids) {
+	allWanted = mids.empty();
+	for (int i=0; i<256; i++) wanted[i] = allWanted;
+	for (unsigned int i=0; i<mids.size(); i++)
+		if (mids[i] >= 0 && mids[i] < 256) wanted[mids[i]] = true;
+}
+
+/**isWantedMID tells if messages with the given MID are provided by fill.
+ *
+ * @param mid the MID, or -1 for messages without payload
+ * @return true if all messages are wanted, the message has no payload, or the MID is wanted; false otherwise
+ */
+bool OSPSource::isWantedMID(int mid) {
+	return allWanted || mid < 0 || (mid < 256 && wanted[mid]);
+}
+
+/**isWanted tells if a message with the given payload shall be provided.
+ *
+ * @param payload the pointer to the message payload
+ * @param length the payload length
+ * @return true if all messages are wanted, the payload is empty, or its MID is wanted; false otherwise
+ */
+bool OSPSource::isWanted(const unsigned char* payload, unsigned int length) {
+	return allWanted || length == 0 || wanted[payload[0]];
+}
+
+/**Constructs an OSPFileSource object to read messages from the given file.
+ *
+ * @param f the pointer to the already open binary OSP FILE
+ */
+OSPFileSource::OSPFileSource(FILE* f) {
+	file = f;
+}
+
+/**Destructs an OSPFileSource object. The file is not closed.
+ */
+OSPFileSource::~OSPFileSource(void) {
+}
+
+/**fill fills the message with the next one read from the file.
+ * When not all messages are wanted, payloads of messages skipped are not copied.
+ *
+ * @param msg the OSPMessage where payload data will be copied
+ * @return true when a message was correctly read, false otherwise (read error or end of file found)
+ */
+bool OSPFileSource::fill(OSPMessage& msg) {
+	if (allWanted) return msg.fill(file);
+	return msg.fill(file, wanted);
+}
+
+/**rewind sets the file position at its beginning.
+ *
+ * @return true if the position could be set, false otherwise
+ */
+bool OSPFileSource::rewind() {
+	return FSEEK64(file, 0, SEEK_SET) == 0;
+}
+
+/**tell gets the current position in the file.
+ *
+ * @return the byte offset from the beginning of the file, or -1 if it cannot be obtained
+ */
+long long OSPFileSource::tell() {
+	return FTELL64(file);
+}
+
+/**seek sets the current position in the file.
+ *
+ * @param pos the byte offset from the beginning of the file
+ * @return true if the position could be set, false otherwise
+ */
+bool OSPFileSource::seek(long long pos) {
+	return FSEEK64(file, pos, SEEK_SET) == 0;
+}
+
+/**canSeek tells if the file allows setting positions in it.
+ * Standard input, pipes and other character or FIFO devices do not allow it.
+ *
+ * @return true if the file is a disk file allowing positioning, false otherwise
+ */
+bool OSPFileSource::canSeek() {
+#ifdef _WIN32
+	return GetFileType((HANDLE) _get_osfhandle(_fileno(file))) == FILE_TYPE_DISK;
+#else
+	return FSEEK64(file, 0, SEEK_CUR) == 0;
+#endif
+}
+
+/**Constructs an OSPMemorySource object without any data.
+ */
+OSPMemorySource::OSPMemorySource(void) {
+	data = NULL;
+	size = 0;
+	position = 0;
+}
+
+/**Constructs an OSPMemorySource object to provide messages from the given block of OSP data.
+ *
+ * @param p the pointer to the first byte of the block
+ * @param blockSize the size in bytes of the block
+ */
+OSPMemorySource::OSPMemorySource(const unsigned char* p, long long blockSize) {
+	data = p;
+	size = blockSize;
+	position = 0;
+}
+
+/**Destructs an OSPMemorySource object. The block is not freed.
+ */
+OSPMemorySource::~OSPMemorySource(void) {
+}
+
+/**fill sets the message as a view of the next message payload in the block.
+ * For a message to be provided, its payload length shall be less than the maximum payload size
+ * (as defined in the OSP ICD) and all its payload bytes shall be in the block.
+ *
+ * @param msg the OSPMessage to be set
+ * @return true when a message was correctly provided, false otherwise (wrong length or end of block found)
+ */
+bool OSPMemorySource::fill(OSPMessage& msg) {
+	unsigned int payloadLength;
+	do {
+		if (position + 2 > size) return false;
+		payloadLength = (data[position] << 8) | data[position+1];	//numbers in msg are big endians
+		if (payloadLength > MAXPAYLOADSIZE || position + 2 + payloadLength > size) return false;
+		position += 2 + payloadLength;
+	} while (!isWanted(data + position - payloadLength, payloadLength));
+	msg.setView(data + position - payloadLength, payloadLength);
+	return true;
+}
+
+/**rewind sets the position for the next message at the beginning of the block.
+ *
+ * @return true
+ */
+bool OSPMemorySource::rewind() {
+	position = 0;
+	return true;
+}
+
+/**tell gets the position of the next message to be provided.
+ *
+ * @return the byte offset from the beginning of the block
+ */
+long long OSPMemorySource::tell() {
+	return position;
+}
+
+/**seek sets the position of the next message to be provided.
+ *
+ * @param pos the byte offset from the beginning of the block
+ * @return true if the position is inside the block, false otherwise
+ */
+bool OSPMemorySource::seek(long long pos) {
+	if (pos < 0 || pos > size) return false;
+	position = pos;
+	return true;
+}
+
+/**canSeek tells if positions can be set in the source. Memory blocks always allow it.
+ *
+ * @return true
+ */
+bool OSPMemorySource::canSeek() {
+	return true;
+}
+
+/**Constructs an OSPMappedSource object without any file mapped.
+ */
+OSPMappedSource::OSPMappedSource(void) {
+	opened = false;
+	fileHandle = NULL;
+	mapHandle = NULL;
+}
+
+/**Destructs an OSPMappedSource object, closing the mapped file if open.
+ */
+OSPMappedSource::~OSPMappedSource(void) {
+	close();
+}
+
+/**open maps into memory the whole content of the given file for reading.
+ * Position for the next message is set at the beginning of file.
+ *
+ * @param fileName the name of the binary OSP file
+ * @return true if file has been mapped, false otherwise (it does not exist, it is not a regular file, ...)
+ */
+bool OSPMappedSource::open(string fileName) {
+	close();
+#ifdef _WIN32
+	HANDLE hFile = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+							FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER fSize;
+	if (GetFileType(hFile) != FILE_TYPE_DISK || !GetFileSizeEx(hFile, &fSize)) {
+		CloseHandle(hFile);
+		return false;
+	}
+	fileHandle = hFile;
+	size = fSize.QuadPart;
+	if (size == 0) {		//nothing to map
+		opened = true;
+		return true;
+	}
+	HANDLE hMap = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (hMap == NULL) {
+		close();
+		return false;
+	}
+	mapHandle = hMap;
+	data = (const unsigned char*) MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+	if (data == NULL) {
+		close();
+		return false;
+	}
+#else
+	int fd = ::open(fileName.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+		::close(fd);
+		return false;
+	}
+	size = st.st_size;
+	if (size > 0) {
+		void* p = mmap(NULL, (size_t) size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p == MAP_FAILED) {
+			::close(fd);
+			size = 0;
+			return false;
+		}
+		madvise(p, (size_t) size, MADV_SEQUENTIAL);
+		data = (const unsigned char*) p;
+	}
+	::close(fd);	//the mapping remains valid after closing the descriptor
+#endif
+	position = 0;
+	opened = true;
+	return true;
+}
+
+/**close unmaps the file. Messages previously provided are no longer valid.
+ */
+void OSPMappedSource::close() {
+#ifdef _WIN32
+	if (data != NULL) UnmapViewOfFile(data);
+	if (mapHandle != NULL) CloseHandle((HANDLE) mapHandle);
+	if (fileHandle != NULL) CloseHandle((HANDLE) fileHandle);
+#else
+	if (data != NULL) munmap((void*) data, (size_t) size);
+#endif
+	data = NULL;
+	size = 0;
+	position = 0;
+	opened = false;
+	fileHandle = NULL;
+	mapHandle = NULL;
+}
+
+/**rewind sets the position for the next message at the beginning of the file.
+ *
+ * @return true if the file is mapped, false otherwise
+ */
+bool OSPMappedSource::rewind() {
+	position = 0;
+	return opened;
+}
+
+/**fileSize gets the size of the mapped file.
+ *
+ * @return the file size in bytes
+ */
+long long OSPMappedSource::fileSize() {
+	return size;
+}
+
+/**fileData gets the pointer to the first byte of the mapped file, to access its contents directly.
+ * Data remain valid until the file is closed.
+ *
+ * @return the pointer to the mapped file contents, or NULL if no file is mapped
+ */
+const unsigned char* OSPMappedSource::fileData() {
+	return data;
+}
+
+/**isGzipped tells if the mapped file contains gzip compressed data, checking its first bytes.
+ * Compressed files shall be read using an OSPGzipSource.
+ *
+ * @return true if the file starts with the gzip identification bytes, false otherwise
+ */
+bool OSPMappedSource::isGzipped() {
+	return opened && size >= 2 && data[0] == 0x1F && data[1] == 0x8B;
+}
+
+/**isContainer tells if the mapped file contains data in the container format (v2), checking its first bytes.
+ * Container files shall be read using an OSPContainerSource.
+ *
+ * @return true if the file starts with the container identification bytes, false otherwise
+ */
+bool OSPMappedSource::isContainer() {
+	return opened && size >= 4 && memcmp(data, OSP2MAGIC, 4) == 0;
+}
@@ -0,0 +1,118 @@
+/** @file OSPSource.h
+ * Contains the definition of OSPSource classes used to read messages from OSP binary files.
+ * An OSPSource object provides OSP messages in the same sequence they are recorded in the source.
+ *
+ *Copyright 2015 Francisco Cancillo
+ *<p>
+ *This file is part of the RXtoRINEX tool.
+ *<p>
+ *RXtoRINEX is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *RXtoRINEX is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ *warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *See the GNU General Public License for more details.
+ *<p>
+ *A copy of the GNU General Public License can be found at <http://www.gnu.org/licenses/>.
+ *
+ *V1.0	First release
+ */
+#pragma once
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+//from CommonClasses
+#include "OSPMessage.h"
+
+using namespace std;
+
+/**OSPSource is the abstract class defining the methods to be provided by any source of OSP messages.
+ * Messages are provided one by one in the order they are stored in the source using the fill method.
+ * Positions in the source are byte offsets from its beginning, and can be used to seek a message already read.
+ *<p>
+ * A set of wanted MIDs can be given to the source. Then, fill provides only messages having a wanted MID (and
+ * messages without payload, to allow reporting them). Other messages are skipped, reading only their MID when possible.
+ */
+class OSPSource {
+protected:
+	bool allWanted;			//true when all messages are wanted
+	bool wanted[256];		//when not all messages are wanted, true for wanted MIDs
+
+	bool isWanted(const unsigned char*, unsigned int);
+
+public:
+	OSPSource(void);
+	virtual ~OSPSource(void);
+	void setWantedMIDs(const vector<int>&);	//set the MIDs of messages to be provided (all if empty)
+	bool isWantedMID(int);				//tell if messages with the given MID are provided
+	virtual bool fill(OSPMessage&) = 0;	//fill the message with the next one in the source
+	virtual bool rewind() = 0;			//set the source position at the first message
+	virtual long long tell() = 0;		//get the current position in the source
+	virtual bool seek(long long) = 0;	//set the current position in the source
+	virtual bool canSeek() = 0;			//tell if positions in the source can be set (it can be rewound)
+};
+
+/**OSPFileSource class provides OSP messages read from an already open binary FILE.
+ * Payload bytes of each message read are copied into the OSPMessage buffer.
+ * The FILE can be a stream not allowing positioning, like the standard input or a pipe. In this case messages
+ * can only be read sequentially, once.
+ */
+class OSPFileSource : public OSPSource {
+	FILE* file;		//the binary OSP file
+public:
+	OSPFileSource(FILE*);
+	~OSPFileSource(void);
+	bool fill(OSPMessage&);
+	bool rewind();
+	long long tell();
+	bool seek(long long);
+	bool canSeek();
+};
+
+/**OSPMemorySource class provides OSP messages from a block of OSP binary data already in memory, like a part of
+ * a mapped file. Messages provided are views of the payload in the block: payload bytes are not copied.
+ * The block is not owned by the source: it shall remain valid while messages are used.
+ */
+class OSPMemorySource : public OSPSource {
+protected:
+	const unsigned char* data;	//the first byte of the block
+	long long size;				//the block size in bytes
+	long long position;			//the offset in data of the next message to be provided
+public:
+	OSPMemorySource(void);
+	OSPMemorySource(const unsigned char*, long long);
+	~OSPMemorySource(void);
+	bool fill(OSPMessage&);
+	bool rewind();
+	long long tell();
+	bool seek(long long);
+	bool canSeek();
+};
+
+/**OSPMappedSource class provides OSP messages from a binary OSP file mapped into memory.
+ * Messages provided are views of the payload in the mapped file: payload bytes are not copied.
+ * As messages provided are views of the file contents, they remain valid until the file is closed.
+ *<p>
+ * A program using OSPMappedSource would perform the following steps:
+ *	-# Declare the OSPMappedSource object
+ *	-# Open the OSP file using the open method. If it cannot be mapped (f.e. it is not a regular file),
+ *		an OSPFileSource could be used instead. Compressed or container files (see isGzipped and isContainer)
+ *		shall be read using the stream source given by newOSPStreamSource
+ *	-# Get messages using the fill method until it returns false
+ */
+class OSPMappedSource : public OSPMemorySource {
+	bool opened;				//true when a file has been mapped
+	void* fileHandle;			//system handles of the file and mapping (Windows only)
+	void* mapHandle;
+public:
+	OSPMappedSource(void);
+	~OSPMappedSource(void);
+	bool open(string);
+	void close();
+	bool rewind();
+	long long fileSize();
+	const unsigned char* fileData();
+	bool isGzipped();
+	bool isContainer();
+};
@@ -0,0 +1,303 @@
+/** @file OSPValidator.cpp
+ * Contains the implementation of the OSPValidator class.
+ */
+
+#include "OSPValidator.h"
+
+#include <thread>
+#include <functional>
+
+//from CommonClasses
+#include "OSPMessage.h"
+#include "OSPLayouts.h"
+
+//@cond DUMMY
+//the minimum size of the chunks to be scanned in parallel
+#define MINCHUNKSIZE 1048576
+//the number of offsets of first messages in a chunk saved to stitch it with the previous one
+#define MAXFIRSTOFFSETS 4096
+//the size of the data interval where bisection finishes and messages are followed sequentially
+#define MINBISECTSIZE 65536
+
+//expectedLength gives the payload length of messages with the given MID, or 0 if it is not a fixed known one
+static unsigned int expectedLength(int mid) {
+	switch (mid) {
+	case MID2Layout::MID: return MID2Layout::LENGTH;
+	case MID7Layout::MID: return MID7Layout::LENGTH;
+	case MID8Layout::MID: return MID8Layout::LENGTH;
+	case MID15Layout::MID: return MID15Layout::LENGTH;
+	case MID19Layout::MID: return MID19Layout::LENGTH;
+	case MID28Layout::MID: return MID28Layout::LENGTH;
+	default: return 0;
+	}
+}
+//@endcond
+
+/**Constructs an empty OSPValidator object.
+ */
+OSPValidator::OSPValidator(void) {
+	data = NULL;
+	size = 0;
+	nMessages = 0;
+}
+
+/**Destructs OSPValidator objects.
+ */
+OSPValidator::~OSPValidator(void) {
+}
+
+/**isPlausible checks if the data at the given offset can be a message: its payload length is in the range 1 to the
+ * maximum, all payload bytes are in data, the MID is not zero, and for MIDs with known length it is the expected one.
+ *
+ * @param offset the offset in data of the message to check (its payload length bytes)
+ * @return true if the message is plausible, false otherwise
+ */
+bool OSPValidator::isPlausible(long long offset) {
+	if (offset + 2 > size) return false;
+	unsigned int payloadLength = (data[offset] << 8) | data[offset+1];
+	if (payloadLength == 0 || payloadLength > MAXPAYLOADSIZE || offset + 2 + payloadLength > size) return false;
+	int mid = data[offset+2];
+	if (mid == 0) return false;
+	unsigned int expected = expectedLength(mid);
+	return expected == 0 || expected == payloadLength;
+}
+
+/**isSynchro checks if the data at the given offset can be used to resynchronize: it is a plausible message having
+ * a known fixed length, and it is followed by another plausible message or by the end of data.
+ *
+ * @param offset the offset in data to check
+ * @return true if data can be resynchronized at offset, false otherwise
+ */
+bool OSPValidator::isSynchro(long long offset) {
+	if (!isPlausible(offset) || expectedLength(data[offset+2]) == 0) return false;
+	long long next = offset + 2 + ((data[offset] << 8) | data[offset+1]);
+	return next == size || isPlausible(next);
+}
+
+/**findSynchro finds the first synchronization point at or after the given offset.
+ *
+ * @param from the offset in data where search starts
+ * @return the offset of the synchronization point found, or the data size if none exists
+ */
+long long OSPValidator::findSynchro(long long from) {
+	for (long long offset = from; offset + 2 <= size; offset++)
+		if (isSynchro(offset)) return offset;
+	return size;
+}
+
+/**step advances from the message at the given offset to the next one.
+ * If data at offset are not a plausible message, a damaged area is recorded from offset to the next
+ * synchronization point.
+ *
+ * @param offset the offset in data of the message
+ * @param found the vector where the damaged area, if any, is appended
+ * @param count the counter of plausible messages, incremented if the message is plausible
+ * @return the offset of the next message, or the data size if there are no more
+ */
+long long OSPValidator::step(long long offset, vector<OSPDamage>& found, unsigned int& count) {
+	if (isPlausible(offset)) {
+		count++;
+		return offset + 2 + ((data[offset] << 8) | data[offset+1]);
+	}
+	OSPDamage damage;
+	damage.offset = offset;
+	unsigned int payloadLength = offset + 2 <= size? (data[offset] << 8) | data[offset+1]: 0;
+	if (offset + 2 > size) damage.type = OSPTRUNCATED;
+	else if (payloadLength == 0 || payloadLength > MAXPAYLOADSIZE) damage.type = OSPDAMAGEDLENGTH;
+	else if (offset + 2 + payloadLength > size) damage.type = OSPTRUNCATED;
+	else damage.type = OSPDAMAGEDMID;
+	long long next = findSynchro(offset + 1);
+	damage.length = next - offset;
+	found.push_back(damage);
+	return next;
+}
+
+/**scanChunk scans the messages in a chunk of data. Scanning starts at the given offset if it is the beginning of data,
+ * or at the first synchronization point after it otherwise, and finishes at the first message starting at or after
+ * the chunk end.
+ *
+ * @param chunk the ChunkScan where results are set
+ * @param from the offset in data of the chunk start
+ * @param to the offset in data of the chunk end
+ */
+void OSPValidator::scanChunk(ChunkScan& chunk, long long from, long long to) {
+	chunk.nMessages = 0;
+	chunk.begin = from == 0? 0: findSynchro(from);
+	long long offset = chunk.begin;
+	while (offset < to && offset < size) {
+		if (chunk.firstOffsets.size() < MAXFIRSTOFFSETS) chunk.firstOffsets.push_back(offset);
+		offset = step(offset, chunk.damages, chunk.nMessages);
+	}
+	chunk.end = offset;
+}
+
+/**scan scans the given data detecting damaged areas.
+ * Data are split into chunks scanned in parallel using the given number of threads.
+ * The results are the same as the ones obtained scanning data sequentially from its beginning.
+ *
+ * @param p the pointer to the first byte of the data to scan
+ * @param dataSize the size in bytes of data
+ * @param nThreads the number of threads to use (0 to use as many as hardware threads)
+ */
+void OSPValidator::scan(const unsigned char* p, long long dataSize, unsigned int nThreads) {
+	data = p;
+	size = dataSize;
+	damages.clear();
+	nMessages = 0;
+	if (nThreads == 0) nThreads = thread::hardware_concurrency();
+	if (nThreads == 0) nThreads = 1;
+	long long nChunks = (size + MINCHUNKSIZE - 1) / MINCHUNKSIZE;
+	if (nChunks > nThreads) nChunks = nThreads;
+	if (nChunks < 1) nChunks = 1;
+	//scan chunks in parallel
+	vector<ChunkScan> chunks((unsigned int) nChunks);
+	vector<long long> limits((unsigned int) nChunks + 1);
+	for (unsigned int i=0; i<=nChunks; i++) limits[i] = size * i / nChunks;
+	vector<thread> workers;
+	for (unsigned int i=1; i<nChunks; i++)
+		workers.push_back(thread(&OSPValidator::scanChunk, this, ref(chunks[i]), limits[i], limits[i+1]));
+	scanChunk(chunks[0], limits[0], limits[1]);
+	for (unsigned int i=0; i<workers.size(); i++) workers[i].join();
+	//stitch results: follow the sequence of messages from the end of the previous chunk until it joins the current one
+	damages = chunks[0].damages;
+	nMessages = chunks[0].nMessages;
+	long long offset = chunks[0].end;
+	for (unsigned int i=1; i<nChunks; i++) {
+		ChunkScan& chunk = chunks[i];
+		unsigned int j = 0;
+		bool joined = false;
+		while (offset < limits[i+1] && offset < size && !joined) {
+			while (j < chunk.firstOffsets.size() && chunk.firstOffsets[j] < offset) j++;
+			if (j < chunk.firstOffsets.size() && chunk.firstOffsets[j] == offset) joined = true;
+			else if (j == chunk.firstOffsets.size() && chunk.firstOffsets.size() == MAXFIRSTOFFSETS) {
+				//sequences did not join in the saved offsets: scan the rest of the chunk sequentially
+				while (offset < limits[i+1] && offset < size) offset = step(offset, damages, nMessages);
+			} else offset = step(offset, damages, nMessages);
+		}
+		if (!joined) continue;
+		//use chunk results from the joining point: steps before it are either messages or damages
+		unsigned int damagesBefore = 0;
+		for (unsigned int k=0; k<chunk.damages.size(); k++) {
+			if (chunk.damages[k].offset < offset) damagesBefore++;
+			else damages.push_back(chunk.damages[k]);
+		}
+		nMessages += chunk.nMessages - (j - damagesBefore);
+		offset = chunk.end;
+	}
+}
+
+/**getDamages gets the damaged areas found in the last scan, in offset order.
+ *
+ * @return the vector of damaged areas
+ */
+const vector<OSPDamage>& OSPValidator::getDamages() {
+	return damages;
+}
+
+/**damagedBytes gets the total number of bytes in damaged areas found in the last scan.
+ *
+ * @return the number of damaged bytes
+ */
+long long OSPValidator::damagedBytes() {
+	long long n = 0;
+	for (unsigned int i=0; i<damages.size(); i++) n += damages[i].length;
+	return n;
+}
+
+/**messages gets the number of plausible messages found in the last scan.
+ *
+ * @return the number of messages
+ */
+unsigned int OSPValidator::messages() {
+	return nMessages;
+}
+
+/**writeRepaired writes to the given file the data scanned, excluding the damaged areas found.
+ *
+ * @param outFile the already open binary FILE where repaired data are written
+ * @return true if all data were written, false otherwise
+ */
+bool OSPValidator::writeRepaired(FILE* outFile) {
+	long long offset = 0;
+	for (unsigned int i=0; i<=damages.size(); i++) {
+		long long end = i < damages.size()? damages[i].offset: size;
+		size_t n = (size_t) (end - offset);
+		if (n > 0 && fwrite(data + offset, 1, n, outFile) != n) return false;
+		if (i < damages.size()) offset = damages[i].offset + damages[i].length;
+	}
+	return true;
+}
+
+/**nextEpochTime follows the messages from the given offset until a MID7 message is found, resynchronizing after
+ * damaged areas, and gets the epoch time it contains.
+ *
+ * @param offset the offset in data where search starts. It shall be a message or synchronization point
+ * @param end the offset of the message after the MID7 found (the first message of the next epoch)
+ * @return the GPS time in the MID7 found (TOW scaled by 100, including weeks), or -1 if none exists
+ */
+long long OSPValidator::nextEpochTime(long long offset, long long& end) {
+	OSPMessage message;
+	MID7Layout mid7;
+	while (offset < size) {
+		if (!isPlausible(offset)) {
+			offset = findSynchro(offset + 1);
+			continue;
+		}
+		unsigned int payloadLength = (data[offset] << 8) | data[offset+1];
+		end = offset + 2 + payloadLength;
+		if (data[offset+2] == MID7Layout::MID) {
+			message.setView(data + offset + 2, payloadLength);
+			if (mid7.decode(message) == OSPOK) return mid7.week * OSPWEEKTOW + mid7.tow;
+		}
+		offset = end;
+	}
+	return -1;
+}
+
+/**findEpoch finds, bisecting the given data, the first message of the first epoch having a time equal or after
+ * the given one. Epochs are sequences of messages ended by a MID7 message, which gives the epoch time.
+ * Data are probed at arbitrary offsets, resynchronizing on the next plausible message as done to skip damaged areas.
+ * It assumes that epochs are recorded in data in increasing time.
+ *
+ * @param p the pointer to the first byte of OSP data
+ * @param dataSize the size in bytes of data
+ * @param week the GPS week
+ * @param tow the GPS TOW (scaled by 100)
+ * @return the offset of the message found, or the data size if all epochs are before the given time
+ */
+long long OSPValidator::findEpoch(const unsigned char* p, long long dataSize, int week, unsigned int tow) {
+	data = p;
+	size = dataSize;
+	damages.clear();
+	nMessages = 0;
+	long long time = week * OSPWEEKTOW + tow;
+	long long epochEnd;
+	long long epochTime;
+	//bisect keeping the first MID7 after first before the given time
+	long long first = 0;
+	long long last = size;
+	while (last - first > MINBISECTSIZE) {
+		long long middle = first + (last - first) / 2;
+		epochTime = nextEpochTime(findSynchro(middle), epochEnd);
+		if (epochTime >= 0 && epochTime < time) first = middle;
+		else last = middle;
+	}
+	//follow epochs until the wanted one
+	long long offset = first == 0? 0: findSynchro(first);
+	while ((epochTime = nextEpochTime(offset, epochEnd)) >= 0 && epochTime < time) offset = epochEnd;
+	return epochTime < 0? size: offset;
+}
+
+/**damageName gets the text describing the given damage type.
+ *
+ * @param type the damage type
+ * @return the description of the damage type
+ */
+string OSPValidator::damageName(OSPDamageType type) {
+	switch (type) {
+	case OSPDAMAGEDLENGTH: return "Wrong payload length";
+	case OSPDAMAGEDMID: return "Wrong MID or length for MID";
+	case OSPTRUNCATED: return "Truncated message";
+	default: return "Unknown";
+	}
+}
@@ -0,0 +1,95 @@
+/** @file OSPValidator.h
+ * Contains the OSPValidator class definition.
+ * An OSPValidator object scans the content of an OSP binary file to detect damaged data, and allows writing
+ * a repaired file without them.
+ *
+ *Copyright 2015 Francisco Cancillo
+ *<p>
+ *This file is part of the RXtoRINEX tool.
+ *<p>
+ *RXtoRINEX is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *RXtoRINEX is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ *warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *See the GNU General Public License for more details.
+ *<p>
+ *A copy of the GNU General Public License can be found at <http://www.gnu.org/licenses/>.
+ *
+ *V1.0	First release
+ */
+#pragma once
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**OSPDamageType defines the kinds of damage detected in OSP data.
+ */
+enum OSPDamageType {
+	OSPDAMAGEDLENGTH = 0,	///<the payload length is zero or greater than the maximum
+	OSPDAMAGEDMID,			///<the MID is not valid, or its payload length is not the one expected for it
+	OSPTRUNCATED			///<the message extends beyond the end of data
+};
+
+/**OSPDamage contains data of a damaged area: a sequence of bytes not belonging to any plausible message.
+ */
+struct OSPDamage {
+	long long offset;		///<byte offset from the beginning of data of the first byte damaged
+	long long length;		///<number of bytes damaged (skipped until the next plausible message)
+	OSPDamageType type;		///<the kind of damage found at offset
+};
+
+/**OSPValidator class scans OSP binary data (a sequence of payload length and payload pairs) to detect damaged areas,
+ * where data do not contain plausible messages, and resynchronizes on the next plausible message.
+ *<p>
+ * A message is plausible when its payload length is not greater than the maximum, it fits in data, its MID is not zero,
+ * and, for messages having a known fixed payload length (MIDs 2, 7, 8, 15, 19 and 28), the length is the expected one.
+ * After a damaged area, data are resynchronized on the next message having a known fixed length and followed by a
+ * plausible message (or by the end of data).
+ *<p>
+ * To scan large files at disk speed, data can be split into chunks scanned in parallel by several threads. Scanning
+ * of each chunk starts at the first synchronization point found in it, and results are stitched following the
+ * sequence of messages from the previous chunk until it joins the sequence of the current one. Thus, results are
+ * the same as the ones obtained with a sequential scan.
+ *<p>
+ * The same resynchronization allows finding the epoch at a given time bisecting data (see findEpoch), without an index.
+ *<p>
+ * A program using OSPValidator would perform the following steps:
+ *	-# Map the OSP file into memory (see OSPMappedSource)
+ *	-# Declare the OSPValidator object and call scan with the data and the number of threads to use
+ *	-# Get the damaged areas found (see getDamages), and write the repaired file with writeRepaired
+ */
+class OSPValidator {
+	//results of the scan of a chunk
+	struct ChunkScan {
+		long long begin;			//offset of the first message (synchronization point) in the chunk
+		long long end;				//offset where the scan finished (the first message after the chunk end)
+		vector<long long> firstOffsets;	//offsets of the first messages scanned, to stitch with the previous chunk
+		vector<OSPDamage> damages;	//the damaged areas found
+		unsigned int nMessages;		//number of plausible messages found
+	};
+	const unsigned char* data;		//the data to scan
+	long long size;					//the size of data in bytes
+	vector<OSPDamage> damages;		//the damaged areas found, in offset order
+	unsigned int nMessages;			//number of plausible messages found
+
+	bool isPlausible(long long);
+	bool isSynchro(long long);
+	long long findSynchro(long long);
+	long long step(long long, vector<OSPDamage>&, unsigned int&);
+	void scanChunk(ChunkScan&, long long, long long);
+	long long nextEpochTime(long long, long long&);
+
+public:
+	OSPValidator(void);
+	~OSPValidator(void);
+	void scan(const unsigned char*, long long, unsigned int);
+	const vector<OSPDamage>& getDamages();
+	long long damagedBytes();
+	unsigned int messages();
+	bool writeRepaired(FILE*);
+	static string damageName(OSPDamageType);
+	long long findEpoch(const unsigned char*, long long, int, unsigned int);
+};
@@ -0,0 +1,232 @@
+/** @file OutputSink.cpp
+ * Contains the implementation of the OutputSink, FileSink and MemorySink classes.
+ */
+
+#include "OutputSink.h"
+#include "FileOffset.h"
+
+#include <string.h>
+#include <stdarg.h>
+
+#ifdef _WIN32
+#include <io.h>
+#define DATASYNC(fd) _commit(fd)
+#else
+#include <unistd.h>
+#ifdef __APPLE__
+#define DATASYNC(fd) fsync(fd)
+#else
+#define DATASYNC(fd) fdatasync(fd)
+#endif
+#endif
+
+/**Destructs an OutputSink object.
+ */
+OutputSink::~OutputSink(void) {
+}
+
+/**print writes text formatted as per printf.
+ *
+ * @param fmt the format to be used, as per printf
+ * @param ... the values to format
+ * @return true if the text was written, false otherwise
+ */
+bool OutputSink::print(const char* fmt, ...) {
+	char text[SINKPRINTSIZE];
+	va_list args;
+	va_start(args, fmt);
+	int n = vsnprintf(text, sizeof text, fmt, args);
+	va_end(args);
+	if (n < 0) return false;
+	if (n < (int) sizeof text) return write(text, n);
+	//the text does not fit in the internal buffer: format it again in a buffer large enough
+	vector<char> longText(n + 1);
+	va_start(args, fmt);
+	vsnprintf(&longText[0], longText.size(), fmt, args);
+	va_end(args);
+	return write(&longText[0], n);
+}
+
+/**Constructs a FileSink object to write to the given FILE, using a buffer of the default size and without syncs.
+ *
+ * @param f the FILE already open for writing
+ */
+FileSink::FileSink(FILE* f) {
+	file = f;
+	buffer.resize(SINKBLOCKSIZE);
+	used = 0;
+	syncBytes = unsynced = 0;
+	errors = false;
+}
+
+/**Constructs a FileSink object to write to the given FILE.
+ *
+ * @param f the FILE already open for writing
+ * @param size the size in bytes of the buffer (0 for the default SINKBLOCKSIZE)
+ * @param sync the number of bytes to write between syncs to disk (0 for no syncs)
+ */
+FileSink::FileSink(FILE* f, unsigned int size, unsigned long long sync) {
+	file = f;
+	buffer.resize(size > 0? size: SINKBLOCKSIZE);
+	used = 0;
+	syncBytes = sync;
+	unsynced = 0;
+	errors = false;
+}
+
+/**Destructs a FileSink object, flushing data not written yet. The FILE is not closed.
+ */
+FileSink::~FileSink(void) {
+	flush();
+}
+
+/**writeBuffer passes the data in the buffer to the FILE in a single write, and syncs them to disk when the
+ * amount of data stated for syncs has been written.
+ *
+ * @return true if data were written, false otherwise
+ */
+bool FileSink::writeBuffer() {
+	if (used == 0) return true;
+	if (fwrite(&buffer[0], 1, used, file) != used || fflush(file) != 0) errors = true;
+	unsynced += used;
+	used = 0;
+	if (syncBytes > 0 && unsynced >= syncBytes) {
+		if (DATASYNC(fileno(file)) != 0) errors = true;
+		unsynced = 0;
+	}
+	return !errors;
+}
+
+/**write writes the given bytes. They are kept in the buffer until it is full.
+ * Data larger than the buffer are written directly to the FILE.
+ *
+ * @param data the bytes to write
+ * @param n the number of bytes to write
+ * @return true if no errors have been found writing, false otherwise
+ */
+bool FileSink::write(const char* data, unsigned int n) {
+	if (used + n > buffer.size() && !writeBuffer()) return false;
+	if (n >= buffer.size()) {
+		if (fwrite(data, 1, n, file) != n || fflush(file) != 0) errors = true;
+		unsynced += n;
+		return !errors;
+	}
+	memcpy(&buffer[used], data, n);
+	used += n;
+	return !errors;
+}
+
+/**flush passes the data in the buffer to the FILE, and syncs them to disk if syncs were requested.
+ *
+ * @return true if no errors have been found writing, false otherwise
+ */
+bool FileSink::flush() {
+	writeBuffer();
+	if (syncBytes > 0 && unsynced > 0) {
+		if (DATASYNC(fileno(file)) != 0) errors = true;
+		unsynced = 0;
+	}
+	return !errors;
+}
+
+/**tell writes the data in the buffer and gets the current position in the FILE.
+ * Data are written before getting the position because in text mode FILEs the offset given by the C library
+ * may not be the number of bytes passed to it (f.e. line terminators in Windows).
+ *
+ * @return the offset from the beginning of the FILE, or -1 if it is not known (f.e. a pipe)
+ */
+long long FileSink::tell() {
+	writeBuffer();
+	return FTELL64(file);
+}
+
+/**seek writes the data in the buffer and sets the current position in the FILE.
+ *
+ * @param pos the byte offset from the beginning of the FILE
+ * @return true if the position could be set, false otherwise (f.e. a pipe)
+ */
+bool FileSink::seek(long long pos) {
+	return writeBuffer() && FSEEK64(file, pos, SEEK_SET) == 0;
+}
+
+/**hasErrors tells if errors were found writing to the FILE.
+ *
+ * @return true if errors were found, false otherwise
+ */
+bool FileSink::hasErrors() {
+	return errors;
+}
+
+/**Constructs an empty MemorySink object.
+ */
+MemorySink::MemorySink(void) {
+	position = 0;
+}
+
+/**Destructs a MemorySink object.
+ */
+MemorySink::~MemorySink(void) {
+}
+
+/**write writes the given bytes at the current position, replacing data already there or extending them.
+ *
+ * @param bytes the bytes to write
+ * @param n the number of bytes to write
+ * @return true
+ */
+bool MemorySink::write(const char* bytes, unsigned int n) {
+	if (position + n > data.size()) data.resize(position + n);
+	if (n > 0) memcpy(&data[position], bytes, n);
+	position += n;
+	return true;
+}
+
+/**flush does nothing, as data are already in memory.
+ *
+ * @return true
+ */
+bool MemorySink::flush() {
+	return true;
+}
+
+/**tell gets the current position.
+ *
+ * @return the byte offset from the beginning of data
+ */
+long long MemorySink::tell() {
+	return position;
+}
+
+/**seek sets the current position.
+ *
+ * @param pos the byte offset from the beginning of data
+ * @return true if the position is inside data, false otherwise
+ */
+bool MemorySink::seek(long long pos) {
+	if (pos < 0 || pos > (long long) data.size()) return false;
+	position = pos;
+	return true;
+}
+
+/**getData gets the data written.
+ *
+ * @return a pointer to the first byte of data, valid until new data are written
+ */
+const char* MemorySink::getData() {
+	return data.empty()? "": &data[0];
+}
+
+/**getSize gets the size of the data written.
+ *
+ * @return the size in bytes
+ */
+unsigned long long MemorySink::getSize() {
+	return data.size();
+}
+
+/**clear discards all data written.
+ */
+void MemorySink::clear() {
+	data.clear();
+	position = 0;
+}
@@ -0,0 +1,87 @@
+/** @file OutputSink.h
+ * Contains the definition of the OutputSink abstract class and the FileSink and MemorySink classes, used to write
+ * generated text files (RINEX, RTK) to files or memory.
+ *
+ *Copyright 2015 Francisco Cancillo
+ *<p>
+ *This file is part of the RXtoRINEX tool.
+ *<p>
+ *RXtoRINEX is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *RXtoRINEX is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ *warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *See the GNU General Public License for more details.
+ *<p>
+ *A copy of the GNU General Public License can be found at <http://www.gnu.org/licenses/>.
+ *
+ *V1.0	First release
+ */
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+
+using namespace std;
+
+///The default size in bytes of the FileSink buffer
+#define SINKBLOCKSIZE 65536
+///The maximum length of the text formatted by OutputSink::print using its internal buffer
+#define SINKPRINTSIZE 512
+
+/**OutputSink is the abstract class defining the methods to be provided by any destination of generated data.
+ * Data are written sequentially. Positions in the sink are byte offsets from its beginning, and can be used to
+ * write again data already written (f.e. to update a header).
+ */
+class OutputSink {
+public:
+	virtual ~OutputSink(void);
+	bool print(const char*, ...);					//write text formatted as per printf
+	virtual bool write(const char*, unsigned int) = 0;	//write the given bytes
+	virtual bool flush() = 0;				//pass data written to the final destination
+	virtual long long tell() = 0;			//get the current position in the sink
+	virtual bool seek(long long) = 0;		//set the current position in the sink
+};
+
+/**FileSink class writes data to an already open FILE (a disk file or the standard output).
+ * Data are accumulated in a buffer of the given size, and passed to the FILE in a single write when it is full.
+ * Optionally, data passed can be synced to the disk each time a given amount of data has been written.
+ * The FILE is not closed by the sink, but the sink shall be flushed (or destroyed) before closing it.
+ */
+class FileSink : public OutputSink {
+	FILE* file;					//the output file
+	vector<char> buffer;		//the data not passed yet to the file
+	unsigned int used;			//the number of bytes in the buffer
+	unsigned long long syncBytes;	//the bytes written between syncs to disk, 0 for no syncs
+	unsigned long long unsynced;	//the bytes passed to the file since the last sync
+	bool errors;				//true when errors happened writing to the file
+
+	bool writeBuffer();
+
+public:
+	FileSink(FILE*);
+	FileSink(FILE*, unsigned int, unsigned long long);
+	~FileSink(void);
+	bool write(const char*, unsigned int);
+	bool flush();
+	long long tell();
+	bool seek(long long);
+	bool hasErrors();
+};
+
+/**MemorySink class keeps data written in memory.
+ */
+class MemorySink : public OutputSink {
+	vector<char> data;			//the data written
+	unsigned long long position;	//the position in data of the next byte to write
+
+public:
+	MemorySink(void);
+	~MemorySink(void);
+	bool write(const char*, unsigned int);
+	bool flush();
+	long long tell();
+	bool seek(long long);
+	const char* getData();
+	unsigned long long getSize();
+	void clear();
+};
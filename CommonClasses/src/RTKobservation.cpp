@@ -12,6 +12,10 @@
  */
 RTKobservation::RTKobservation(Logger* plog) {
 		logger = plog;
+		startWeek = endWeek = 0;
+		startTOW = endTOW = 0.0;
+		headerBegin = -1;
+		headerSize = 0;
 }
 
 /**Destructs an RTKobservation object
@@ -85,41 +89,81 @@ void RTKobservation::setPosition(int week, double tow, double x, double y, doubl
 	nSol = nSat;
 }
 
-/**printHeader prints header data to the RTK file.
+/**formatHeader prints header data to the given OutputSink.
  *
- * @param out	the FILE were header will be printed
+ * @param out	the OutputSink where header will be printed
  */
-void RTKobservation::printHeader(FILE* out) {
+void RTKobservation::formatHeader(OutputSink* out) {
 	char buffer[80];
- 	fprintf(out, "%% program\t: %s\n", program.c_str());
-	fprintf(out, "%% inp file\t: %s\n", inpFile.c_str());
-	formatGPStime (buffer, sizeof buffer,"%Y/%m/%d %H:%M", startWeek, startTOW);
-	fprintf(out, "%% obs start\t: %s:%06.3f GPST\n", buffer, getGPSseconds(startTOW));
-	formatGPStime (buffer, sizeof buffer,"%Y/%m/%d %H:%M", endWeek, endTOW);
-	fprintf(out, "%% obs end\t: %s:%-06.3f GPST\n", buffer, getGPSseconds(endTOW));
-	fprintf(out, "%% pos mode\t: %s\n", posMode.c_str());
-	fprintf(out, "%% elev mask\t: %4.1f\n", elevMask);
-	fprintf(out, "%% snr mask\t: %4.1f\n", snrMask);
-	fprintf(out, "%% ionos opt\t: %s\n", ionosEst.c_str());
-	fprintf(out, "%% tropo opt\t: %s\n", troposEst.c_str());
-	fprintf(out, "%% ephemeris\t: %s\n", ephemeris.c_str());
-	fprintf(out, "%%\n%% (x/y/z-ecef=WGS84,Q=1:fix,2:float,3:sbas,4:dgps,5:single,6:ppp,ns=# of satellites)\n");
-	fprintf(out, "%%  GPST%19c%s\n",
+ 	out->print("%% program\t: %s\n", program.c_str());
+	out->print("%% inp file\t: %s\n", inpFile.c_str());
+	calendar.format(buffer, sizeof buffer, "%Y/%m/%d %H:%M", startWeek, startTOW);
+	out->print("%% obs start\t: %s:%06.3f GPST\n", buffer, getGPSseconds(startTOW));
+	calendar.format(buffer, sizeof buffer, "%Y/%m/%d %H:%M", endWeek, endTOW);
+	out->print("%% obs end\t: %s:%-06.3f GPST\n", buffer, getGPSseconds(endTOW));
+	out->print("%% pos mode\t: %s\n", posMode.c_str());
+	out->print("%% elev mask\t: %4.1f\n", elevMask);
+	out->print("%% snr mask\t: %4.1f\n", snrMask);
+	out->print("%% ionos opt\t: %s\n", ionosEst.c_str());
+	out->print("%% tropo opt\t: %s\n", troposEst.c_str());
+	out->print("%% ephemeris\t: %s\n", ephemeris.c_str());
+	out->print("%%\n%% (x/y/z-ecef=WGS84,Q=1:fix,2:float,3:sbas,4:dgps,5:single,6:ppp,ns=# of satellites)\n");
+	out->print("%%  GPST%19c%s\n",
 			' ',
 			"   x-ecef(m)      y-ecef(m)      z-ecef(m)   Q  ns   sdx(m)   sdy(m)   sdz(m)  sdxy(m)  sdyz(m)  sdzx(m) age(s)  ratio");
 }
 
+/**printHeader prints header data to the RTK file.
+ * The position and size of the header in the file are saved to allow its further rewriting.
+ *
+ * @param out	the OutputSink where header will be printed
+ */
+void RTKobservation::printHeader(OutputSink* out) {
+	MemorySink header;
+	formatHeader(&header);
+	headerBegin = out->tell();
+	headerSize = header.getSize();
+	out->write(header.getData(), (unsigned int) headerSize);
+}
+
+/**rewriteHeader prints again header data in the place of the RTK file where they were printed, and sets the file position
+ * at its end.
+ * It allows updating header data known only after printing solutions, like the end time.
+ * The new header is formatted in memory, and it is written only if it has the same size as the one printed. Otherwise
+ * the file is not modified.
+ * Note that times and masks in the header are printed with fixed width, and the other header data shall not be modified.
+ *
+ * @param out	the OutputSink where header was printed
+ * @return true if header was rewritten, false otherwise (header not printed, file not seekable, or header length changed)
+ */
+bool RTKobservation::rewriteHeader(OutputSink* out) {
+	long long end = out->tell();
+	if (headerBegin < 0 || end < 0) {
+		logger->warning("RTK header cannot be rewritten");
+		return false;
+	}
+	MemorySink header;
+	formatHeader(&header);
+	if (header.getSize() != headerSize) {
+		logger->severe("RTK header not rewritten: its length would change");
+		return false;
+	}
+	if (!out->seek(headerBegin)) {
+		logger->warning("RTK header cannot be rewritten");
+		return false;
+	}
+	out->write(header.getData(), (unsigned int) headerSize);
+	return out->seek(end);
+}
+
 /**printSolution prints a line to the RTK file with solution data from the current epoch.
+ * The whole line is formatted at once.
  *
- * @param out	the FILE were header will be printed
+ * @param out	the OutputSink where the solution will be printed
  */
-void RTKobservation::printSolution (FILE* out) {
+void RTKobservation::printSolution (OutputSink* out) {
 	char buffer[80];
-	formatGPStime (buffer, sizeof buffer,"%Y/%m/%d %H:%M", gpsWeek, gpsTOW);
-	fprintf(out, "%s:%06.3f", buffer, getGPSseconds(gpsTOW));
-	fprintf(out, " %14.4f %14.4f %14.4f %3d %3d", xSol, ySol, zSol, qSol, nSol);
-	for (int i=0; i<6; i++)
-		fprintf(out, " %8.4f", 0.0);
-	fprintf(out, "   0.00    0.0");
-	fprintf(out, "\n");
+	calendar.format(buffer, sizeof buffer, "%Y/%m/%d %H:%M", gpsWeek, gpsTOW);
+	out->print("%s:%06.3f %14.4f %14.4f %14.4f %3d %3d %8.4f %8.4f %8.4f %8.4f %8.4f %8.4f   0.00    0.0\n",
+			buffer, getGPSseconds(gpsTOW), xSol, ySol, zSol, qSol, nSol, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
 }
@@ -20,6 +20,8 @@
 
 //from CommonClasses
 #include "Logger.h"
+#include "GPSCalendar.h"
+#include "OutputSink.h"
 
 /**RTKobservation class defines data to be used for storing and further printing of a RTK file header
  * and the position solution data of each epoch.
@@ -53,9 +55,15 @@ class RTKobservation {
 	//Time related data
 	int gpsWeek;	//extended week number: 0 - no limit 
 	double gpsTOW;	//time of week in seconds as estimated by the receiver
+	GPSCalendar calendar;	//to convert GPS times to calendar data
+	//Position in the output file and size of the header printed
+	long long headerBegin;
+	unsigned long long headerSize;
 	//Logger to use
 	Logger* logger;
 
+	void formatHeader(OutputSink* out);
+
 public:
 	RTKobservation(Logger*);
 	~RTKobservation(void);
@@ -64,6 +72,7 @@ public:
 	void setStartTime();
 	void setEndTime();
 	void setPosition(int week, double tow, double x, double y, double z, int qlty, int nSat);
-	void printHeader(FILE* out);
-	void printSolution (FILE* out);
+	void printHeader(OutputSink* out);
+	bool rewriteHeader(OutputSink* out);
+	void printSolution (OutputSink* out);
 };
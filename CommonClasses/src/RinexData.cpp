@@ -7,48 +7,10 @@
 #include <algorithm>
 #include <stdio.h>
 #include <math.h>
+#include <mutex>
 //from CommonClasses
 #include "Utilities.h"
 
-//local functions used by several methods
-/**obsCompare compares two SatObsData objects to allow sorting SatObsData vector in increasing order.
- *Ordering criteria takes into account system, satellite and observation type.
- *It assumes all observations in the vector belong to the same epoch.
- *
- * @param i	the object item in position i
- * @param j	the object item in position j
- * @return true if the element passed as first argument is considered to go before the second
- */
-bool obsCompare(const SatObsData& i, const SatObsData& j) {
-	if (i.sysIndex > j.sysIndex) return false;
-	if (i.sysIndex < j.sysIndex) return true;
-	//same system
-	if (i.satellite > j.satellite) return false;
-	if (i.satellite < j.satellite) return true;
-	//same system and satellite
-	if (i.obsTypeIndex > j.obsTypeIndex) return false;
-	return true;
-}
-
-/**navCompare compares two GPSsatNav objects to allow sorting the GPSsatNav vector in increasing order.
- *Ordering criteria takes into account epoch data and satellite
- *
- * @param i	the object item in position i
- * @param j	the object item in position j
- * @return true if the element passed as first argument is considered to go before the second
- */
-bool navCompare(const GPSsatNav& i, const GPSsatNav& j) {
-	if (i.broadcastOrbit[5][2] > j.broadcastOrbit[5][2]) return false;
-	if (i.broadcastOrbit[5][2] < j.broadcastOrbit[5][2]) return true;
-	//same week
-	if (i.broadcastOrbit[0][0] > j.broadcastOrbit[0][0]) return false;
-	if (i.broadcastOrbit[0][0] < j.broadcastOrbit[0][0]) return true;
-	//same week and t0c
-	if (i.satellite > j.satellite) return false;
-	//same week, t0c satellite
-	return true;
-}
-
 /**getRINEXFileName gets a standard RINEX observation file name from the firts epoch time data and prefix given.
  *
  * @param designator the file name prefix with a 4-character station name designator
@@ -59,35 +21,30 @@ bool navCompare(const GPSsatNav& i, const GPSsatNav& j) {
  */
 string RinexData::getRINEXfileName(string designator, int week, int sec, char ftype) {
 	//get calendar for the GPS time
-	string fileName;
-	time_t rawtime;
-	struct tm * timeinfo;
 	char buffer[30];
 
-	time (&rawtime);
-	timeinfo = localtime (&rawtime);
-	//set GPS ephemeris 6/1/1980, adding gps time data to get current time
-	timeinfo->tm_year = 80;
-	timeinfo->tm_mon = 0;
-	timeinfo->tm_mday = 6 + week * 7;
-	timeinfo->tm_hour = 0;
-	timeinfo->tm_min = 0;
-	timeinfo->tm_sec = sec;
-	mktime(timeinfo);
+	calendar.setTime(week, sec);
 	designator += "----";
 	designator = designator.substr(0,4);
 	sprintf(buffer, "%4s%03d%1c%02d.%02d%c",
 		designator.c_str(),
-		timeinfo->tm_yday + 1,
-		'a'+timeinfo->tm_hour,
-		timeinfo->tm_min,
-		timeinfo->tm_year % 100,
+		calendar.getYearDay(),
+		'a'+calendar.getHour(),
+		calendar.getMinute(),
+		calendar.getYear() % 100,
 		ftype);
 	return string(buffer);
 }
 
+//@cond DUMMY
+//the observation types interned by GNSSsystem::getObsTypeId: the ID of each one is its position
+static vector <string> obsTypeIds;
+static mutex obsTypeIdsMutex;
+//@endcond
+
 //class methods
-/**GNSSsystem constructor
+/**GNSSsystem constructor.
+ * Observation types are resolved to their IDs, to allow finding them without string comparisons.
  *
  *@param sys the system identification
  *@param obsT the observation types for this system ( C L1 L2 L5 L6 L7 L8 )
@@ -95,6 +52,11 @@ string RinexData::getRINEXfileName(string designator, int week, int sec, char ft
 GNSSsystem::GNSSsystem (char sys, vector <string> obsT) {
 	system = sys;
 	obsType.insert(obsType.end(), obsT.begin(), obsT.end());
+	for (unsigned i=0; i<obsT.size(); i++) {
+		unsigned int id = getObsTypeId(obsT[i]);
+		if (id >= obsSlot.size()) obsSlot.resize(id + 1, -1);
+		if (obsSlot[id] < 0) obsSlot[id] = i;
+	}
 	biasFactor.resize(obsT.size());
 	for (unsigned i=0; i<obsT.size(); i++)
 		if (obsType[i].find("C") == 0) biasFactor[i] = LSPEED;
@@ -107,6 +69,49 @@ GNSSsystem::GNSSsystem (char sys, vector <string> obsT) {
 		else biasFactor[i] = 0.0;
 }
 
+/**getObsSlot gets the index in obsType of the observation type with the given ID.
+ *
+ *@param id the observation type ID, as given by getObsTypeId
+ *@return the index in obsType, or -1 if the observation type is not in this system
+ */
+int GNSSsystem::getObsSlot(int id) {
+	if ((id < 0) || (id >= (int) obsSlot.size())) return -1;
+	return obsSlot[id];
+}
+
+/**getObsTypeId gets the ID of the given observation type, a small integer that identifies it among all the
+ * observation types used. A new ID is given to observation types not used before.
+ * Decoders should get the IDs of the observation types they provide once, before acquiring data.
+ *
+ *@param obsT the observation type (C1C, L1C, D1C, S1C...)
+ *@return the ID of the observation type
+ */
+int GNSSsystem::getObsTypeId(const string& obsT) {
+	lock_guard<mutex> lock(obsTypeIdsMutex);
+	for (unsigned int i=0; i<obsTypeIds.size(); i++)
+		if (obsTypeIds[i].compare(obsT) == 0) return i;
+	obsTypeIds.push_back(obsT);
+	return (int) obsTypeIds.size() - 1;
+}
+
+/**resize sets the number of satellites (rows) in the columns, resizing all of them.
+ * Observable types shall be set before resizing.
+ *
+ *@param n the number of satellites
+ */
+void ObsColumns::resize(unsigned int n) {
+	system.resize(n);
+	satellite.resize(n);
+	timeTag.resize(n);
+	present.resize(n);
+	value.resize(obsType.size());
+	strength.resize(obsType.size());
+	for (unsigned int t=0; t<obsType.size(); t++) {
+		value[t].resize(n);
+		strength[t].resize(n);
+	}
+}
+
 /**Constructs a RinexData object initialized with RINEX header data passed in parameters.
  *
  * @param v the RINEX version to be generated. (V210 or V300)
@@ -140,10 +145,30 @@ RinexData::RinexData(string v, string p, string r, string mn, string mu, string
 	antHigh = 0.0;
 	eccEast = 0.0;
 	eccNorth = 0.0;
+	firstObsWeek = 0;
+	firstObsTOW = 0.0;
+	obsInterval = 0.0;
+	firstObsSet = false;
+	intervalSet = false;
+	gpsWeek = 0;
+	gpsTOW = 0.0;
 	appEnd = ae;
 	applyBias = ab;
 	epochFlag = 0;
 	systems = sy;
+	//set the epoch buffer: for each system, MAXOBSPRN satellites with a slot for each observation type
+	unsigned int nSlots = 0;
+	for (unsigned int i=0; i<systems.size(); i++) {
+		epochSysBase.push_back(nSlots);
+		nSlots += MAXOBSPRN * (unsigned int) systems[i].obsType.size();
+	}
+	epochObs.resize(nSlots);
+	obsPresent.assign(systems.size() * MAXOBSPRN, 0);
+	nEpochObs = 0;
+	//set the look up table for systems
+	for (int i=0; i<256; i++) systemIndex[i] = -1;
+	for (unsigned int i=0; i<systems.size(); i++)
+		if (systemIndex[(unsigned char) systems[i].system] < 0) systemIndex[(unsigned char) systems[i].system] = i;
 	//fill scale factors for GPS navigation data bradcast orbits
 	//SV clock data
 	SCALEFACTORS[0][0] = pow(2.0, 4.0);		//T0c
@@ -210,26 +235,6 @@ RinexData::RinexData(string v, string p, string r, string mn, string mu, string
 RinexData::~RinexData(void) {
 }
 
-/**Constructs a SatObsData object for storing satellite observations (pseudorrange, phase, ...) in one epoch.
- *
- * @param sys the index inside a GNSSsystem vector of the system this observation belongs
- * @param sat the satellite PRN this observation belongs
- * @param epoch the epoch time for this observation stimated by the receiver before computing the solution
- * @param obsTi the index in obsType vector inside GNSSsystem of the observation type this data belong
- * @param obsVal the value of this observation
- * @param lol if loss of lock happened when observation was taken
- * @param str the signal strength when observation was taken
- */
-SatObsData::SatObsData (int sys, int sat, double epoch, int obsTi, double obsVal, int lol, int str) {
-	sysIndex = sys;
-	satellite = sat;
-	epochTime = epoch;
-	obsTypeIndex = obsTi;
-	obsValue = obsVal;
-	lossOfLock = lol;
-	strength = str;
-}
-
 /**Construct an object used to define storage for navigation data for a given GPS satellite
  *
  * @param sat the PRN of the satellite they belong
@@ -242,6 +247,30 @@ GPSsatNav::GPSsatNav(int sat, unsigned int bo[8][4]) {
 			broadcastOrbit[i][j] = bo[i][j];
 }
 
+/**Construct the key identifying navigation data for a given GPS satellite
+ *
+ * @param sat the PRN of the satellite they belong
+ * @param bo the eigth lines of RINEX broadcast orbit data with four parameters each
+ */
+GPSnavKey::GPSnavKey(int sat, unsigned int bo[8][4]) {
+	week = bo[5][2];
+	toc = bo[0][0];
+	satellite = sat;
+	iode = bo[1][0];
+}
+
+/**operator< compares two keys to order navigation data by epoch (week and Toc), satellite and IODE
+ *
+ * @param other the key to compare with
+ * @return true if this key goes before the other one
+ */
+bool GPSnavKey::operator<(const GPSnavKey& other) const {
+	if (week != other.week) return week < other.week;
+	if (toc != other.toc) return toc < other.toc;
+	if (satellite != other.satellite) return satellite < other.satellite;
+	return iode < other.iode;
+}
+
 /**setPosition sets APROX POSITION data to be used in the RINEX file header.
  * 
  * @param x : the X coordinate of the position
@@ -291,6 +320,22 @@ double RinexData::getGPSTime () {
 	return gpsTOW;
 }
 
+/**getEpochTimeTag gets the time tag of the current epoch, as estimated by the receiver before the fix.
+ * 
+ * @return the epoch time tag in seconds from the beginning of the week
+ */
+double RinexData::getEpochTimeTag () {
+	return epochTimeTag;
+}
+
+/**setEpochTimeTag sets the time tag of the current epoch, f.e. when epochs have been acquired using another RinexData object.
+ * 
+ * @param tTag the epoch time tag in seconds from the beginning of the week
+ */
+void RinexData::setEpochTimeTag (double tTag) {
+	epochTimeTag = tTag;
+}
+
 /**getObsFileName constructs a standard RINEX observation file name from the current data.
  *
  * @param prefix : the file name prefix
@@ -308,11 +353,10 @@ string RinexData::getObsFileName(string prefix) {
 string RinexData::getGPSnavFileName(string prefix) {
 	if (gpsEphmNav.size() == 0)	//there are not navigation data!
 		return getRINEXfileName(prefix, gpsWeek, (int) gpsTOW, 'N');
-	//sort navigation data items available by epoch and satellite
-	sort(gpsEphmNav.begin(), gpsEphmNav.end(), navCompare);
-	//the first item in vector has the oldest epoch
-	int gpsW = gpsEphmNav[0].broadcastOrbit[5][2];
-	int gpsT = (int) (gpsEphmNav[0].broadcastOrbit[0][0] * SCALEFACTORS[0][0]);
+	//navigation data are stored by epoch and satellite: the first item has the oldest epoch
+	const GPSsatNav& first = gpsEphmNav.begin()->second;
+	int gpsW = first.broadcastOrbit[5][2];
+	int gpsT = (int) (first.broadcastOrbit[0][0] * SCALEFACTORS[0][0]);
 	return getRINEXfileName(prefix, gpsW, gpsT, 'N');
 }
 
@@ -322,6 +366,7 @@ string RinexData::getGPSnavFileName(string prefix) {
 void RinexData::setFistObsTime() {
 	firstObsWeek = gpsWeek;
 	firstObsTOW = gpsTOW;
+	firstObsSet = true;
 }
 
 /**setIntervalTime computes and sets in RINEX header the time interval of GPS measurements.
@@ -333,65 +378,141 @@ void RinexData::setFistObsTime() {
  */
 void RinexData::setIntervalTime(int weeks, double secs) {
 	obsInterval = (float) ((secs - gpsTOW) + (weeks - gpsWeek) * 604800.0);
+	intervalSet = true;
+}
+
+/**setIntervalTime computes and sets in RINEX header the time interval of GPS measurements as the time difference
+ * between the fist observation time and the current epoch time.
+ * It is used when the interval could not be acquired with header data, to set it from the epochs acquired.
+ * The interval is not set if the current epoch time is not after the first observation time.
+ */
+void RinexData::setIntervalTime() {
+	double interval = (gpsTOW - firstObsTOW) + (gpsWeek - firstObsWeek) * 604800.0;
+	if (interval <= 0.0) return;
+	obsInterval = (float) interval;
+	intervalSet = true;
+}
+
+/**hasObsTimes tells if the time of the first observation and the observation interval have been set.
+ *
+ * @return true if both have been set, false otherwise
+ */
+bool RinexData::hasObsTimes() {
+	return firstObsSet && intervalSet;
+}
+
+/**storeObs stores an observation value in its slot of the epoch buffer.
+ * Observations of satellites with PRN out of the buffer range, or with observation type index beyond MAXOBSTYPES,
+ * are not stored. If the slot already has a value, it is replaced.
+ *
+ * @param sysIndex the index inside the systems vector of the system the observation belongs
+ * @param sat the satellite PRN the observation belongs
+ * @param obsTypeIndex the index in obsType vector inside GNSSsystem of the observation type
+ * @param value the value of the observation
+ * @param lol the loss o lock indicator
+ * @param strg the signal strength
+ */
+void RinexData::storeObs(int sysIndex, int sat, int obsTypeIndex, double value, int lol, int strg) {
+	if ((sat < 0) || (sat >= MAXOBSPRN) || (obsTypeIndex >= (int) MAXOBSTYPES)) return;
+	ObsSlot& slot = epochObs[epochSysBase[sysIndex] + sat * systems[sysIndex].obsType.size() + obsTypeIndex];
+	slot.obsValue = value;
+	slot.lossOfLock = lol;
+	slot.strength = strg;
+	unsigned int& present = obsPresent[sysIndex * MAXOBSPRN + sat];
+	unsigned int bit = 1u << obsTypeIndex;
+	if ((present & bit) == 0) nEpochObs++;
+	present |= bit;
 }
 
 /**addMeasurement stores measurement data for an observable into the epoch data storage.
  * The new measurement data are stored only when given data belongs to the current epoch or
- * when the observations vector is empty.
+ * when the epoch data storage is empty.
  *
  * @param sys the system identification (G, S, ...) the measurement belongs
  * @param sat the satellite PRN the measurement belongs
- * @param obsType the type of measurement (C1C, L1C, D1C, ...) as per RINEX V3.00
+ * @param obsTypeId the ID of the type of measurement (C1C, L1C, D1C, ...) as per RINEX V3.00. See GNSSsystem::getObsTypeId
  * @param value the value of the measurement
  * @param lol the loss o lock indicator. See V2.10
  * @param strg the signal strength. See V3.00
  * @param tTag the time when measurements where made used to tag them. To be corrected when solution found
  * @return true if data have been added, false otherwise
  */
-bool RinexData::addMeasurement (char sys, int sat, string obsType, double value, int lol, int strg, double tTag) {
+bool RinexData::addMeasurement (char sys, int sat, int obsTypeId, double value, int lol, int strg, double tTag) {
 //	bool sameEpoch = (nSatsObs == 0) || (epochTimeTag == tTag);
-	if (observations.size() == 0) epochTimeTag = tTag;
+	if (nEpochObs == 0) epochTimeTag = tTag;
 	bool sameEpoch = epochTimeTag == tTag;
 	//check if this observation type for this system shall be stored
-	for (unsigned int i=0; sameEpoch && i<systems.size(); i++)
-		if (sys == systems[i].system)
-			for (unsigned int j=0; j<systems[i].obsType.size(); j++)
-				if (obsType.compare(systems[i].obsType[j]) == 0) {
-					observations.push_back(SatObsData(i, sat, tTag, j, value, lol, strg));
-					return sameEpoch;
-				}
+	int sysIndex = systemIndex[(unsigned char) sys];
+	if (sameEpoch && sysIndex >= 0) {
+		int slot = systems[sysIndex].getObsSlot(obsTypeId);
+		if (slot >= 0) storeObs(sysIndex, sat, slot, value, lol, strg);
+	}
 	return sameEpoch;
 }
 
+/**addMeasurements stores measurement data of several satellites given in columns into the epoch data storage.
+ * Measurements are stored in the same order and under the same conditions as if addMeasurement were called
+ * for each satellite and observable type present, but observable types are looked up only once for each system.
+ *
+ * @param cols the measurement data in columns
+ */
+void RinexData::addMeasurements (ObsColumns& cols) {
+	int sysIndex = -1;
+	char lastSys = 0;
+	vector <int> typeIndex(cols.obsType.size());
+	for (unsigned int k=0; k<cols.satellite.size(); k++) {
+		if (cols.present[k] == 0) continue;
+		if (nEpochObs == 0) epochTimeTag = cols.timeTag[k];
+		if (epochTimeTag != cols.timeTag[k]) continue;
+		//look up the observable types for this system, if not done for the former satellite
+		if (cols.system[k] != lastSys) {
+			lastSys = cols.system[k];
+			sysIndex = systemIndex[(unsigned char) lastSys];
+			for (unsigned int t=0; sysIndex >= 0 && t<cols.obsType.size(); t++)
+				typeIndex[t] = systems[sysIndex].getObsSlot(cols.obsType[t]);
+		}
+		if (sysIndex < 0) continue;
+		for (unsigned int t=0; t<cols.obsType.size(); t++)
+			if ((cols.present[k] & (1 << t)) != 0 && typeIndex[t] >= 0)
+				storeObs(sysIndex, cols.satellite[k], typeIndex[t], cols.value[t][k], 0, cols.strength[t][k]);
+	}
+}
+
+/**isSameEpoch tells if measurements having the given time tag belong to the current epoch, that is, if the time tag
+ * is the one of the observations stored, or there are no observations stored.
+ *
+ * @param tTag the time when measurements where made
+ * @return true if they belong to the current epoch, false otherwise
+ */
+bool RinexData::isSameEpoch (double tTag) {
+	return nEpochObs == 0 || epochTimeTag == tTag;
+}
+
 /**addGPSNavData stores navigation data from a GPS satellite into the GPS nav data storage.
- * The navigation data are stored only when they are new (different satellite and epoch), or when gpsEphmNav vector is empty.
+ * The navigation data are stored only when they are new (different satellite, epoch or IODE).
  *
  * @param sat the satellite PRN the measurement belongs
  * @param bo the broadcast orbit data with the eight lines of RINEX navigation data with four parameters each
  * @return true if data have been added, false otherwise
  */
 bool RinexData::addGPSNavData(int sat, unsigned int bo[8][4]) {
-	//check if this epoch data already exists: same satellite and epoch time
-	for (unsigned int i=0; i<gpsEphmNav.size(); i++)
-		if((gpsEphmNav[i].satellite == sat)
-			&& (bo[5][2] == gpsEphmNav[i].broadcastOrbit[5][2])
-			&& (bo[0][0] == gpsEphmNav[i].broadcastOrbit[0][0])) return false;
-	gpsEphmNav.push_back(GPSsatNav(sat, bo));
-	return true;
+	//data are not inserted if they already exist: same satellite, epoch time and IODE
+	return gpsEphmNav.insert(make_pair(GPSnavKey(sat, bo), GPSsatNav(sat, bo))).second;
 }
 
 /**clearObs clears the current observation data.
  *
  */
 void RinexData::clearObs() {
-	observations.clear();
+	fill(obsPresent.begin(), obsPresent.end(), 0);
+	nEpochObs = 0;
 }
 
 /**printObsHeader prints the RINEX observation file header using current RINEX data.
  * 
- * @param out the already open print stream where RINEX header will be printed
+ * @param out the OutputSink where RINEX header will be printed
  */
-void RinexData::printObsHeader(FILE* out) {
+void RinexData::printObsHeader(OutputSink* out) {
 	char timeBuffer[80];
 	//1st header line
 	float v = 0;
@@ -400,183 +521,199 @@ void RinexData::printObsHeader(FILE* out) {
 	case V300: v = (float) 3.0; break;
 	}
 	//header line 1 : file contents (observation data)
-	fprintf(out, "%9.2f%11c%1c%-19s%1c%19c%-20s\n", 
+	out->print("%9.2f%11c%1c%-19s%1c%19c%-20s\n", 
  				v, ' ', 'O', "BSERVATION DATA", 'M', ' ', "RINEX VERSION / TYPE");
 	//get local time and format it as needed
 	formatLocalTime(timeBuffer, sizeof timeBuffer,"%Y%m%d %H%M%S ");
 	//header line 2: identification of the receiver and file generation date
-	fprintf(out, "%-20s%-20s%s%3s %-20s\n",
+	out->print("%-20s%-20s%s%3s %-20s\n",
  				pgm.c_str(), runby.c_str(), timeBuffer, "LCL", "PGM / RUN BY / DATE");
   	//print 3 MARKER lines
- 	fprintf(out, "%-60.60s%-20s\n",
+ 	out->print("%-60.60s%-20s\n",
 				markerName.c_str(), "MARKER NAME");
- 	fprintf(out, "%-60.60s%-20s\n",
+ 	out->print("%-60.60s%-20s\n",
  				markerNumber.c_str(), "MARKER NUMBER" );
  	if (version == V300)
- 			fprintf(out, "%-20s%40c%-20s\n",
+ 			out->print("%-20s%40c%-20s\n",
  				"NON GEODETIC", ' ', "MARKER TYPE" );
  	//print OBSERVER line
- 	fprintf(out,"%-20.20s%-40.40s%-20s\n",
+ 	out->print("%-20.20s%-40.40s%-20s\n",
  				observer.c_str(), agency.c_str(), "OBSERVER / AGENCY" );
  	//print receiver and antenna lines
- 	fprintf(out, "%-20.20s%-20.20s%-20.20s%-20s\n",
+ 	out->print("%-20.20s%-20.20s%-20.20s%-20s\n",
  				rxNumber.c_str(), rxType.c_str(), rxVersion.c_str(),"REC # / TYPE / VERS");
- 	fprintf(out, "%-20.20s%-20.20s%20c%-20s\n",
+ 	out->print("%-20.20s%-20.20s%20c%-20s\n",
  				antNumber.c_str(), antType.c_str(), ' ', "ANT # / TYPE" );
  	//print APPROXimate position data
-	fprintf(out, "%14.4f%14.4f%14.4f%18c%-20s\n",
+	out->print("%14.4f%14.4f%14.4f%18c%-20s\n",
  			aproxX, aproxY, aproxZ, ' ', "APPROX POSITION XYZ" );
- 	fprintf(out, "%14.4f%14.4f%14.4f%18c%-20s\n",
+ 	out->print("%14.4f%14.4f%14.4f%18c%-20s\n",
  				antHigh, eccEast, eccNorth, ' ', "ANTENNA: DELTA H/E/N");
  	if (version == V210)
- 			fprintf(out, "%6d%6d%6d%42c%-20s\n",
+ 			out->print("%6d%6d%6d%42c%-20s\n",
  	 					wvlenFactorL1, wvlenFactorL2, 0, ' ', "WAVELENGTH FACT L1/2");
  	//print the lines with systems data
  	switch (version) {
  	case V210:	//version 2.10
  		//limited implementation assuming same observables and order for all systems, and maximum 9 observations
-		fprintf(out, "%6d", systems[0].obsType.size());
+		out->print("%6d", systems[0].obsType.size());
 		for (unsigned int j=0; j<9; j++)
 			if (j < systems[0].obsType.size())
-				fprintf(out, "%4c%2.2s", ' ', systems[0].obsType[j].c_str());
+				out->print("%4c%2.2s", ' ', systems[0].obsType[j].c_str());
 			else
-				fprintf(out, "%6c", ' ');
- 		fprintf(out, "%-20s\n", "# / TYPES OF OBSERV");
+				out->print("%6c", ' ');
+ 		out->print("%-20s\n", "# / TYPES OF OBSERV");
  		break;
  	case V300:	//version 3.00
  		//limited implementation assuming maximum 13 observations per system
 		for (unsigned int i=0; i<systems.size(); i++) {
- 			fprintf(out, "%1c  %3d", systems[i].system, systems[i].obsType.size());
+ 			out->print("%1c  %3d", systems[i].system, systems[i].obsType.size());
  			for (unsigned int j=0; j < 13; j++)
 				if (j < systems[i].obsType.size())
- 					fprintf(out, " %3s", systems[i].obsType[j].c_str());
+ 					out->print(" %3s", systems[i].obsType[j].c_str());
  				else
- 					fprintf(out, "%4c", ' ');
- 			fprintf(out, "  %-20s\n", "SYS / # / OBS TYPES");
+ 					out->print("%4c", ' ');
+ 			out->print("  %-20s\n", "SYS / # / OBS TYPES");
  		}
  		break;
  	default:
-		fprintf(out, "%-60s%-20s\n", "INTERNAL ERROR. INCONSISTENT VERSION","COMMENT");
+		out->print("%-60s%-20s\n", "INTERNAL ERROR. INCONSISTENT VERSION","COMMENT");
  	}
  	//observation interval
- 	fprintf(out, "%10.3f%50c%-20s\n", obsInterval, ' ',"INTERVAL");
+ 	out->print("%10.3f%50c%-20s\n", obsInterval, ' ',"INTERVAL");
  	//format the time of first observation
-	formatGPStime (timeBuffer, sizeof timeBuffer, "  %Y    %m    %d    %H    %M  ", firstObsWeek, firstObsTOW);
-	fprintf(out, "%s%11.7f",
+	calendar.format(timeBuffer, sizeof timeBuffer, "  %Y    %m    %d    %H    %M  ", firstObsWeek, firstObsTOW);
+	out->print("%s%11.7f",
 				timeBuffer, getGPSseconds (firstObsTOW));
- 	fprintf(out, "%5c%3s%9c%-20s\n",
+ 	out->print("%5c%3s%9c%-20s\n",
  				' ', "GPS", ' ', "TIME OF FIRST OBS" );
-	fprintf(out, "%60c%-20s\n", ' ', "END OF HEADER");
+	out->print("%60c%-20s\n", ' ', "END OF HEADER");
 }
 
 /**printObsEpoch prints lines with one EPOCH observation data in the output RINEX file.
  * 
- * @param out the already open print stream where RINEX epoch data will be printed
+ * @param out the OutputSink where RINEX epoch data will be printed
  */
-void RinexData::printObsEpoch(FILE* out) {
+void RinexData::printObsEpoch(OutputSink* out) {
 	char timeBuffer[80];
 	//check if anything to print
- 	if (observations.size() == 0) return;
-	//sort observation data items available by system, satellite and measurement type
-	sort(observations.begin(), observations.end(), obsCompare);
-	//apply bias to measurements
-	if (applyBias)
-		for (unsigned int i=0; i<observations.size(); i++) {
-			observations[i].obsValue -= clkBias * systems[observations[i].sysIndex].biasFactor[observations[i].obsTypeIndex];
-		}
+ 	if (nEpochObs == 0) return;
 	//count the number of different satellites with data in this epoch (at least one)
-	int nSatsEpoch = 1;
-	for (unsigned int i=1; i<observations.size(); i++)
-		if ((observations[i-1].sysIndex != observations[i].sysIndex) ||
-			(observations[i-1].satellite != observations[i].satellite)) nSatsEpoch++;
+	int nSatsEpoch = 0;
+	for (unsigned int i=0; i<obsPresent.size(); i++)
+		if (obsPresent[i] != 0) nSatsEpoch++;
+	//the epoch buffer is iterated by system, satellite and measurement type, the order they are printed
 	switch (version) {
 	case V210:	//RINEX version 2.10
  		//print epoch 1st line
 		//print calendar for the GPS time of this epoch
-		formatGPStime (timeBuffer, 80, " %y %m %d %H %M", gpsWeek, epochTimeTag - (applyBias? clkBias: 0.0));
- 		fprintf(out, "%s%11.7f", timeBuffer, getGPSseconds(epochTimeTag - (applyBias? clkBias: 0.0)));
- 		fprintf(out, "  %1d%3d", epochFlag, nSatsEpoch);
+		calendar.format(timeBuffer, 80, " %y %m %d %H %M", gpsWeek, epochTimeTag - (applyBias? clkBias: 0.0));
+		line.addText(timeBuffer);
+		line.addFixed(getGPSseconds(epochTimeTag - (applyBias? clkBias: 0.0)), 11, 7);
+		line.addChars(' ', 2);
+		line.addInt(epochFlag, 1);
+		line.addInt(nSatsEpoch, 3);
 		//print the different systems and satellites existing in this epoch
-		fprintf(out, "%1c%02d", systems[observations[0].sysIndex].system, observations[0].satellite);
-		for (unsigned int i=1; i<observations.size(); i++)
-			if ((observations[i-1].sysIndex != observations[i].sysIndex) || (observations[i-1].satellite != observations[i].satellite)) 
-				fprintf(out, "%1c%02d", systems[observations[i].sysIndex].system, observations[i].satellite);
+		for (unsigned int i=0; i<systems.size(); i++)
+			for (int sat=0; sat<MAXOBSPRN; sat++)
+				if (obsPresent[i * MAXOBSPRN + sat] != 0) {
+					line.addChars(systems[i].system, 1);
+					line.addZeroPaddedInt(sat, 2);
+				}
 		//fill the line and print clock bias used
-		for (int i=nSatsEpoch; i<12; i++) fprintf(out, "%3c", ' ');	//???12 por constante
-		fprintf(out, "%12.9f\n", clkBias);
-		//for each satellite belonging to this epoch, print a line of measurements data and remove them from observations
-		while (printSatObsValues(out));
+		for (int i=nSatsEpoch; i<12; i++) line.addChars(' ', 3);	//???12 por constante
+		line.addFixed(clkBias, 12, 9);
+		line.addText("\n");
+		line.write(out);
+		//for each satellite belonging to this epoch, print a line of measurements data
+		for (unsigned int i=0; i<systems.size(); i++)
+			for (int sat=0; sat<MAXOBSPRN; sat++)
+				if (obsPresent[i * MAXOBSPRN + sat] != 0) printSatObsValues(out, i, sat);
  		break;
 	case V300:	//RINEX version 3.00
 		//print epoch 1st line
- 		formatGPStime (timeBuffer, 80, "> %Y %m %d %H %M", gpsWeek, epochTimeTag - clkBias);
- 		fprintf(out, "%s%11.7f", timeBuffer, getGPSseconds(epochTimeTag - clkBias));
- 		fprintf(out, "  %1d%3d%5c%15.12f%3c\n", epochFlag, nSatsEpoch, ' ', clkBias, ' ');
-		//for each satellite belonging to this epoch, print line of measurements data and remove them from observations
-		do {
-			fprintf(out, "%1c%02d", systems[observations[0].sysIndex].system, observations[0].satellite);
- 		} while (printSatObsValues(out));
+ 		calendar.format(timeBuffer, 80, "> %Y %m %d %H %M", gpsWeek, epochTimeTag - clkBias);
+		line.addText(timeBuffer);
+		line.addFixed(getGPSseconds(epochTimeTag - clkBias), 11, 7);
+		line.addChars(' ', 2);
+		line.addInt(epochFlag, 1);
+		line.addInt(nSatsEpoch, 3);
+		line.addChars(' ', 5);
+		line.addFixed(clkBias, 15, 12);
+		line.addChars(' ', 3);
+		line.addText("\n");
+		line.write(out);
+		//for each satellite belonging to this epoch, print line of measurements data
+		for (unsigned int i=0; i<systems.size(); i++)
+			for (int sat=0; sat<MAXOBSPRN; sat++)
+				if (obsPresent[i * MAXOBSPRN + sat] != 0) {
+					line.addChars(systems[i].system, 1);
+					line.addZeroPaddedInt(sat, 2);
+					printSatObsValues(out, i, sat);
+				}
  		break;
  	default:
-		fprintf(out, "%-60s%-20s\n", "INTERNAL ERROR. INCONSISTENT VERSION","COMMENT");
+		out->print("%-60s%-20s\n", "INTERNAL ERROR. INCONSISTENT VERSION","COMMENT");
  	}
+	//printed data are removed from the epoch buffer
+	clearObs();
 }
 
-/**printSatObsValues prints a line with the satellite observation values.
- * Observation data are removed after printing.
- * Note that values are sorted in the observations storage by system, satellite and observation type.
+/**printSatObsValues prints a line with the observation values of a satellite in the epoch buffer, after the
+ * fields already formatted in the line buffer. Values are printed in the order of observation types, up to the last
+ * one present. Observation types not present before it are printed as zero values.
+ * If stated, the receiver clock bias is applied to the values printed.
  *
- * @param out the already open print stream where RINEX epoch data will be printed
- * @return true if they remain observations belonging to the current epoch, false when no data remains to print.
+ * @param out the OutputSink where RINEX epoch data will be printed
+ * @param sysIndex the index inside the systems vector of the system the satellite belongs
+ * @param sat the satellite PRN
  */
-bool RinexData::printSatObsValues(FILE* out) {
+void RinexData::printSatObsValues(OutputSink* out, int sysIndex, int sat) {
 	double valueToPrint;
-	if (observations.size() == 0) return false;
-	int sysToPrint = observations[0].sysIndex;
-	int satToPrint = observations[0].satellite;
-	int obsToPrint = 0;
-	while ((observations.size() > 0) &&
-			(observations[0].sysIndex == sysToPrint) &&
-			(observations[0].satellite == satToPrint)) {
-		if (observations[0].obsTypeIndex == obsToPrint) {
-			valueToPrint = observations[0].obsValue;
+	const ObsSlot* slot = &epochObs[epochSysBase[sysIndex] + sat * systems[sysIndex].obsType.size()];
+	unsigned int obsToPrint = 0;
+	for (unsigned int present = obsPresent[sysIndex * MAXOBSPRN + sat]; present != 0; present >>= 1) {
+		if ((present & 0x01) != 0) {
+			valueToPrint = slot[obsToPrint].obsValue;
+			//apply bias to measurements
+			if (applyBias) valueToPrint -= clkBias * systems[sysIndex].biasFactor[obsToPrint];
 			//discard measurements out of range used in the RINEX format 14.3f
 			if ((valueToPrint > MAXOBSVAL) || (valueToPrint < MINOBSVAL)) valueToPrint = 0.0;
-			fprintf(out, "%14.3f", valueToPrint);
-			if (observations[0].lossOfLock == 0) fprintf(out, " ");
-			else fprintf(out, "%1d", observations[0].lossOfLock);
-			if (observations[0].strength == 0) fprintf(out, " ");
-			else fprintf(out, "%1d", observations[0].strength);
-			observations.erase(observations.begin());
+			line.addFixed(valueToPrint, 14, 3);
+			if (slot[obsToPrint].lossOfLock == 0) line.addChars(' ', 1);
+			else line.addInt(slot[obsToPrint].lossOfLock, 1);
+			if (slot[obsToPrint].strength == 0) line.addChars(' ', 1);
+			else line.addInt(slot[obsToPrint].strength, 1);
 		} else {
-			fprintf(out, "%14.3f  ", 0.0);
+			line.addFixed(0.0, 14, 3);
+			line.addChars(' ', 2);
 		}
 		obsToPrint++;
 	}
-	fprintf(out, "\n");
-	return (observations.size() > 0);
+	line.addText("\n");
+	line.write(out);
 }
 
 /**printEndOfFile prints the RINEX end of file event lines.
  * 
- * @param out	The already open print file where RINEX data will be printed
+ * @param out	the OutputSink where RINEX data will be printed
  */
- void RinexData::printObsEOF(FILE* out) {
+ void RinexData::printObsEOF(OutputSink* out) {
 	char timeBuffer[80];
 	if (!appEnd) return;
  	//print header information for event "follows line"
-	formatGPStime (timeBuffer, 80, " %y %m %d %H %M", gpsWeek, epochTimeTag - (applyBias? clkBias: 0.0));
- 	fprintf(out, "%s%11.7f", timeBuffer, getGPSseconds(epochTimeTag - (applyBias? clkBias: 0.0)));
- 	fprintf(out, "  %1d%3d\n", 4, 1);
+	calendar.format(timeBuffer, 80, " %y %m %d %H %M", gpsWeek, epochTimeTag - (applyBias? clkBias: 0.0));
+ 	out->print("%s%11.7f", timeBuffer, getGPSseconds(epochTimeTag - (applyBias? clkBias: 0.0)));
+ 	out->print("  %1d%3d\n", 4, 1);
 	//print comment line
- 	fprintf(out, "%-60s%-20s\n", "END OF FILE", "COMMENT");
+ 	out->print("%-60s%-20s\n", "END OF FILE", "COMMENT");
 }
  
  /**printGPSnavHeader prints RINEX GPS navigation file header using the current RINEX data.
  * 
- * @param out	The already open print file where RINEX header will be printed
+ * @param out	the OutputSink where RINEX header will be printed
  */
-void RinexData::printGPSnavHeader(FILE* out) {
+void RinexData::printGPSnavHeader(OutputSink* out) {
 	char timeBuffer[80];
 	//1st header line
 	float v = 0;
@@ -586,63 +723,65 @@ void RinexData::printGPSnavHeader(FILE* out) {
 	}
 	//get local time and format it as needed
 	formatLocalTime(timeBuffer, sizeof timeBuffer,"%Y%m%d %H%M%S ");
-	fprintf(out, "%9.2f%11c%1c%-19s%20c%-20s\n",
+	out->print("%9.2f%11c%1c%-19s%20c%-20s\n",
  				v, ' ', 'N', " GPS NAV DATA", ' ', "RINEX VERSION / TYPE");
-	fprintf(out, "%-20s%-20s%s%3s %-20s\n",
+	out->print("%-20s%-20s%s%3s %-20s\n",
  				pgm.c_str(), runby.c_str(), timeBuffer, "LCL", "PGM / RUN BY / DATE");
 /*TBW
   	//print iono parameters A0-A3 of almanac (page 18 of subframe 4)
-	fprintf(out, "%-60.60s%-20s\n",
+	out->print("%-60.60s%-20s\n",
 					, "ION ALPHA" );
 	//print iono p<rameters B0-B3 of almanac
-	fprintf(out, "%-60.60s%-20s\n",
+	out->print("%-60.60s%-20s\n",
 					, "ION BETA" );
 	//print almanac parameters to compute time in UTC (p 18, subframe 4)
-	fprintf(out, "%-60.60s%-20s\n",
+	out->print("%-60.60s%-20s\n",
 					, "DELTA-UTC: A0,A1,T,W" );
 	//print Delta time due to leap seconds, V3.0: Number of leap seconds since 6-Jan-1980
-	fprintf(out, "%-60.60s%-20s\n",
+	out->print("%-60.60s%-20s\n",
 					, "LEAP SECONDS" );
 */
-	fprintf(out, "%60c%-20s\n",
+	out->print("%60c%-20s\n",
  				' ', "END OF HEADER");
 }
 
 /**printGPSnavEpoch prints lines with one EPOCH GPS navigation data in the output RINEX file
  * 
- * @param out the already open print file where RINEX epoch will be printed
+ * @param out the OutputSink where RINEX epoch will be printed
  */
-void RinexData::printGPSnavEpoch(FILE* out) {
+void RinexData::printGPSnavEpoch(OutputSink* out) {
 	char timeBuffer[80];
 	double d;
 	int gpsW;
 	double gpsT;
 
-	//MSW especific!!
-	_set_output_format(_TWO_DIGIT_EXPONENT);
-
 	//for each satellite observed
-	for (unsigned int i=0; i<gpsEphmNav.size(); i++) {
+	for (map<GPSnavKey, GPSsatNav>::iterator it = gpsEphmNav.begin(); it != gpsEphmNav.end(); ++it) {
+		const GPSsatNav& nav = it->second;
 		//print epoch 1st line: first the satellite number
-		fprintf(out, "%02d", gpsEphmNav[i].satellite);
+		line.addZeroPaddedInt(nav.satellite, 2);
 		//next the calendar navigation data time (positive data in broadcastOrbit)
-		gpsW = gpsEphmNav[i].broadcastOrbit[5][2];
-		gpsT = gpsEphmNav[i].broadcastOrbit[0][0] * SCALEFACTORS[0][0];
-		formatGPStime (timeBuffer, sizeof timeBuffer, "%y %m %d %H %M", gpsW, gpsT);
- 		fprintf(out, " %s %4.1f", timeBuffer, getGPSseconds(gpsT));
+		gpsW = nav.broadcastOrbit[5][2];
+		gpsT = nav.broadcastOrbit[0][0] * SCALEFACTORS[0][0];
+		calendar.format(timeBuffer, sizeof timeBuffer, "%y %m %d %H %M", gpsW, gpsT);
+		line.addChars(' ', 1);
+		line.addText(timeBuffer);
+		line.addChars(' ', 1);
+		line.addFixed(getGPSseconds(gpsT), 4, 1);
 		for (int k=1; k<4; k++)	//finally the Af0, 1 & 2 values (signed data)
-			fprintf(out, "%19.12E", ((int) gpsEphmNav[i].broadcastOrbit[0][k]) * SCALEFACTORS[0][k]);
-		fprintf(out, "\n");
+			line.addExp(((int) nav.broadcastOrbit[0][k]) * SCALEFACTORS[0][k], 19, 12);
+		line.addText("\n");
+		line.write(out);
 		//print the other seven broadcast orbit data lines
 		for (int j=1; j<8; j++) {
-			fprintf(out, "   ");
+			line.addChars(' ', 3);
 			for (int k=0; k<4; k++) {
 				//analyse special cases and do casting and assignement accordingly
 				if (j==7 && k==2) break;	//do not print spares in last line
 				if (j==7 && k==1) {			//compute the Fit Interval from fit flag
-					if (gpsEphmNav[i].broadcastOrbit[7][1] == 0) d = 4.0;
+					if (nav.broadcastOrbit[7][1] == 0) d = 4.0;
 					else {
-						int iodc = gpsEphmNav[i].broadcastOrbit[6][3];
+						int iodc = nav.broadcastOrbit[6][3];
 						if (iodc>=240 && iodc<=247) d = 8.0;
 						else if (iodc>=248 && iodc<=255) d = 14.0;
 						else if (iodc==496) d = 14.0;
@@ -651,14 +790,15 @@ void RinexData::printGPSnavEpoch(FILE* out) {
 						else d = 6.0;
 					}
 				} else if (j==6 && k==0)	//compute User Range Accuracy value
-						d = URA[gpsEphmNav[i].broadcastOrbit[6][0]];
+						d = URA[nav.broadcastOrbit[6][0]];
 				else if (j==2 && (k==1 || k==3))	//e and sqrt(A) are 32 bits unsigned
-					d = gpsEphmNav[i].broadcastOrbit[j][k] * SCALEFACTORS[j][k];
+					d = nav.broadcastOrbit[j][k] * SCALEFACTORS[j][k];
 					//the rest signed, or unsigned but with less than 32 bits
-				else d = ((int) gpsEphmNav[i].broadcastOrbit[j][k]) * SCALEFACTORS[j][k];
-				fprintf(out, "%19.12E", d);
+				else d = ((int) nav.broadcastOrbit[j][k]) * SCALEFACTORS[j][k];
+				line.addExp(d, 19, 12);
 			}
-			fprintf(out, "\n");
+			line.addText("\n");
+			line.write(out);
 		}
 	}
 }
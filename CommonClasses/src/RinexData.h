@@ -20,6 +20,12 @@
 #pragma once
 
 #include <vector>
+#include <map>
+
+//from CommonClasses
+#include "RinexLine.h"
+#include "OutputSink.h"
+#include "GPSCalendar.h"
 
 using namespace std;
 
@@ -36,21 +42,18 @@ const double L1WLINV = L1CFREQ / LSPEED; //the inverse of L1 wave length
 const double ThisPI = 3.1415926535898;
 const double MAXOBSVAL = 9999999999.999; //the maximum value for any observable to fit the F14.4 RINEX format
 const double MINOBSVAL = -999999999.999; //the minimum value for any observable to fit the F14.4 RINEX format
+const int MAXOBSPRN = 256;	//the epoch buffer has room for satellites with PRN from 0 to MAXOBSPRN-1
+const unsigned int MAXOBSTYPES = 32;	//the maximum number of observation types per system in the epoch buffer (bits in a mask)
 
 //data types
 enum RINEXversion {V210, V300};
 //internal classes
-//SatObsData defines data for a satellite observation (pseudorrange, phase, ...) in one epoch.
-struct SatObsData {	
-	int sysIndex;		//the index inside a GNSSsystem vector of the system this observation belongs
-	int satellite;		//the satellite PRN this observation belongs
-	double epochTime;	//the epoch time for this observation according to the receiver (before solution)
-	int obsTypeIndex;	//the index in obsType vector inside GNSSsystem of the observation type
+//ObsSlot defines data for a satellite observation (pseudorrange, phase, ...) in the epoch buffer.
+//The system, satellite and observation type it belongs are given by its position in the buffer.
+struct ObsSlot {
  	double obsValue;	//the value of this observation
 	int lossOfLock;		//if loss of lock happened when observation was taken
 	int strength;		//the signal strength when observation was taken
-
-	SatObsData (int, int, double, int, double, int, int);
 };
 //GPSsatNav used to define storage for navigation data for a given GPS satellite
 struct GPSsatNav {
@@ -59,6 +62,17 @@ struct GPSsatNav {
 
 	GPSsatNav(int, unsigned int [8][4]);
 };
+//GPSnavKey identifies navigation data of a GPS satellite: the week and Toc of their epoch, the satellite PRN and the IODE.
+//Keys are ordered by epoch and satellite
+struct GPSnavKey {
+	unsigned int week;	//the GPS week (broadcastOrbit[5][2])
+	unsigned int toc;	//the Toc, not scaled (broadcastOrbit[0][0])
+	int satellite;		//the PRN of the satellite
+	unsigned int iode;	//the IODE (broadcastOrbit[1][0])
+
+	GPSnavKey(int, unsigned int [8][4]);
+	bool operator<(const GPSnavKey&) const;
+};
 //@endcond 
 /**GNSSsystem defines data for each GNSS system that can provide data to the RINEX file.
  *
@@ -67,8 +81,28 @@ struct GNSSsystem {
 	char system;				///<system identification: G, R, S, E ... (see RINEX document)
 	vector <string> obsType;	///<identifier of each obsType type: C1C, L1C, D1C, S1C... (see RINEX document)
 	vector <double> biasFactor;	///<a factor to apply bias to observations, like speed of light for pseudoranges, carrier frequency for phase 
+	vector <int> obsSlot;		///<for each observation type ID (see getObsTypeId), its index in obsType, or -1 if not in this system
 
 	GNSSsystem (char sys, vector <string> obsT);
+	int getObsSlot(int);
+	static int getObsTypeId(const string&);
+};
+
+/**ObsColumns defines measurement data of several satellites in an epoch arranged in columns (structure of arrays),
+ * to be stored at once using RinexData::addMeasurements.
+ * Each satellite measured is a row, having an element in each column. For each observable type there is a column
+ * of values and a column of signal strengths.
+ */
+struct ObsColumns {
+	vector <int> obsType;		///<the IDs (see GNSSsystem::getObsTypeId) of the observable types given (C1C, L1C...), at most 32
+	vector <char> system;		///<the system identification of each satellite (G, S, ...)
+	vector <int> satellite;		///<the PRN of each satellite
+	vector <double> timeTag;	///<the time when measurements were made for each satellite
+	vector <unsigned int> present;	///<for each satellite, the bit i is set when it has a value for obsType[i]
+	vector < vector <double> > value;	///<for each observable type, the values for each satellite
+	vector < vector <int> > strength;	///<for each observable type, the signal strength for each satellite
+
+	void resize(unsigned int);
 };
 
 /**RinexData class defines a data container for the RINEX file data and the parameters to be used to generate it.
@@ -109,6 +143,8 @@ class RinexData {
 	int firstObsWeek;	//Time of the first observation
 	double firstObsTOW;
 	float obsInterval;
+	bool firstObsSet;	//if the time of the first observation has been set
+	bool intervalSet;	//if the observation interval has been set
 	//Generation parameters
 	int gpsWeek;		//Extended (0 to NO LIMIT) GPS week number of current epoch). From MID7
 	double gpsTOW;		//Seconds into the current week, accounting for clock bias, when the current measurement was made. From MID7
@@ -117,13 +153,22 @@ class RinexData {
 	bool applyBias;			//if the receiver clock bias shall be applied to observations and time
 	int epochFlag;			//see RINEX definition
 	vector <GNSSsystem> systems;
-	vector <SatObsData> observations;
-	vector <GPSsatNav> gpsEphmNav;
+	//the epoch buffer: a slot for each system, satellite and observation type, in the order they are printed
+	vector <ObsSlot> epochObs;
+	vector <unsigned int> epochSysBase;	//for each system, the index in epochObs of the slot for satellite 0 and observation type 0
+	vector <unsigned int> obsPresent;	//for each system and satellite, the bit i is set when the slot of observation type i has a value
+	unsigned int nEpochObs;	//the number of values stored in the epoch buffer
+	int systemIndex[256];	//for each system identification (G, S, ...), its index in systems, or -1 if not there
+	RinexLine line;			//the buffer where epoch lines are formatted
+	GPSCalendar calendar;	//to convert GPS times of epochs to calendar data
+	map <GPSnavKey, GPSsatNav> gpsEphmNav;	//navigation data stored, ordered by epoch and satellite
 	bool appEnd;			//if end of file comment will be appended or not
 	double SCALEFACTORS[8][4];	//the scale factors to apply to obtain broadcast orbit data
 	double URA[16];
 
 	string getRINEXfileName(string designator, int week, int sec, char ftype);
+	void storeObs(int, int, int, double, int, int);
+	void printSatObsValues(OutputSink*, int, int);
 
 public:
 	RinexData(string, string, string, string, string, string, string, string, string, bool, bool, vector <GNSSsystem>);
@@ -132,17 +177,22 @@ public:
 	void setReceiver(string, string, string, int, int);
 	void setGPSTime(int, double, double);
 	double getGPSTime ();
+	double getEpochTimeTag ();
+	void setEpochTimeTag (double);
 	string getObsFileName(string ); 
 	string getGPSnavFileName(string );
 	void setFistObsTime();
 	void setIntervalTime(int, double);
-	bool addMeasurement (char, int, string, double, int, int, double);
+	void setIntervalTime();
+	bool hasObsTimes();
+	bool addMeasurement (char, int, int, double, int, int, double);
+	void addMeasurements (ObsColumns&);
+	bool isSameEpoch (double);
 	bool addGPSNavData (int, unsigned int [8][4]);
 	void clearObs();
-	void printObsHeader(FILE* out);
-	void printObsEpoch(FILE* out);
-	bool printSatObsValues(FILE* out);
-	void printObsEOF(FILE* out);
-	void printGPSnavHeader(FILE* out);
-	void printGPSnavEpoch(FILE* out);
+	void printObsHeader(OutputSink* out);
+	void printObsEpoch(OutputSink* out);
+	void printObsEOF(OutputSink* out);
+	void printGPSnavHeader(OutputSink* out);
+	void printGPSnavEpoch(OutputSink* out);
 };
@@ -0,0 +1,253 @@
+/** @file RinexLine.cpp
+ * Contains the implementation of the RinexLine class.
+ */
+
+#include "RinexLine.h"
+
+#include <string.h>
+#include <float.h>
+#include <locale.h>
+#include <cmath>
+
+//@cond DUMMY
+//the powers of ten exactly representable as doubles
+static const double POW10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+#define MAXPOW10 22
+//the maximum scaled value rounded to an integer, small enough to have fractional bits
+#define MAXSCALED 1e15
+//the maximum number of digits after the decimal point in exponential format (the mantissa shall be less than MAXSCALED)
+#define MAXEXPDECIMALS 13
+//the relative distance to a rounding tie under which the scaled value cannot be trusted to round as printf does
+#define TIETOLERANCE 4e-15
+//the maximum size of a formatted numeric field
+#define MAXFIELDSIZE 400
+
+//computes a * 10^k with at most two rounding errors. Returns false if it cannot be done so
+static bool scale(double a, int k, double& result) {
+	if (k > 2 * MAXPOW10 || k < -MAXPOW10) return false;
+	if (k > MAXPOW10) result = a * POW10[MAXPOW10] * POW10[k - MAXPOW10];
+	else if (k >= 0) result = a * POW10[k];
+	else result = a / POW10[-k];
+	return true;
+}
+
+//tells if the scaled value is so close to a rounding tie that its rounding is not reliable
+static bool nearTie(double scaled) {
+	return fabs(scaled - floor(scaled) - 0.5) <= scaled * TIETOLERANCE;
+}
+//@endcond
+
+/**Constructs an empty RinexLine object.
+ */
+RinexLine::RinexLine(void) {
+	buffer.resize(RXLINESIZE);
+	length = 0;
+}
+
+/**Destructs a RinexLine object.
+ */
+RinexLine::~RinexLine(void) {
+}
+
+/**reserve makes room in the buffer for the given number of characters after the current line.
+ *
+ * @param n the number of characters to add
+ * @return the place in the buffer where characters shall be added
+ */
+char* RinexLine::reserve(unsigned int n) {
+	if (length + n > buffer.size()) buffer.resize(2 * (length + n));
+	return &buffer[length];
+}
+
+/**addDigits adds the given text of a number, preceded by its sign and by spaces to fill the field width.
+ *
+ * @param text the text of the number, without sign
+ * @param n the number of characters in text
+ * @param negative true if a minus sign shall precede the text
+ * @param width the minimum width of the field
+ */
+void RinexLine::addDigits(const char* text, unsigned int n, bool negative, int width) {
+	unsigned int size = n + (negative? 1: 0);
+	unsigned int spaces = width > (int) size? width - size: 0;
+	char* p = reserve(spaces + size);
+	memset(p, ' ', spaces);
+	p += spaces;
+	if (negative) *p++ = '-';
+	memcpy(p, text, n);
+	length += spaces + size;
+}
+
+/**addSnprintf adds a numeric field formatted by the C library using snprintf, for values not formatted by this class.
+ * The decimal point of the current locale, if not a dot, is replaced by a dot, and exponents having three digits
+ * when two are enough (as given by MSVC) are shortened, to give the same text in any locale and platform.
+ *
+ * @param value the value to format
+ * @param width the minimum width of the field
+ * @param decimals the number of digits after the decimal point
+ * @param conversion the printf conversion: 'f' or 'E'
+ */
+void RinexLine::addSnprintf(double value, int width, int decimals, char conversion) {
+	char text[MAXFIELDSIZE];
+	if (decimals > MAXPOW10) decimals = MAXPOW10;
+	snprintf(text, sizeof text, conversion == 'E'? "%.*E": "%.*f", decimals, value);
+	const char* point = localeconv()->decimal_point;
+	char* localePoint;
+	if (strcmp(point, ".") != 0 && *point != 0 && (localePoint = strstr(text, point)) != NULL) {
+		*localePoint = '.';
+		memmove(localePoint + 1, localePoint + strlen(point), strlen(localePoint + strlen(point)) + 1);
+	}
+	char* exponent = strchr(text, 'E');
+	if (exponent != NULL && strlen(exponent) == 5 && exponent[2] == '0') memmove(exponent + 2, exponent + 3, 3);
+	addDigits(text, (unsigned int) strlen(text), false, width);
+}
+
+/**clear empties the line.
+ */
+void RinexLine::clear() {
+	length = 0;
+}
+
+/**addText adds the given text.
+ *
+ * @param text the text to add
+ */
+void RinexLine::addText(const char* text) {
+	unsigned int n = (unsigned int) strlen(text);
+	memcpy(reserve(n), text, n);
+	length += n;
+}
+
+/**addChars adds a character repeated the given number of times, like the printf conversion "%nc" does for spaces.
+ *
+ * @param c the character to add
+ * @param n the number of times to add it
+ */
+void RinexLine::addChars(char c, int n) {
+	if (n <= 0) return;
+	memset(reserve(n), c, n);
+	length += n;
+}
+
+/**addInt adds an integer right justified in a field of the given width (RINEX In format), as "%nd" does.
+ *
+ * @param value the value to add
+ * @param width the minimum width of the field
+ */
+void RinexLine::addInt(int value, int width) {
+	char digits[16];
+	char* p = digits + sizeof digits;
+	unsigned int n = value < 0? 0u - (unsigned int) value: value;
+	do {
+		*--p = '0' + n % 10;
+		n /= 10;
+	} while (n != 0);
+	addDigits(p, (unsigned int) (digits + sizeof digits - p), value < 0, width);
+}
+
+/**addZeroPaddedInt adds an integer filled with zeros to the given width, as "%0nd" does (f.e. satellite numbers).
+ *
+ * @param value the value to add
+ * @param width the minimum width of the field, including the sign
+ */
+void RinexLine::addZeroPaddedInt(int value, int width) {
+	char digits[48];
+	char* p = digits + sizeof digits;
+	unsigned int n = value < 0? 0u - (unsigned int) value: value;
+	int minDigits = value < 0? width - 1: width;
+	if (minDigits > 32) minDigits = 32;
+	do {
+		*--p = '0' + n % 10;
+		n /= 10;
+		minDigits--;
+	} while (n != 0 || minDigits > 0);
+	addDigits(p, (unsigned int) (digits + sizeof digits - p), value < 0, width);
+}
+
+/**addFixed adds a value in fixed point format right justified in a field of the given width (RINEX Fw.d format),
+ * as "%w.df" does.
+ *
+ * @param value the value to add
+ * @param width the minimum width of the field
+ * @param decimals the number of digits after the decimal point
+ */
+void RinexLine::addFixed(double value, int width, int decimals) {
+	double a = fabs(value);
+	double scaled;
+	if (decimals < 0 || decimals > MAXPOW10 || !scale(a, decimals, scaled) || !(scaled < MAXSCALED) || nearTie(scaled)) {
+		addSnprintf(value, width, decimals, 'f');
+		return;
+	}
+	unsigned long long n = (unsigned long long) floor(scaled + 0.5);
+	char digits[48];
+	char* p = digits + sizeof digits;
+	for (int i=0; i<decimals; i++) {
+		*--p = '0' + n % 10;
+		n /= 10;
+	}
+	if (decimals > 0) *--p = '.';
+	do {
+		*--p = '0' + n % 10;
+		n /= 10;
+	} while (n != 0);
+	addDigits(p, (unsigned int) (digits + sizeof digits - p), signbit(value), width);
+}
+
+/**addExp adds a value in exponential format right justified in a field of the given width (RINEX Dw.d format, but
+ * using the E letter), as "%w.dE" does. The exponent has at least two digits.
+ *
+ * @param value the value to add
+ * @param width the minimum width of the field
+ * @param decimals the number of digits after the decimal point
+ */
+void RinexLine::addExp(double value, int width, int decimals) {
+	double a = fabs(value);
+	int exponent = 0;
+	unsigned long long n = 0;
+	if (decimals < 0 || decimals > MAXEXPDECIMALS || !(a <= DBL_MAX)) {
+		addSnprintf(value, width, decimals, 'E');
+		return;
+	}
+	if (a != 0.0) {
+		//scale the value to have decimals+1 digits in its integer part, correcting the exponent if log10 missed it
+		double scaled;
+		exponent = (int) floor(log10(a));
+		bool scaleOK = scale(a, decimals - exponent, scaled);
+		if (scaleOK && scaled >= POW10[decimals + 1]) scaleOK = scale(a, decimals - ++exponent, scaled);
+		else if (scaleOK && scaled < POW10[decimals]) scaleOK = scale(a, decimals - --exponent, scaled);
+		if (!scaleOK || scaled < POW10[decimals] || scaled >= POW10[decimals + 1] || nearTie(scaled)) {
+			addSnprintf(value, width, decimals, 'E');
+			return;
+		}
+		n = (unsigned long long) floor(scaled + 0.5);
+		if (n >= (unsigned long long) POW10[decimals + 1]) {	//rounding gives one more digit, as 9.99..96 to 10.00..0
+			n /= 10;
+			exponent++;
+		}
+	}
+	char digits[48];
+	char* p = digits + sizeof digits;
+	unsigned int e = exponent < 0? -exponent: exponent;
+	do {
+		*--p = '0' + e % 10;
+		e /= 10;
+	} while (e != 0 || p > digits + sizeof digits - 2);
+	*--p = exponent < 0? '-': '+';
+	*--p = 'E';
+	for (int i=0; i<decimals; i++) {
+		*--p = '0' + n % 10;
+		n /= 10;
+	}
+	if (decimals > 0) *--p = '.';
+	*--p = '0' + (char) n;
+	addDigits(p, (unsigned int) (digits + sizeof digits - p), signbit(value), width);
+}
+
+/**write writes the line to the given OutputSink and clears it. The line terminator shall be added before.
+ *
+ * @param out the OutputSink where the line is written
+ */
+void RinexLine::write(OutputSink* out) {
+	if (length > 0) out->write(&buffer[0], length);
+	length = 0;
+}
@@ -0,0 +1,61 @@
+/** @file RinexLine.h
+ * Contains the definition of the RinexLine class, used to format the fields of RINEX file lines.
+ *
+ *Copyright 2015 Francisco Cancillo
+ *<p>
+ *This file is part of the RXtoRINEX tool.
+ *<p>
+ *RXtoRINEX is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *RXtoRINEX is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ *warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *See the GNU General Public License for more details.
+ *<p>
+ *A copy of the GNU General Public License can be found at <http://www.gnu.org/licenses/>.
+ *
+ *V1.0	First release
+ */
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+
+//from CommonClasses
+#include "OutputSink.h"
+
+using namespace std;
+
+///The initial size in bytes of the line buffer. It grows when needed
+#define RXLINESIZE 256
+
+/**RinexLine class provides a line buffer where the fields of a RINEX line are formatted one after another, and a method
+ * to write the line to an OutputSink.
+ *<p>
+ * Numeric fields are formatted as the printf conversions used formerly to print them (%14.3f for F14.3, %19.12E for D19.12,
+ * %3d for I3, etc.), producing the same text, but without parsing a format string for each value.
+ * Formatting does not depend on the locale and exponents have at least two digits in any platform (MSVC printf
+ * gives three digits unless _set_output_format is used).
+ *<p>
+ * Fixed point values are rounded from their value scaled to an integer. When the scaled value is too close to a
+ * rounding tie to be sure of the result, or it is too large, the value is formatted using snprintf.
+ */
+class RinexLine {
+	vector<char> buffer;	//the line buffer
+	unsigned int length;	//the number of characters in the line
+
+	char* reserve(unsigned int);
+	void addDigits(const char*, unsigned int, bool, int);
+	void addSnprintf(double, int, int, char);
+
+public:
+	RinexLine(void);
+	~RinexLine(void);
+	void clear();
+	void addText(const char*);
+	void addChars(char, int);
+	void addInt(int, int);
+	void addZeroPaddedInt(int, int);
+	void addFixed(double, int, int);
+	void addExp(double, int, int);
+	void write(OutputSink*);
+};
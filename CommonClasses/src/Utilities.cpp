@@ -3,6 +3,15 @@
  */
 #include "Utilities.h"
 
+//from CommonClasses
+#include "GPSCalendar.h"
+#include "LocalTime.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
 /**getTokens gets tokens from a string separated by the given separator
  *
  * @param source a string to be split into tokens
@@ -19,7 +28,8 @@ vector<string> getTokens (string source, char separator) {
 }
 
 /**formatGPStime gives text GPS calendar data using the format provided (as per strftime). 
- * Note that seconds, if given, is an integer number (as per strftime)
+ * Note that seconds, if given, is an integer number (as per strftime).
+ * Printers formatting many times should use their own GPSCalendar, to keep the date computed for the day.
  *
  * @param buffer the text buffer where calendar data are placed
  * @param bufferSize of the text buffer in bytes
@@ -28,20 +38,8 @@ vector<string> getTokens (string source, char separator) {
  * @param second the GPS seconds from the beginning of the week
  */
 void formatGPStime (char* buffer, int bufferSize, char* fmt, int week, double second) {
-	//get calendar for the GPS time of this epoch
-	time_t rawtime;
-	struct tm* timeinfo;
-	time (&rawtime);
-	timeinfo = localtime (&rawtime);
-	//set GPS ephemeris 6/1/1980, adding gps time data to get current time
-	timeinfo->tm_year = 80;
-	timeinfo->tm_mon = 0;
-	timeinfo->tm_mday = 6 + week * 7;
-	timeinfo->tm_hour = 0;
-	timeinfo->tm_min = 0;
-	timeinfo->tm_sec = 0 + (int) second;
-	mktime(timeinfo);
-	strftime (buffer, bufferSize, fmt, timeinfo);
+	GPSCalendar calendar;
+	calendar.format(buffer, bufferSize, fmt, week, second);
 }
 
 /**formatLocalTime gives text calendar data of local time using the format provided (as per strftime). 
@@ -53,10 +51,10 @@ void formatGPStime (char* buffer, int bufferSize, char* fmt, int week, double se
 void formatLocalTime (char* buffer, int bufferSize, char* fmt) {
 	//get local time and format it as needed
 	time_t rawtime;
-	struct tm * timeinfo;
+	struct tm timeinfo;
 	time (&rawtime);
-	timeinfo = localtime (&rawtime);
-	strftime (buffer, bufferSize, fmt, timeinfo);
+	LOCALTIME (&rawtime, &timeinfo);
+	strftime (buffer, bufferSize, fmt, &timeinfo);
 }
 
 /**getGPSseconds gets the remaining seconds modulo minute (<60.0 seconds) from the TOW.
@@ -67,3 +65,99 @@ void formatLocalTime (char* buffer, int bufferSize, char* fmt) {
 double getGPSseconds (double tow) {
 	return tow - floor(tow / 60.0) * 60.0;	//return the seconds (allways positive)
 }
+
+/**openBinaryFile opens a binary file for reading or writing.
+ * The name "-" stands for the standard input (when reading) or the standard output (when writing),
+ * which are set in binary mode. It allows the use of pipes between commands.
+ *
+ * @param fileName the name of the file to open, or "-"
+ * @param output true to create the file for writing, false to open it for reading
+ * @return the FILE open, or NULL if it cannot be open
+ */
+FILE* openBinaryFile (string fileName, bool output) {
+	if (fileName.compare("-") == 0) {
+		FILE* stdFile = output? stdout: stdin;
+#ifdef _WIN32
+		_setmode(_fileno(stdFile), _O_BINARY);
+#endif
+		return stdFile;
+	}
+	return fopen(fileName.c_str(), output? "wb": "rb");
+}
+
+/**closeBinaryFile closes a file open with openBinaryFile.
+ * The standard input and output are not closed, but the standard output is flushed.
+ *
+ * @param file the FILE to close
+ */
+void closeBinaryFile (FILE* file) {
+	if (file == stdin) return;
+	if (file == stdout) fflush(file);
+	else fclose(file);
+}
+
+/**getWeekTow extracts the GPS week and TOW from a string with the format WEEK:TOW, where WEEK is the GPS week number
+ * (including rollovers) and TOW the seconds (and fraction) from the week start.
+ *
+ * @param source the string to extract data from
+ * @param week the GPS week extracted
+ * @param tow the GPS TOW extracted, in seconds
+ * @return true if data have been extracted, false if the string has not the expected format or values are out of range
+ */
+bool getWeekTow (string source, int& week, double& tow) {
+	vector<string> tokens = getTokens(source, ':');
+	if (tokens.size() != 2) return false;
+	try {
+		size_t weekEnd, towEnd;
+		week = stoi(tokens[0], &weekEnd);
+		tow = stod(tokens[1], &towEnd);
+		if (weekEnd != tokens[0].size() || towEnd != tokens[1].size()) return false;
+	} catch (...) {
+		return false;
+	}
+	return week >= 0 && tow >= 0.0 && tow < 604800.0;
+}
+
+/**getInteger extracts an integer number from a string containing only it.
+ *
+ * @param source the string to extract data from
+ * @param value the number extracted
+ * @return true if the number has been extracted, false if the string is not a number or it is out of range
+ */
+bool getInteger (string source, int& value) {
+	try {
+		size_t end;
+		int n = stoi(source, &end);
+		if (end != source.size()) return false;
+		value = n;
+	} catch (...) {
+		return false;
+	}
+	return true;
+}
+
+/**getBlocks extracts the size and number of buffer blocks from a string with the format SIZEKB,COUNT, where SIZEKB is
+ * the block size in kilobytes and COUNT the number of blocks.
+ *
+ * @param source the string to extract data from
+ * @param size the block size extracted, in bytes
+ * @param count the number of blocks extracted
+ * @return true if data have been extracted, false if the string has not the expected format or values are out of range
+ */
+bool getBlocks (string source, unsigned int& size, unsigned int& count) {
+	vector<string> tokens = getTokens(source, ',');
+	if (tokens.size() != 2) return false;
+	int sizeKB, n;
+	try {
+		size_t sizeEnd, countEnd;
+		sizeKB = stoi(tokens[0], &sizeEnd);
+		n = stoi(tokens[1], &countEnd);
+		if (sizeEnd != tokens[0].size() || countEnd != tokens[1].size()) return false;
+	} catch (...) {
+		return false;
+	}
+	if (sizeKB <= 0 || sizeKB > 1048576 || n <= 0 || n > 1024) return false;
+	size = (unsigned int) sizeKB * 1024;
+	count = (unsigned int) n;
+	return true;
+}
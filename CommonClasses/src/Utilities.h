@@ -17,6 +17,7 @@
  */
 #pragma once
 
+#include <stdio.h>
 #include <string>
 #include <sstream>
 #include <vector>
@@ -30,4 +31,9 @@ using namespace std;
 vector<string> getTokens (string source, char separator);			//extract tokens from a string
 void formatLocalTime (char* buffer, int bufferSize, char* fmt);		//format local time
 void formatGPStime (char* buffer, int bufferSize, char* fmt, int week, double second); //format GPS date & time
-double getGPSseconds (double tow); //Get the remaining seconds modulo minute
\ No newline at end of file
+double getGPSseconds (double tow); //Get the remaining seconds modulo minute
+FILE* openBinaryFile (string fileName, bool output);	//open a binary file, or stdin / stdout if its name is "-"
+void closeBinaryFile (FILE* file);	//close a file open with openBinaryFile
+bool getWeekTow (string source, int& week, double& tow);	//extract GPS week and TOW from a WEEK:TOW string
+bool getInteger (string source, int& value);	//extract an integer from a string
+bool getBlocks (string source, unsigned int& size, unsigned int& count);	//extract block size and count from a SIZEKB,COUNT string
\ No newline at end of file